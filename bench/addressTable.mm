@@ -0,0 +1,139 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+// NOTE: Microbenchmark of address (predecessor) searches: the previous
+//       approach (CFArrayBSearchValues() over a reverse-sorted array of
+//       NSNumber objects; OS X only), std::upper_bound() over a sorted array,
+//       and SCAddressTable.
+// NOTE: Build on OS X with the following (on one line):
+//           clang++ -O2 -fno-objc-arc -Iinclude -framework Foundation
+//           bench/addressTable.mm lib/addressTable.mm -o addressTable-bench
+//       or elsewhere (e.g. Linux) with:
+//           c++ -O2 -x c++ -Iinclude
+//           bench/addressTable.mm lib/addressTable.mm -o addressTable-bench
+//       and run with:
+//           ./addressTable-bench [count] [queries]
+
+#ifdef __APPLE__
+#import <Foundation/Foundation.h>
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "addressTable.h"
+
+#include <algorithm>
+#include <vector>
+
+static uint64_t currentNanoseconds() {
+#ifdef __APPLE__
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+static double nanosecondsSince(uint64_t start, size_t count) {
+    return (double)(currentNanoseconds() - start) / count;
+}
+
+#ifdef __APPLE__
+static CFComparisonResult reverseCompareUnsignedLongLong(CFNumberRef a, CFNumberRef b) {
+    unsigned long long aValue;
+    unsigned long long bValue;
+    CFNumberGetValue(a, kCFNumberLongLongType, &aValue);
+    CFNumberGetValue(b, kCFNumberLongLongType, &bValue);
+    if (bValue < aValue) return kCFCompareLessThan;
+    if (bValue > aValue) return kCFCompareGreaterThan;
+    return kCFCompareEqualTo;
+}
+
+static void benchmarkCFArray(const std::vector<uint64_t> &addresses, const std::vector<uint64_t> &queries) {
+    @autoreleasepool {
+        const size_t count = addresses.size();
+        NSMutableArray *numbers = [NSMutableArray arrayWithCapacity:count];
+        for (size_t i = count; i > 0; --i) {
+            [numbers addObject:[NSNumber numberWithUnsignedLongLong:addresses[i - 1]]];
+        }
+
+        uint64_t sum = 0;
+        uint64_t start = currentNanoseconds();
+        for (size_t i = 0; i < queries.size(); ++i) {
+            NSNumber *target = [[NSNumber alloc] initWithUnsignedLongLong:queries[i]];
+            CFIndex index = CFArrayBSearchValues((CFArrayRef)numbers, CFRangeMake(0, count), target, (CFComparatorFunction)reverseCompareUnsignedLongLong, NULL);
+            [target release];
+            if (index < (CFIndex)count) {
+                sum += [[numbers objectAtIndex:index] unsignedLongLongValue];
+            }
+        }
+        printf("CFArrayBSearchValues: %8.1f ns/query (%llx)\n", nanosecondsSince(start, queries.size()), (unsigned long long)sum);
+    }
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    const size_t count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+    const size_t numQueries = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1000000;
+    if ((count == 0) || (numQueries == 0)) {
+        fprintf(stderr, "ERROR: Count and number of queries must be non-zero.\n");
+        return 1;
+    }
+
+    // Create function-like addresses, four to sixty bytes apart.
+    srandom(1);
+    std::vector<uint64_t> addresses(count);
+    uint64_t address = 0x100000000ULL;
+    for (size_t i = 0; i < count; ++i) {
+        address += 4 + (random() % 15) * 4;
+        addresses[i] = address;
+    }
+    std::vector<uint64_t> queries(numQueries);
+    for (size_t i = 0; i < numQueries; ++i) {
+        queries[i] = addresses[0] + ((uint64_t)random() % (address - addresses[0] + 64));
+    }
+
+    // NOTE: Results are summed so that the searches are not optimized out,
+    //       and so that the approaches can be checked against each other.
+#ifdef __APPLE__
+    benchmarkCFArray(addresses, queries);
+#endif
+
+    uint64_t sum = 0;
+    uint64_t start = currentNanoseconds();
+    for (size_t i = 0; i < numQueries; ++i) {
+        size_t index = std::upper_bound(addresses.begin(), addresses.end(), queries[i]) - addresses.begin();
+        if (index != 0) {
+            sum += addresses[index - 1];
+        }
+    }
+    printf("std::upper_bound:     %8.1f ns/query (%llx)\n", nanosecondsSince(start, numQueries), (unsigned long long)sum);
+
+    SCAddressTable *table = SCAddressTable::create(&addresses[0], count);
+    sum = 0;
+    start = currentNanoseconds();
+    for (size_t i = 0; i < numQueries; ++i) {
+        size_t index = table->indexForAddress(queries[i]);
+        if (index < count) {
+            sum += table->addressAtIndex(index);
+        }
+    }
+    printf("SCAddressTable:       %8.1f ns/query (%llx)\n", nanosecondsSince(start, numQueries), (unsigned long long)sum);
+    table->release();
+
+    return 0;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -29,6 +29,7 @@ typedef struct _CSRange {
 } CSRange;
 
 typedef int (^CSSymbolIterator)(CSSymbolRef symbol);
+typedef int (^CSSourceInfoIterator)(CSSourceInfoRef sourceInfo);
 
 typedef struct _CSArchitecture {
     cpu_type_t cpu_type;
@@ -40,11 +41,13 @@ typedef struct _CSArchitecture {
 extern "C" {
     // Allocation-related functions.
     Boolean CSIsNull(CSTypeRef cs);
+    CSTypeRef CSRetain(CSTypeRef cs);
     void CSRelease(CSTypeRef cs);
 
     // CSSourceInfo
     int CSSourceInfoGetLineNumber(CSSourceInfoRef info);
     const char * CSSourceInfoGetPath(CSSourceInfoRef info);
+    CSRange CSSourceInfoGetRange(CSSourceInfoRef info);
 
     // CSSymbolicator
     CSSymbolicatorRef CSSymbolicatorCreateWithPathAndArchitecture(const char *path, CSArchitecture arch);
@@ -62,6 +65,7 @@ extern "C" {
     CSRange CSSymbolGetRange(CSSymbolRef sym);
     Boolean CSSymbolIsObjcMethod(CSSymbolRef sym);
     Boolean CSSymbolIsFunction(CSSymbolRef sym);
+    long CSSymbolForeachSourceInfo(CSSymbolRef sym, CSSourceInfoIterator it);
 }
 
 #endif // SYMBOLICATE_CORESYMBOLICATION_H_
@@ -0,0 +1,49 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "SCBinaryInfo.h"
+
+#include <mach/machine.h>
+#include "CoreSymbolication.h"
+
+class SCAddressTable;
+class SCBinaryState;
+class SCInput;
+class SCMethodTable;
+class SCNameIndex;
+
+// NOTE: Number of symbol address lookups for a binary that are answered by
+//       scanning its function starts, before the symbol address table is built.
+#define SYMBOL_ADDRESS_SCAN_LIMIT 8
+
+// NOTE: These methods are for use by other parts of this library only.
+@interface SCBinaryInfo (Private)
+@property(nonatomic, readonly) cpu_type_t cpuType;
+@property(nonatomic, readonly) cpu_subtype_t cpuSubtype;
+- (CSSymbolOwnerRef)owner;
+// NOTE: The returned table is owned by the binary info object.
+- (SCMethodTable *)methodTable;
+// NOTE: Built on first use. The returned index is owned by the binary info
+//       object.
+- (SCNameIndex *)nameIndex;
+// NOTE: The function starts of the binary (or, if it has none, the addresses
+//       of -symbolAddresses), sorted least to greatest. The returned table is
+//       owned by the binary info object.
+- (SCAddressTable *)symbolAddressTable;
+// NOTE: Returns the greatest symbol address that is less than or equal to the
+//       given address, or zero if there is none.
+- (uint64_t)symbolAddressForAddress:(uint64_t)address;
+// NOTE: Binaries that do not take part in sharing have a private state (see
+//       SCBinaryInfo.xm). The returned state is owned by the binary info object.
+- (SCBinaryState *)sharedState;
+// NOTE: The returned input must be released by the caller.
+- (SCInput *)createInput;
+@end
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -17,6 +17,7 @@
 @property(nonatomic, readonly) uint64_t address;
 @property(nonatomic, readonly) NSString *architecture;
 @property(nonatomic, readonly) uint64_t baseAddress;
+@property(nonatomic, readonly) NSData *data;
 @property(nonatomic, readonly, getter = isEncrypted) BOOL encrypted;
 @property(nonatomic, readonly, getter = isExecutable) BOOL executable;
 @property(nonatomic, readonly, getter = isFromSharedCache) BOOL fromSharedCache;
@@ -26,8 +27,13 @@
 @property(nonatomic, readonly) int64_t slide;
 @property(nonatomic, readonly) NSArray *symbolAddresses;
 - (id)initWithPath:(NSString *)path address:(uint64_t)address architecture:(NSString *)architecture uuid:(NSString *)uuid;
+- (id)initWithData:(NSData *)data path:(NSString *)path address:(uint64_t)address architecture:(NSString *)architecture uuid:(NSString *)uuid;
+- (id)initWithBytesNoCopy:(const void *)bytes length:(NSUInteger)length path:(NSString *)path address:(uint64_t)address architecture:(NSString *)architecture uuid:(NSString *)uuid;
 - (SCSymbolInfo *)sourceInfoForAddress:(uint64_t)address;
 - (SCSymbolInfo *)symbolInfoForAddress:(uint64_t)address;
+// NOTE: Reverse lookups; see SCBinaryInfo.xm.
+- (NSArray *)symbolInfosForName:(NSString *)name;
+- (NSArray *)symbolInfosForNamePrefix:(NSString *)prefix;
 @end
 
 /* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,35 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_SCCRASHREPORT_H_
+#define SYMBOLICATE_SCCRASHREPORT_H_
+
+#include "crashReport.h"
+
+@class SCBinaryInfo;
+
+// NOTE: Adapts the results of the crash report parsers (see crashReport.h and
+//       ipsReport.h) to the Objective-C interface of the library.
+
+// NOTE: Returns an autoreleased string; the view must hold UTF-8.
+NSString *stringForView(const SCStringView &view);
+
+// NOTE: SCBinaryInfo expects the form used by text crash reports: lowercase,
+//       not hyphenated, and enclosed in "<>". The JSON format uses the
+//       hyphenated form. Returns nil if the view does not hold 32 hexadecimal
+//       digits.
+NSString *uuidForView(const SCStringView &view);
+
+// NOTE: Returns nil if the image lacks a path or a valid UUID. The returned
+//       object must be released by the caller.
+SCBinaryInfo *SCBinaryInfoCreateForReportImage(const SCStringView &path, uint64_t address, const SCStringView &architecture, const SCStringView &uuid);
+
+#endif // SYMBOLICATE_SCCRASHREPORT_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -12,12 +12,25 @@ typedef struct _SCAddressRange {
     uint64_t length;
 } SCAddressRange;
 
+// NOTE: A symbolication result that can be returned without allocating. The
+//       strings are owned by the binary that the address belongs to, and
+//       remain valid while an SCBinaryInfo object for that binary exists.
+//       Either string may be NULL.
+typedef struct _SCSymbolResult {
+    SCAddressRange addressRange;
+    uint64_t offset;
+    const char *name;
+    const char *sourcePath;
+    unsigned sourceLineNumber;
+} SCSymbolResult;
+
 @interface SCSymbolInfo : NSObject
 @property(nonatomic, copy) NSString *name;
 @property(nonatomic) SCAddressRange addressRange;
 @property(nonatomic) uint64_t offset;
 @property(nonatomic, copy) NSString *sourcePath;
 @property(nonatomic) NSUInteger sourceLineNumber;
+- (id)initWithResult:(const SCSymbolResult *)result;
 @end
 
 /* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
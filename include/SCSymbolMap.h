@@ -0,0 +1,21 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+// NOTE: A user-supplied symbol map (a dictionary of NSNumber addresses to
+//       NSString names), compiled into a sorted address array with a parallel
+//       array of names.
+@interface SCSymbolMap : NSObject
+@property(nonatomic, readonly) NSUInteger count;
+- (id)initWithDictionary:(NSDictionary *)dictionary;
+// NOTE: Returns the name of the symbol with the greatest address that is less
+//       than (and not equal to) the given address, or nil if there is none.
+- (NSString *)nameForAddress:(uint64_t)address symbolAddress:(uint64_t *)symbolAddress;
+@end
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,46 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "SCSymbolInfo.h"
+
+@class SCBinaryInfo;
+
+// NOTE: The settings for symbolicating the addresses of one device (e.g. of
+//       one crash log). Contexts are immutable, and so a context may be used
+//       from several threads at once; different contexts may be used at the
+//       same time as well.
+// NOTE: Parsed binary state (see registry.h) is shared by all contexts. Each
+//       context has its own cache of results.
+// NOTE: A binary info object should only be used from one thread at a time.
+@interface SCSymbolicationContext : NSObject
+@property(nonatomic, readonly) NSString *architecture;
+@property(nonatomic, readonly) NSDictionary *symbolMaps;
+@property(nonatomic, readonly) NSString *systemRoot;
+@property(nonatomic, readonly) NSString *sharedCachePath;
+@property(nonatomic, readonly) uint64_t cacheHits;
+@property(nonatomic, readonly) uint64_t cacheMisses;
+// NOTE: A nil architecture or system root selects the default ("armv7" and
+//       "/", respectively).
+- (id)initWithArchitecture:(NSString *)architecture systemRoot:(NSString *)systemRoot symbolMaps:(NSDictionary *)symbolMaps;
+- (SCSymbolInfo *)symbolInfoForAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo;
+- (NSArray *)symbolInfosForAddresses:(NSArray *)addresses inBinaries:(NSArray *)binaryInfos;
+// NOTE: As above, but without creating objects (except when a result is not
+//       yet cached). Returns NO, and a result with neither a name nor a source
+//       path, if the address could not be symbolicated.
+- (BOOL)getResult:(SCSymbolResult *)result forAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo;
+// NOTE: Binaries may be nil for addresses with no known binary.
+- (void)getResults:(SCSymbolResult *)results forAddresses:(const uint64_t *)addresses inBinaries:(SCBinaryInfo * const *)binaryInfos count:(NSUInteger)count;
+// NOTE: Reverse lookups for a dylib in the shared cache, by path (e.g.
+//       "/usr/lib/libobjc.A.dylib"). See -[SCBinaryInfo symbolInfosForName:];
+//       addresses are those in the shared cache, without any slide.
+- (NSArray *)symbolInfosForName:(NSString *)name inSharedCacheDylib:(NSString *)dylibPath;
+- (NSArray *)symbolInfosForNamePrefix:(NSString *)prefix inSharedCacheDylib:(NSString *)dylibPath;
+@end
+
+/* vim: set ft=objc ff=unix sw=4 ts=4 tw=80 expandtab: */
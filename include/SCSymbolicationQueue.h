@@ -0,0 +1,48 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include <dispatch/dispatch.h>
+
+@class SCSymbolicationContext;
+
+// NOTE: The array is as returned by
+//       -[SCSymbolicationContext symbolInfosForAddresses:inBinaries:].
+typedef void (^SCSymbolicationCompletionHandler)(NSArray *symbolInfos);
+
+// NOTE: Symbolicates requests in the background. Each request is a set of
+//       addresses (e.g. the frames of a crash log) and the binaries that they
+//       belong to, along with the context to symbolicate them with.
+// NOTE: The binaries of a request are loaded concurrently, so that waiting for
+//       one binary to be read overlaps with parsing and searching another.
+// NOTE: The number of requests that have been submitted but not yet finished
+//       is bounded; a submission waits (up to the given timeout) for a request
+//       to finish when the bound is reached.
+// NOTE: The binary info objects of a request must not be used elsewhere until
+//       the completion handler has been called.
+@interface SCSymbolicationQueue : NSObject
+@property(nonatomic, readonly) NSUInteger maxPendingRequests;
+@property(nonatomic, readonly) NSUInteger pendingRequests;
+- (id)initWithMaxPendingRequests:(NSUInteger)maxPendingRequests;
+// NOTE: Returns NO (and does not call the completion handler) if the request
+//       could not be queued before the timeout; DISPATCH_TIME_NOW never waits,
+//       and DISPATCH_TIME_FOREVER always succeeds. If the completion queue is
+//       NULL, the handler is called on a global queue.
+- (BOOL)submitAddresses:(NSArray *)addresses inBinaries:(NSArray *)binaryInfos context:(SCSymbolicationContext *)context timeout:(dispatch_time_t)timeout completionQueue:(dispatch_queue_t)completionQueue completionHandler:(SCSymbolicationCompletionHandler)completionHandler;
+// NOTE: Submits the frames of a crash report, in either the text or the JSON
+//       (.ips) format, in the order in which they appear in the report. Binary
+//       info objects are created for the listed binary images; frames that do
+//       not belong to a listed image have no binary (NSNull).
+// NOTE: The report is parsed before returning, and so may be reused. Returns
+//       NO if it could not be parsed, or as above.
+- (BOOL)submitCrashReport:(NSData *)report context:(SCSymbolicationContext *)context timeout:(dispatch_time_t)timeout completionQueue:(dispatch_queue_t)completionQueue completionHandler:(SCSymbolicationCompletionHandler)completionHandler;
+// NOTE: Waits for all submitted requests, including their completion handlers.
+- (void)waitUntilAllRequestsAreFinished;
+@end
+
+/* vim: set ft=objc ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -8,6 +8,7 @@
  */
 
 @class SCBinaryInfo;
+@class SCSymbolicationContext;
 @class SCSymbolInfo;
 @class VMUMemory_File;
 
@@ -16,8 +17,15 @@
 @property(nonatomic, copy) NSDictionary *symbolMaps;
 @property(nonatomic, copy) NSString *systemRoot;
 @property(nonatomic, readonly) NSString *sharedCachePath;
+@property(nonatomic, readonly) uint64_t cacheHits;
+@property(nonatomic, readonly) uint64_t cacheMisses;
 + (SCSymbolicator *)sharedInstance;
+// NOTE: Returns a context with the current settings. To symbolicate for
+//       several devices at once, create a context for each instead of changing
+//       the settings of the symbolicator (see SCSymbolicationContext.h).
+- (SCSymbolicationContext *)context;
 - (SCSymbolInfo *)symbolInfoForAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo;
+- (NSArray *)symbolInfosForAddresses:(NSArray *)addresses inBinaries:(NSArray *)binaryInfos;
 @end
 
 /* vim: set ft=objc ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,108 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_ADDRESSTABLE_H_
+#define SYMBOLICATE_ADDRESSTABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+
+// NOTE: A sorted set of addresses for predecessor searches (e.g. for finding
+//       the function or method that contains an address).
+// NOTE: The addresses are stored only in Eytzinger (breadth-first) order, in
+//       which the first levels of the search share a few cache lines, and the
+//       next levels can be prefetched. The search loop does not branch on the
+//       comparison. Indexes are those of the sorted order, and are mapped to
+//       positions in the layout (see layoutIndex()).
+// NOTE: Tables are immutable, and so may be shared between threads.
+// NOTE: Tables are reference counted; they are created with a count of one.
+class SCAddressTable {
+    public:
+        // NOTE: The addresses must be sorted least to greatest.
+        static SCAddressTable *create(const uint64_t *addresses, size_t count);
+
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        size_t count() const { return count_; }
+        uint64_t addressAtIndex(size_t index) const { return keys_[layoutIndex(index)]; }
+
+        // NOTE: Returns the index of the greatest address that is less than or
+        //       equal to the given address, or count() if there is none.
+        size_t indexForAddress(uint64_t address) const {
+            const size_t index = upperBound(address);
+            return (index != 0) ? (index - 1) : count();
+        }
+
+        // NOTE: As above, but for the greatest address that is strictly less
+        //       than the given address.
+        size_t indexBeforeAddress(uint64_t address) const {
+            const size_t index = lowerBound(address);
+            return (index != 0) ? (index - 1) : count();
+        }
+
+        // NOTE: Equivalent to std::lower_bound() and std::upper_bound(),
+        //       returning an index in the sorted order.
+        size_t lowerBound(uint64_t address) const;
+        size_t upperBound(uint64_t address) const;
+
+        size_t memoryUsage() const;
+
+    private:
+        SCAddressTable() : refCount_(1), count_(0), depth_(0), lastLevelCount_(0), keys_(NULL) {}
+        ~SCAddressTable();
+        SCAddressTable(const SCAddressTable &);
+        SCAddressTable &operator=(const SCAddressTable &);
+
+        size_t layoutIndex(size_t index) const;
+
+        volatile int32_t refCount_;
+        size_t count_;
+        // NOTE: The number of levels of the tree, and the number of nodes on
+        //       its last (possibly incomplete) level.
+        unsigned depth_;
+        size_t lastLevelCount_;
+        // NOTE: The layout is indexed from one; keys_[0] is unused. Each entry
+        //       in ranks_ is the index of the key in the sorted order.
+        // NOTE: The keys are aligned to a cache line (see lowerBound()).
+        uint64_t *keys_;
+        std::vector<uint32_t> ranks_;
+};
+
+// NOTE: Answers indexForAddress() for a sequence of addresses in ascending
+//       order (e.g. the sorted addresses of a batch), by galloping forward
+//       from the previous result instead of searching the whole table. An
+//       address lower than the previous one falls back to a full search.
+// NOTE: A cursor without a table has a count of zero.
+// NOTE: The table is not retained; it must outlive the cursor.
+class SCAddressCursor {
+    public:
+        SCAddressCursor(const SCAddressTable *table = NULL) : table_(table), position_(0), address_(0) {}
+
+        const SCAddressTable *table() const { return table_; }
+        size_t count() const { return (table_ != NULL) ? table_->count() : 0; }
+
+        size_t indexForAddress(uint64_t address);
+
+    private:
+        const SCAddressTable *table_;
+        // NOTE: The upper bound of the previous address.
+        size_t position_;
+        uint64_t address_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_ADDRESSTABLE_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
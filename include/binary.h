@@ -16,11 +16,28 @@
 extern "C" {
 #endif
 
+// NOTE: The file path may refer to an entry inside of an archive (see input.h).
 BOOL offsetAndSizeOfBinaryInFile(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size);
 BOOL isEncrypted(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype);
 
+// NOTE: The following functions operate on a buffer that the caller has
+//       already loaded or mapped (e.g. the contents of a fat or thin binary).
+//       The buffer is never copied, and must remain valid for the duration of
+//       the call.
+BOOL offsetAndSizeOfBinaryInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size);
+BOOL isEncryptedInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+BOOL isExecutableInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+uint64_t baseAddressOfBinaryInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+
 #ifdef __cplusplus
 }
+
+class SCInput;
+
+BOOL offsetAndSizeOfBinaryInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size);
+BOOL isEncryptedInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+BOOL isExecutableInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+uint64_t baseAddressOfBinaryInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype);
 #endif
 
 #endif // SYMBOLICATE_BINARY_H_
@@ -0,0 +1,32 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_BREAKPAD_H_
+#define SYMBOLICATE_BREAKPAD_H_
+
+#include <stdio.h>
+
+@class SCBinaryInfo;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// NOTE: These functions write a Breakpad-compatible text symbol file (.sym).
+//       Records are streamed to the file in address order.
+BOOL writeBreakpadSymbolsForBinary(SCBinaryInfo *binaryInfo, FILE *file);
+BOOL writeBreakpadSymbolsForSharedCacheDylib(const char *sharedCachePath, const char *dylibPath, const char *architecture, FILE *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYMBOLICATE_BREAKPAD_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,180 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_CRASHREPORT_H_
+#define SYMBOLICATE_CRASHREPORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+
+// NOTE: A range of characters in the input; not NUL-terminated.
+typedef struct _SCStringView {
+    const char *data;
+    size_t length;
+} SCStringView;
+
+typedef enum {
+    SCCrashEventNone = 0,
+    // "Key: Value" lines outside of any other section (e.g. "Hardware Model",
+    // "OS Version", "Exception Type").
+    SCCrashEventHeaderField,
+    // The start of a backtrace. The thread index is -1 for the "Last Exception
+    // Backtrace".
+    SCCrashEventThread,
+    SCCrashEventFrame,
+    // The start of a thread state section, followed by its registers.
+    SCCrashEventThreadState,
+    SCCrashEventRegister,
+    SCCrashEventBinaryImage
+} SCCrashEventType;
+
+typedef struct _SCCrashHeaderField {
+    SCStringView key;
+    SCStringView value;
+} SCCrashHeaderField;
+
+typedef struct _SCCrashThread {
+    int index;
+    BOOL isCrashed;
+    // NOTE: From a preceding "Thread N name:" line; empty if there is none.
+    SCStringView name;
+} SCCrashThread;
+
+typedef struct _SCCrashFrame {
+    int threadIndex;
+    // NOTE: -1 for frames of an exception backtrace that is given as a list of
+    //       addresses, "(0x... 0x... ...)".
+    int index;
+    uint64_t address;
+    // NOTE: The image name and the text after the address (a symbol name or
+    //       "0x... + offset"); either may be empty.
+    SCStringView imageName;
+    SCStringView symbol;
+} SCCrashFrame;
+
+typedef struct _SCCrashThreadState {
+    int threadIndex;
+    // NOTE: e.g. "ARM Thread State (64-bit)".
+    SCStringView flavor;
+} SCCrashThreadState;
+
+typedef struct _SCCrashRegister {
+    int threadIndex;
+    SCStringView name;
+    uint64_t value;
+} SCCrashRegister;
+
+// NOTE: The fields correspond to the arguments of
+//       -[SCBinaryInfo initWithPath:address:architecture:uuid:]. The UUID does
+//       not include the angle brackets.
+typedef struct _SCCrashBinaryImage {
+    uint64_t address;
+    uint64_t endAddress;
+    SCStringView name;
+    SCStringView architecture;
+    SCStringView uuid;
+    SCStringView path;
+    // NOTE: Marked with '+' (i.e. not part of the OS).
+    BOOL isUserImage;
+} SCCrashBinaryImage;
+
+typedef struct _SCCrashEvent {
+    SCCrashEventType type;
+    union {
+        SCCrashHeaderField headerField;
+        SCCrashThread thread;
+        SCCrashFrame frame;
+        SCCrashThreadState threadState;
+        SCCrashRegister reg;
+        SCCrashBinaryImage binaryImage;
+    };
+} SCCrashEvent;
+
+// NOTE: Parses a crash log in the text format written by ReportCrash, as a
+//       sequence of events in the order that they appear in the log. Strings
+//       are returned as views into the input, which must remain valid for as
+//       long as they are used; nothing is copied or allocated while parsing.
+// NOTE: Lines that are not understood are skipped.
+class SCCrashReportParser {
+    public:
+        SCCrashReportParser(const char *data, size_t length);
+
+        // NOTE: Returns NO once the end of the input has been reached.
+        BOOL next(SCCrashEvent *event);
+
+    private:
+        typedef enum {
+            SCSectionHeader,
+            SCSectionBacktrace,
+            SCSectionThreadState,
+            SCSectionBinaryImages
+        } SCSection;
+
+        BOOL nextLine();
+        BOOL parseLine(SCCrashEvent *event);
+        BOOL parseSectionStart(SCCrashEvent *event);
+        BOOL parseFrame(SCCrashEvent *event);
+        BOOL parseAddressList(SCCrashEvent *event);
+        BOOL parseRegister(SCCrashEvent *event);
+        BOOL parseBinaryImage(SCCrashEvent *event);
+        BOOL parseHeaderField(SCCrashEvent *event);
+
+        const char *p_;
+        const char *end_;
+
+        // NOTE: The unparsed remainder of the current line. Some lines (e.g.
+        //       of registers) produce more than one event.
+        const char *line_;
+        const char *lineEnd_;
+
+        SCSection section_;
+        int threadIndex_;
+        SCStringView threadName_;
+        int threadNameIndex_;
+};
+
+// NOTE: Finds the binary image of a report that contains an address, by the
+//       address ranges of the images; needed for text reports, in which frames
+//       do not refer to images by index. Images are identified by the index
+//       given when they are added.
+// NOTE: Images must all be added before the first lookup.
+class SCCrashImageRanges {
+    public:
+        static const uint32_t kNoImage = UINT32_MAX;
+
+        SCCrashImageRanges() : isSorted_(YES) {}
+
+        void addImage(uint64_t address, uint64_t endAddress, uint32_t index);
+        BOOL isEmpty() const { return ranges_.empty(); }
+
+        // NOTE: Returns kNoImage if no image contains the address.
+        uint32_t imageIndexForAddress(uint64_t address);
+
+    private:
+        typedef struct _SCImageRange {
+            uint64_t address;
+            uint64_t endAddress;
+            uint32_t index;
+        } SCImageRange;
+
+        static bool compareRanges(const SCImageRange &a, const SCImageRange &b);
+
+        std::vector<SCImageRange> ranges_;
+        BOOL isSorted_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_CRASHREPORT_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,103 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_FINGERPRINT_H_
+#define SYMBOLICATE_FINGERPRINT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <pthread.h>
+#include "crashReport.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+// NOTE: Identifies a set of backtraces by the (image UUID, image-relative
+//       offset) of each frame, and so is the same for duplicate crashes in
+//       processes with different slides. Frames without an image are
+//       identified by their address.
+// NOTE: The fingerprint is the sequence itself (16 bytes of UUID and 8 bytes of
+//       offset per frame), not a digest of it, and so two fingerprints are
+//       only equal if the backtraces are.
+class SCBacktraceFingerprint {
+    public:
+        SCBacktraceFingerprint() {}
+
+        // NOTE: The UUID may be in any form (e.g. "<...>", hyphenated); only
+        //       the hexadecimal digits are used. Returns NO, and adds the frame
+        //       by address, if there are not exactly 32 digits.
+        BOOL addFrame(const SCStringView &uuid, uint64_t imageAddress, uint64_t address);
+        void addFrame(uint64_t address);
+        // NOTE: Marks the start of a backtrace, so that moving frames from the
+        //       end of one backtrace to the start of the next changes the
+        //       fingerprint.
+        void addBacktrace(int index);
+
+        uint64_t hash() const;
+        const std::string &key() const { return key_; }
+
+    private:
+        std::string key_;
+};
+
+// NOTE: A bounded cache of values (e.g. symbolicated output), keyed by
+//       fingerprint. When the total size of the keys and values exceeds the
+//       capacity, the least recently used entries are removed.
+// NOTE: The cache is split into shards, each with its own lock, selected by
+//       the hash of the fingerprint.
+// NOTE: Caches are reference counted; they are created with a count of one.
+class SCFingerprintCache {
+    public:
+        // NOTE: The capacity is in bytes.
+        static SCFingerprintCache *create(size_t capacity);
+
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        // NOTE: The value is copied, as the entry may be removed at any time.
+        BOOL lookup(const SCBacktraceFingerprint &fingerprint, std::string &value);
+        void insert(const SCBacktraceFingerprint &fingerprint, const std::string &value);
+
+        uint64_t hits() const { return hits_; }
+        uint64_t misses() const { return misses_; }
+
+    private:
+        typedef struct _SCEntry {
+            std::string value;
+            std::list<const std::string *>::iterator order;
+        } SCEntry;
+
+        typedef struct _SCShard {
+            pthread_mutex_t mutex;
+            std::map<std::string, SCEntry> entries;
+            // NOTE: Keys of the entries, most recently used first.
+            std::list<const std::string *> order;
+            size_t size;
+        } SCShard;
+
+        SCFingerprintCache(size_t capacityPerShard);
+        ~SCFingerprintCache();
+        SCFingerprintCache(const SCFingerprintCache &);
+        SCFingerprintCache &operator=(const SCFingerprintCache &);
+
+        volatile int32_t refCount_;
+        SCShard *shards_;
+        size_t capacityPerShard_;
+        volatile uint64_t hits_;
+        volatile uint64_t misses_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_FINGERPRINT_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,82 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_FIXUPS_H_
+#define SYMBOLICATE_FIXUPS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+#include "image.h"
+
+typedef enum {
+    SCFixupNone = 0,
+    SCFixupRebase,
+    SCFixupBind
+} SCFixupKind;
+
+// NOTE: Decodes the pointers described by LC_DYLD_CHAINED_FIXUPS. In binaries
+//       that use chained fixups, pointers in __DATA are not stored as plain
+//       addresses; each holds either a rebase target or a bind ordinal, plus
+//       the distance to the next pointer in the chain.
+// NOTE: Only the start of each page's chain is kept. A pointer is decoded from
+//       its raw value when looked up, and so the image itself does not need to
+//       be mapped (only the fields that are actually read). Lookups do not
+//       modify the object, and so are safe to perform from multiple threads.
+// NOTE: Only the 64-bit pointer formats (arm64, arm64e and x86_64) are
+//       supported.
+class SCChainedFixups {
+    public:
+        // NOTE: The data is the payload of LC_DYLD_CHAINED_FIXUPS; import names
+        //       point into it, and so it must remain valid for the lifetime of
+        //       the object. The segments must be in load command order.
+        // NOTE: Returns NULL if the data is malformed or unsupported.
+        static SCChainedFixups *create(const uint8_t *data, uint32_t dataSize, const std::vector<SCSegmentInfo> &segments);
+
+        // NOTE: The raw value is the pointer as stored at the given file
+        //       offset. For a rebase, the value is set to the target virtual
+        //       address (without any tag or authentication bits); for a bind,
+        //       it is set to the import ordinal.
+        SCFixupKind fixupAtOffset(uint64_t offset, uint64_t raw, uint64_t *value) const;
+
+        // NOTE: Returns NULL if the ordinal is invalid, or if names are not
+        //       available.
+        const char *importName(uint64_t ordinal) const;
+
+    private:
+        SCChainedFixups() : baseAddress_(0) {}
+        BOOL parseImports(const uint8_t *data, uint32_t dataSize);
+        BOOL parseStarts(const uint8_t *data, uint32_t dataSize, const std::vector<SCSegmentInfo> &segments);
+
+        typedef struct _SCFixupSegment {
+            uint64_t fileoff;
+            uint64_t filesize;
+            uint16_t pageSize;
+            uint16_t pointerFormat;
+            uint16_t pageCount;
+            // NOTE: Index of the first page of this segment in pageStarts_.
+            size_t firstPage;
+        } SCFixupSegment;
+
+        // NOTE: Some formats store rebase targets as offsets from this
+        //       address (the preferred load address).
+        uint64_t baseAddress_;
+        std::vector<SCFixupSegment> segments_;
+        // NOTE: For each page, the offset of the first pointer of its chain.
+        std::vector<uint16_t> pageStarts_;
+        std::vector<const char *> importNames_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_FIXUPS_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,145 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_IMAGE_H_
+#define SYMBOLICATE_IMAGE_H_
+
+#include <mach/machine.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+
+class SCInput;
+
+typedef struct _SCSegmentInfo {
+    char name[17];
+    uint64_t vmaddr;
+    uint64_t vmsize;
+    uint64_t fileoff;
+    uint64_t filesize;
+} SCSegmentInfo;
+
+// NOTE: A Mach-O image located either in a (possibly fat) binary, or inside of
+//       a dyld shared cache. Only the load commands are read on creation; the
+//       symbol-related portions of __LINKEDIT are mapped on first use.
+class SCMachOImage {
+    public:
+        static SCMachOImage *createWithBinary(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+        static SCMachOImage *createWithSharedCache(SCInput *sharedCache, const char *dylibPath);
+        ~SCMachOImage();
+
+        BOOL is64Bit() const { return is64Bit_; }
+        BOOL isFromSharedCache() const { return isFromSharedCache_; }
+        cpu_type_t cputype() const { return cputype_; }
+        const uint8_t *uuid() const { return hasUUID_ ? uuid_ : NULL; }
+
+        // NOTE: This is the virtual address of the __TEXT segment.
+        uint64_t baseAddress() const;
+        const SCSegmentInfo *segmentNamed(const char *name) const;
+
+        // LC_FUNCTION_STARTS, as ULEB128-encoded deltas.
+        const uint8_t *functionStarts(size_t *length);
+
+        // LC_SYMTAB.
+        // NOTE: Entries are nlist or nlist_64, depending on is64Bit().
+        const uint8_t *symbols(uint32_t *count);
+        const char *strings(uint32_t *size);
+
+        // Local symbols stripped into the shared cache (shared cache only).
+        const uint8_t *localSymbols(uint32_t *count);
+        const char *localStrings(uint32_t *size);
+
+    private:
+        SCMachOImage(SCInput *input);
+        BOOL parseLoadCommands(uint64_t headerOffset, uint64_t linkeditBase);
+        const uint8_t *mapRegion(uint64_t offset, size_t length);
+        BOOL loadLocalSymbols();
+
+        SCInput *input_;
+        BOOL is64Bit_;
+        BOOL isFromSharedCache_;
+        cpu_type_t cputype_;
+        uint8_t uuid_[16];
+        BOOL hasUUID_;
+        std::vector<SCSegmentInfo> segments_;
+
+        uint64_t functionStartsOffset_;
+        uint32_t functionStartsSize_;
+        uint64_t symbolsOffset_;
+        uint32_t symbolsCount_;
+        uint64_t stringsOffset_;
+        uint32_t stringsSize_;
+
+        uint64_t headerOffset_;
+        uint64_t cacheLocalSymbolsOffset_;
+        uint64_t cacheLocalSymbolsSize_;
+        BOOL hasLoadedLocalSymbols_;
+        uint64_t localSymbolsOffset_;
+        uint32_t localSymbolsCount_;
+        uint64_t localStringsOffset_;
+        uint32_t localStringsSize_;
+
+        typedef struct _SCRegion {
+            uint64_t offset;
+            size_t length;
+            const uint8_t *data;
+        } SCRegion;
+        std::vector<SCRegion> regions_;
+};
+
+// NOTE: Decodes LC_FUNCTION_STARTS data in address order, without allocating.
+class SCFunctionStartsIterator {
+    public:
+        SCFunctionStartsIterator(const uint8_t *data, size_t length, uint64_t baseAddress, BOOL isThumb)
+            : p_(data), end_(data + length), address_(baseAddress), isThumb_(isThumb) {}
+
+        BOOL next(uint64_t *address) {
+            uint64_t delta = 0;
+            unsigned shift = 0;
+            uint8_t byte;
+            do {
+                if (p_ >= end_) {
+                    return NO;
+                }
+                if (shift >= 64) {
+                    // NOTE: The delta does not fit in 64 bits; the data is
+                    //       malformed, so stop here.
+                    p_ = end_;
+                    return NO;
+                }
+                byte = *p_++;
+                delta |= (uint64_t)(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+
+            if (delta == 0) {
+                // NOTE: The list is terminated by a zero delta.
+                p_ = end_;
+                return NO;
+            }
+
+            address_ += delta;
+            *address = isThumb_ ? (address_ & ~1ULL) : address_;
+            return YES;
+        }
+
+    private:
+        const uint8_t *p_;
+        const uint8_t *end_;
+        uint64_t address_;
+        BOOL isThumb_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_IMAGE_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
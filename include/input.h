@@ -0,0 +1,61 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_INPUT_H_
+#define SYMBOLICATE_INPUT_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+
+// NOTE: An input is a random-access, read-only source of bytes. Parsers should
+//       only read or map the ranges that they actually need, as for some types
+//       of input (e.g. compressed archive entries) each range has to be
+//       decompressed on demand.
+// NOTE: Inputs are reference counted; they are created with a count of one.
+class SCInput {
+    public:
+        SCInput() : refCount_(1) {}
+
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        virtual uint64_t size() const = 0;
+
+        // Copy the given range into the buffer.
+        virtual BOOL read(void *buffer, size_t length, uint64_t offset) = 0;
+
+        // Obtain a read-only view of the given range.
+        // NOTE: The view must be released via unmap(), passing the same offset
+        //       and length that were passed to map().
+        virtual const uint8_t *map(uint64_t offset, size_t length) = 0;
+        virtual void unmap(const uint8_t *data, uint64_t offset, size_t length) = 0;
+
+    protected:
+        virtual ~SCInput() {}
+
+    private:
+        volatile int32_t refCount_;
+};
+
+// NOTE: The path may refer to an entry inside of a zip archive (e.g. an IPA or
+//       a firmware archive), using the form "<archive path>!/<entry name>".
+//       Both stored and deflated entries are supported.
+SCInput *SCInputCreateWithPath(const char *path);
+
+// NOTE: The memory is not copied; it must remain valid for the lifetime of the
+//       input.
+SCInput *SCInputCreateWithMemory(const void *memory, size_t length);
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_INPUT_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
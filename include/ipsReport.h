@@ -0,0 +1,129 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_IPSREPORT_H_
+#define SYMBOLICATE_IPSREPORT_H_
+
+#include "crashReport.h"
+
+#ifdef __cplusplus
+
+#include <set>
+#include <string>
+#include <vector>
+
+// NOTE: An entry of "usedImages". The fields correspond to the arguments of
+//       -[SCBinaryInfo initWithPath:address:architecture:uuid:].
+typedef struct _SCIPSImage {
+    uint64_t address;
+    uint64_t size;
+    SCStringView uuid;
+    SCStringView architecture;
+    SCStringView path;
+    SCStringView name;
+} SCIPSImage;
+
+typedef struct _SCIPSFrame {
+    // NOTE: Index into the images; SCIPSNoImage if the frame has none.
+    uint32_t imageIndex;
+    uint64_t imageOffset;
+} SCIPSFrame;
+
+#define SCIPSNoImage UINT32_MAX
+
+typedef struct _SCIPSThread {
+    // NOTE: -1 for the "lastExceptionBacktrace".
+    int index;
+    BOOL isCrashed;
+    SCStringView name;
+    SCStringView queue;
+    // NOTE: Range of the thread's frames in the frames array.
+    uint32_t firstFrame;
+    uint32_t frameCount;
+} SCIPSThread;
+
+// NOTE: Parses a crash report in the JSON format (.ips) used by newer versions
+//       of iOS: a header object on the first line, followed by the body object.
+//       Only the fields needed for symbolication are extracted, in a single
+//       pass; everything else (e.g. thread states, symbol names) is skipped
+//       without being decoded.
+// NOTE: Strings are views into the input, which must remain valid for as long
+//       as the report is used. Strings that contain escape sequences (e.g.
+//       paths, in which '/' is escaped) are decoded into storage owned by the
+//       report.
+class SCIPSReport {
+    public:
+        SCIPSReport() : p_(NULL), end_(NULL), failed_(NO) {
+            bugType_.data = NULL;
+            bugType_.length = 0;
+        }
+
+        // NOTE: Replaces the results of any previous parse, including their
+        //       decoded strings.
+        BOOL parse(const char *data, size_t length);
+
+        // NOTE: From the header; e.g. "309" for crashes.
+        SCStringView bugType() const { return bugType_; }
+
+        const std::vector<SCIPSImage> &images() const { return images_; }
+        const std::vector<SCIPSThread> &threads() const { return threads_; }
+        const std::vector<SCIPSFrame> &frames() const { return frames_; }
+
+        // NOTE: Returns 0 if the frame has no image.
+        uint64_t addressForFrame(const SCIPSFrame &frame) const {
+            return (frame.imageIndex < images_.size()) ?
+                (images_[frame.imageIndex].address + frame.imageOffset) : 0;
+        }
+
+    private:
+        SCIPSReport(const SCIPSReport &);
+        SCIPSReport &operator=(const SCIPSReport &);
+
+        void fail(const char *message);
+        BOOL expect(char c);
+        BOOL nextMember(BOOL *isFirst, SCStringView *key);
+        BOOL nextElement(BOOL *isFirst);
+        BOOL parseString(SCStringView *string);
+        BOOL parseUnsigned(uint64_t *value);
+        BOOL parseBool(BOOL *value);
+        void skipWhitespace();
+        void skipValue();
+
+        void parseHeader();
+        void parseBody();
+        void parseImages();
+        void parseImage();
+        void parseThreads();
+        void parseThread(int index);
+        void parseFrames();
+        void parseFrame();
+
+        const char *p_;
+        const char *end_;
+        BOOL failed_;
+
+        SCStringView bugType_;
+        std::vector<SCIPSImage> images_;
+        std::vector<SCIPSThread> threads_;
+        std::vector<SCIPSFrame> frames_;
+        std::set<std::string> strings_;
+};
+
+// NOTE: Reports in the .ips format start with a JSON header object on its own
+//       line. In newer reports the body is JSON as well (see SCIPSReport); in
+//       older ones it is a text crash log (see SCCrashReportParser).
+//       Returns NO if the data does not start with a header. Otherwise, the
+//       body is the remainder of the data following the header line.
+BOOL findIPSReportBody(const char *data, size_t length, const char **body, BOOL *isJSON);
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_IPSREPORT_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -10,6 +10,8 @@
 #import "SCBinaryInfo.h"
 #import "SCMethodInfo.h"
 #import "SCSymbolInfo.h"
+#import "SCSymbolicationContext.h"
+#import "SCSymbolicationQueue.h"
 #import "SCSymbolicator.h"
 
 /* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
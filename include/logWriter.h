@@ -0,0 +1,58 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_LOGWRITER_H_
+#define SYMBOLICATE_LOGWRITER_H_
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+
+// NOTE: Describes a symbolicated log as a sequence of segments, suitable for
+//       writev(): unchanged slices of the original log, interleaved with the
+//       text that replaces parts of it (e.g. the symbol of a frame; see
+//       SCCrashFrame). Nothing is copied; the log and the replacement text
+//       must remain valid until the segments have been written.
+class SCLogWriter {
+    public:
+        SCLogWriter(const char *data, size_t length);
+
+        // NOTE: Replaces the range [start, end) of the log. Ranges must be
+        //       given in increasing order and must not overlap; an empty range
+        //       inserts the text. Returns NO if the range is invalid.
+        BOOL replace(const char *start, const char *end, const char *text, size_t length);
+
+        // NOTE: Includes the remainder of the log after the last replacement.
+        const struct iovec *segments();
+        size_t segmentCount();
+        size_t length();
+
+    private:
+        void finish();
+
+        const char *end_;
+        // NOTE: Start of the part of the log that has not yet been added.
+        const char *p_;
+        std::vector<struct iovec> segments_;
+        BOOL isFinished_;
+};
+
+// NOTE: Writes all of the segments, in batches of at most IOV_MAX, retrying
+//       after partial writes and interruptions. A non-blocking descriptor is
+//       waited on when it is full.
+BOOL writeSegments(int fd, const struct iovec *segments, size_t count);
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_LOGWRITER_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
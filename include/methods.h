@@ -16,10 +16,96 @@
 extern "C" {
 #endif
 
+// NOTE: The file path may refer to an entry inside of an archive (see input.h).
+// NOTE: These functions return an array of SCMethodInfo objects, sorted
+//       greatest to least by address. Use SCMethodTable to avoid creating an
+//       object for every method.
 NSArray *methodsForBinaryFile(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+NSArray *methodsForBinaryInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype);
 
 #ifdef __cplusplus
 }
+
+#include <string>
+#include <vector>
+#include "addressTable.h"
+
+class SCInput;
+
+// NOTE: The Objective-C methods of a binary, stored as parallel arrays sorted
+//       least to greatest by implementation address. Class names and
+//       selectors are stored as 32-bit references: either offsets into the
+//       name sections of the binary (__objc_classname and __objc_methname),
+//       views of which are kept by the table, or offsets into a buffer of
+//       names that are located elsewhere. Only the Objective-C sections are
+//       mapped, never the whole binary. Full names are only built when
+//       requested.
+// NOTE: Tables are reference counted; they are created with a count of one.
+class SCMethodTable {
+    public:
+        static SCMethodTable *createWithInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype);
+
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        size_t count() const { return addressTable_->count(); }
+        uint64_t addressAtIndex(size_t index) const { return addressTable_->addressAtIndex(index); }
+        const char *classNameAtIndex(size_t index) const { return stringForReference(classNames_[index]); }
+        const char *selectorAtIndex(size_t index) const { return stringForReference(selectors_[index]); }
+        BOOL isClassMethodAtIndex(size_t index) const { return (types_[index] == '+'); }
+
+        // NOTE: Returns the index of the method with the greatest address that
+        //       is less than or equal to the given address, or count() if there
+        //       is no such method.
+        size_t indexForAddress(uint64_t address) const { return addressTable_->indexForAddress(address); }
+
+        // NOTE: Returns a name of the form "-[Class selector]".
+        NSString *nameAtIndex(size_t index) const;
+        void getNameAtIndex(size_t index, std::string &name) const;
+
+        const SCAddressTable *addressTable() const { return addressTable_; }
+
+        // NOTE: Returns an autoreleased array of SCMethodInfo objects, sorted
+        //       greatest to least by address.
+        NSArray *methodInfos() const;
+
+        // NOTE: An estimate, in bytes, of the memory used by the table.
+        size_t memoryUsage() const;
+
+    private:
+        SCMethodTable() : refCount_(1), addressTable_(NULL), input_(NULL), offset_(0) {}
+        ~SCMethodTable();
+
+        // NOTE: A reference is either the file offset of a name in one of the
+        //       mapped name sections, or, if kStringBufferFlag is set, an
+        //       offset into strings_.
+        static const uint32_t kStringBufferFlag = 0x80000000;
+        const char *stringForReference(uint32_t reference) const;
+
+        typedef struct _SCRegion {
+            uint64_t offset;
+            size_t length;
+            const uint8_t *data;
+        } SCRegion;
+        static bool compareRegions(const SCRegion &a, const SCRegion &b);
+        // NOTE: The regions must be sorted by offset and must not overlap.
+        static const SCRegion *regionForOffset(const std::vector<SCRegion> &regions, uint64_t offset);
+
+        template <typename P> friend class SCMethodTableBuilder;
+
+        volatile int32_t refCount_;
+        SCAddressTable *addressTable_;
+        std::vector<uint32_t> classNames_;
+        std::vector<uint32_t> selectors_;
+        std::vector<char> types_;
+        std::vector<char> strings_;
+
+        // NOTE: Offsets of regions are relative to the start of the binary,
+        //       which is located at offset_ in the input.
+        SCInput *input_;
+        uint64_t offset_;
+        std::vector<SCRegion> regions_;
+};
 #endif
 
 #endif // SYMBOLICATE_METHODS_H_
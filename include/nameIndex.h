@@ -0,0 +1,97 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_NAMEINDEX_H_
+#define SYMBOLICATE_NAMEINDEX_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+
+@class NSArray;
+class SCSymbolCursor;
+
+typedef struct _SCNameIndexEntry {
+    // NOTE: Points into memory owned by the index.
+    const char *name;
+    uint64_t address;
+    // NOTE: Zero if unknown (see SCSymbolRecord).
+    uint64_t size;
+} SCNameIndexEntry;
+
+// NOTE: An index from symbol name to address (the reverse of symbolication),
+//       for exact and prefix queries.
+// NOTE: Names are interned; each distinct name is stored once, and names are
+//       found via a hash table. The names are also kept in sorted order, for
+//       prefix queries. A name may refer to more than one address (e.g. local
+//       symbols with the same name in different files).
+// NOTE: Mangled C++ names and names of Logos hooks are indexed under both
+//       their mangled and demangled forms (see demangle.h).
+// NOTE: Indexes are immutable, and so may be shared between threads.
+// NOTE: Indexes are reference counted; they are created with a count of one.
+class SCNameIndex {
+    public:
+        // NOTE: Reads all remaining records of the cursor.
+        static SCNameIndex *createWithCursor(SCSymbolCursor *cursor);
+
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        // NOTE: The number of distinct names.
+        size_t count() const { return nameOffsets_.size(); }
+
+        // NOTE: The matching entries are appended to the given vector, in
+        //       ascending address order; the number appended is returned.
+        size_t findName(const char *name, std::vector<SCNameIndexEntry> &entries) const;
+
+        // NOTE: As above, for all names that begin with the given prefix, in
+        //       name order. At most the given number of entries are appended.
+        size_t findPrefix(const char *prefix, std::vector<SCNameIndexEntry> &entries, size_t limit) const;
+
+        size_t memoryUsage() const;
+
+    private:
+        typedef struct _SCNameIndexRecord {
+            uint64_t address;
+            uint64_t size;
+        } SCNameIndexRecord;
+
+        SCNameIndex() : refCount_(1) {}
+        ~SCNameIndex() {}
+        SCNameIndex(const SCNameIndex &);
+        SCNameIndex &operator=(const SCNameIndex &);
+
+        const char *nameAtIndex(size_t index) const { return &strings_[nameOffsets_[index]]; }
+        void appendEntries(size_t index, std::vector<SCNameIndexEntry> &entries, size_t limit) const;
+
+        friend class SCNameIndexBuilder;
+
+        volatile int32_t refCount_;
+        std::vector<char> strings_;
+        // NOTE: Names are numbered in sorted order. The records of name i are
+        //       records_[recordStarts_[i]] to records_[recordStarts_[i + 1]].
+        std::vector<uint32_t> nameOffsets_;
+        std::vector<uint32_t> recordStarts_;
+        std::vector<SCNameIndexRecord> records_;
+        // NOTE: Open-addressed hash table of name number plus one (zero for an
+        //       empty slot). The size is a power of two.
+        std::vector<uint32_t> slots_;
+};
+
+// NOTE: Returns an array of SCSymbolInfo objects, with the slide subtracted
+//       from each address.
+NSArray *symbolInfosForNameIndexEntries(const std::vector<SCNameIndexEntry> &entries, int64_t slide);
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_NAMEINDEX_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,62 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_PREFETCH_H_
+#define SYMBOLICATE_PREFETCH_H_
+
+#include <dispatch/dispatch.h>
+#include <stdint.h>
+
+@class SCBinaryInfo;
+
+#ifdef __cplusplus
+
+#include <vector>
+
+// NOTE: Warms up the state of binaries (see registry.h) in the background,
+//       while the rest of a log is still being parsed: the symbolicator and,
+//       for binaries with enough frames (see SYMBOL_ADDRESS_SCAN_LIMIT), the
+//       symbol address table. Binaries that no frame refers to are skipped.
+// NOTE: As the state is shared, it is used by any other binary info object for
+//       the same binary (e.g. the objects that the frames are later resolved
+//       with); the prefetched objects themselves are only used in the
+//       background, and are released once warmed up.
+// NOTE: A prefetcher should only be used from one thread at a time.
+class SCBinaryPrefetcher {
+    public:
+        SCBinaryPrefetcher();
+        ~SCBinaryPrefetcher();
+
+        void addFrame(uint64_t address);
+        // NOTE: The number of frames added so far with addresses in the range
+        //       [address, endAddress].
+        size_t frameCountInRange(uint64_t address, uint64_t endAddress);
+
+        // NOTE: The prefetcher retains the binary info object; the caller
+        //       should not use it any further.
+        void prefetch(SCBinaryInfo *binaryInfo, size_t frameCount);
+
+        // NOTE: Waits for all warm-up to finish. Not called on destruction;
+        //       pending warm-up then finishes in the background.
+        void wait();
+
+    private:
+        SCBinaryPrefetcher(const SCBinaryPrefetcher &);
+        SCBinaryPrefetcher &operator=(const SCBinaryPrefetcher &);
+
+        std::vector<uint64_t> addresses_;
+        BOOL isSorted_;
+        dispatch_group_t group_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_PREFETCH_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,160 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_REGISTRY_H_
+#define SYMBOLICATE_REGISTRY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <pthread.h>
+#include <map>
+#include <set>
+#include <string>
+#include "CoreSymbolication.h"
+
+@class NSArray;
+class SCAddressTable;
+class SCBinaryRegistry;
+class SCMethodTable;
+class SCNameIndex;
+
+// NOTE: Parsed state of a binary, shared by all SCBinaryInfo objects that
+//       refer to the same binary (by UUID and architecture).
+// NOTE: Each value is computed at most once: a getter returns NO if the value
+//       is not yet known, and a setter keeps the first value set (releasing
+//       any later one). Values may be NULL (e.g. a binary without methods).
+//       All methods are thread-safe.
+// NOTE: States are reference counted; they are created with a count of one.
+class SCBinaryState {
+    public:
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        // NOTE: Returned values are retained; the caller must release them.
+        BOOL getMethodTable(SCMethodTable **methodTable);
+        BOOL getNameIndex(SCNameIndex **nameIndex);
+        BOOL getSymbolAddresses(NSArray **symbolAddresses);
+        BOOL getSymbolAddressTable(SCAddressTable **symbolAddressTable);
+        BOOL getSymbolicator(CSSymbolicatorRef *symbolicator);
+
+        // NOTE: The given values are consumed (not retained again). The value
+        //       that is in effect after the call is returned, retained.
+        SCMethodTable *setMethodTable(SCMethodTable *methodTable);
+        SCNameIndex *setNameIndex(SCNameIndex *nameIndex);
+        NSArray *setSymbolAddresses(NSArray *symbolAddresses);
+        SCAddressTable *setSymbolAddressTable(SCAddressTable *symbolAddressTable);
+        CSSymbolicatorRef setSymbolicator(CSSymbolicatorRef symbolicator);
+
+        // NOTE: Counts a symbol address lookup for the binary, returning the
+        //       number of lookups so far from all objects for the binary (see
+        //       -symbolAddressForAddress: of SCBinaryInfo).
+        uint32_t countSymbolAddressLookup() { return __sync_add_and_fetch(&symbolAddressLookupCount_, 1); }
+
+        // NOTE: Returns a copy of the string that remains valid for the life
+        //       of the state; equal strings share the same copy.
+        const char *internString(const char *string);
+
+        // NOTE: An estimate, in bytes, of the memory used by the values.
+        // NOTE: The cost of interned strings is counted in batches, and so
+        //       may lag behind.
+        size_t cost() const { return cost_; }
+
+        // NOTE: Unique for the lifetime of the process; a state that is created
+        //       for a binary after another was evicted has a new identifier.
+        uint64_t identifier() const { return identifier_; }
+
+    private:
+        SCBinaryState(SCBinaryRegistry *registry);
+        ~SCBinaryState();
+        SCBinaryState(const SCBinaryState &);
+        SCBinaryState &operator=(const SCBinaryState &);
+
+        void addCost(size_t cost);
+
+        friend class SCBinaryRegistry;
+
+        volatile int32_t refCount_;
+        SCBinaryRegistry *registry_;
+        uint64_t identifier_;
+        pthread_mutex_t mutex_;
+        size_t cost_;
+        // NOTE: Cost of interned strings not yet added to the registry.
+        volatile size_t pendingCost_;
+        volatile uint32_t symbolAddressLookupCount_;
+
+        SCMethodTable *methodTable_;
+        SCNameIndex *nameIndex_;
+        NSArray *symbolAddresses_;
+        SCAddressTable *symbolAddressTable_;
+        CSSymbolicatorRef symbolicator_;
+        std::set<std::string> strings_;
+        BOOL hasMethodTable_;
+        BOOL hasNameIndex_;
+        BOOL hasSymbolAddresses_;
+        BOOL hasSymbolAddressTable_;
+        BOOL hasSymbolicator_;
+
+        // NOTE: Protected by the lock of the registry.
+        BOOL isRegistered_;
+        volatile uint64_t lastUse_;
+};
+
+// NOTE: A process-wide cache of binary states, keyed by UUID and architecture.
+//       Lookups only take a read lock. When the total cost of the cached states
+//       exceeds the capacity, the least recently used states are dropped from
+//       the registry; states that are still referenced elsewhere remain valid
+//       until released.
+class SCBinaryRegistry {
+    public:
+        static SCBinaryRegistry *sharedInstance();
+
+        // NOTE: The UUID may be in any common format (e.g. with or without
+        //       hyphens or angle brackets). The returned state is retained and
+        //       must be released by the caller; NULL is returned if the UUID is
+        //       invalid.
+        SCBinaryState *stateFor(const char *uuid, const char *architecture);
+
+        // NOTE: Returns a new state that is not shared (e.g. for a binary
+        //       without a UUID). The state must be released by the caller.
+        SCBinaryState *createPrivateState();
+
+        size_t capacity() const { return capacity_; }
+        void setCapacity(size_t capacity);
+        size_t cost() const { return cost_; }
+        size_t count();
+
+        // NOTE: Drops all states from the registry.
+        void removeAll();
+
+    private:
+        SCBinaryRegistry(size_t capacity);
+        ~SCBinaryRegistry();
+
+        void addCost(SCBinaryState *state, size_t cost);
+        void evictIfNeeded();
+
+        friend class SCBinaryState;
+
+        typedef std::map<std::string, SCBinaryState *> SCBinaryStateMap;
+
+        pthread_rwlock_t lock_;
+        SCBinaryStateMap states_;
+        size_t capacity_;
+        size_t cost_;
+        volatile uint64_t clock_;
+        uint64_t nextIdentifier_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_REGISTRY_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
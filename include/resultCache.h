@@ -0,0 +1,82 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_RESULTCACHE_H_
+#define SYMBOLICATE_RESULTCACHE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <pthread.h>
+#import "SCSymbolInfo.h"
+
+// NOTE: A bounded cache of symbolication results, keyed by binary and address.
+//       The binary is identified by the identifier of its shared state (see
+//       registry.h), which is never reused; the address is the offset from
+//       the load address of the binary, so that results can be reused across
+//       processes with different slides.
+// NOTE: The cache is split into shards, each with its own lock, selected by
+//       the hash of the key. Each shard is set-associative: a key can only be
+//       stored in one of the few slots of its set, and the least recently used
+//       slot of the set is replaced. A lookup is therefore a single probe.
+// NOTE: Results that were not found are cached as well, as results with
+//       neither a name nor a source path.
+// NOTE: The strings of a result are not copied; they must be interned in the
+//       state of the binary (which outlives any lookup that can match it).
+// NOTE: Caches are reference counted; they are created with a count of one.
+class SCResultCache {
+    public:
+        // NOTE: The capacity is the total number of results; it is rounded up
+        //       to fill whole sets.
+        static SCResultCache *create(size_t capacity);
+
+        void retain() { __sync_add_and_fetch(&refCount_, 1); }
+        void release() { if (__sync_sub_and_fetch(&refCount_, 1) == 0) delete this; }
+
+        BOOL lookup(uint64_t binary, uint64_t address, SCSymbolResult *result);
+        void insert(uint64_t binary, uint64_t address, const SCSymbolResult &result);
+        void removeAll();
+
+        uint64_t hits() const { return hits_; }
+        uint64_t misses() const { return misses_; }
+
+    private:
+        typedef struct _SCResult {
+            uint64_t binary;
+            uint64_t address;
+            uint64_t lastUse;
+            // NOTE: NO if the slot is empty.
+            BOOL isValid;
+            SCSymbolResult result;
+        } SCResult;
+
+        typedef struct _SCShard {
+            pthread_mutex_t mutex;
+            SCResult *results;
+            uint64_t clock;
+        } SCShard;
+
+        SCResultCache(size_t setsPerShard);
+        ~SCResultCache();
+        SCResultCache(const SCResultCache &);
+        SCResultCache &operator=(const SCResultCache &);
+
+        volatile int32_t refCount_;
+        SCShard *shards_;
+        size_t setsPerShard_;
+        volatile uint64_t hits_;
+        volatile uint64_t misses_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_RESULTCACHE_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,35 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_SCAN_H_
+#define SYMBOLICATE_SCAN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+
+// NOTE: Linear scans of symbol data, straight from a mapping, for lookups that
+//       are too few to be worth building an index for. Where available, NEON
+//       or SSE2 is used to compare several entries at a time.
+
+// NOTE: Returns the index of the first entry (nlist or nlist_64) with the given
+//       value, or the count if there is none.
+uint32_t indexOfNlistWithValue(const uint8_t *nlists, uint32_t count, BOOL is64Bit, uint64_t value);
+
+// NOTE: Decodes LC_FUNCTION_STARTS data (see SCFunctionStartsIterator) only as
+//       far as needed to find the greatest function start that is less than or
+//       equal to the given address. Returns NO if there is no such start.
+BOOL functionStartForAddress(const uint8_t *data, size_t length, uint64_t baseAddress, BOOL isThumb, uint64_t address, uint64_t *start);
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_SCAN_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,98 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_SYMBOLS_H_
+#define SYMBOLICATE_SYMBOLS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+#include <vector>
+#include "image.h"
+
+@class SCBinaryInfo;
+class SCMethodTable;
+class SCSymbolStream;
+
+typedef enum {
+    SCSymbolSourceNone = 0,
+    SCSymbolSourceSymbolTable,
+    SCSymbolSourceLocalSymbols,
+    SCSymbolSourceMethods
+} SCSymbolSource;
+
+typedef struct _SCSymbolRecord {
+    uint64_t address;
+    // NOTE: The size is only known for function starts, and is zero otherwise.
+    //       A function extends to the start of the next function, or to the
+    //       end of the __TEXT segment.
+    uint64_t size;
+    // NOTE: The name is NULL for function starts without a name. It points
+    //       into memory owned by the cursor. Names from the symbol tables
+    //       remain valid for the lifetime of the cursor; method names, which
+    //       are built on demand, remain valid until the next call to next().
+    const char *name;
+    SCSymbolSource source;
+    BOOL isFunctionStart;
+} SCSymbolRecord;
+
+// NOTE: Walks the merged set of function starts, symbol table entries, local
+//       symbols stripped into the shared cache and Objective-C methods, in
+//       ascending address order. Each address is yielded once; if more than
+//       one source names it, the symbol table is preferred, followed by local
+//       symbols and then methods.
+// NOTE: Function starts are decoded as the cursor advances. The symbol tables
+//       are not sorted by address, however, so the cursor holds a sorted
+//       array of indices of their entries (four bytes per symbol).
+class SCSymbolCursor {
+    public:
+        static SCSymbolCursor *createWithBinaryInfo(SCBinaryInfo *binaryInfo);
+        static SCSymbolCursor *createWithSharedCache(const char *sharedCachePath, const char *dylibPath);
+
+        // NOTE: The cursor takes ownership of the image, and retains the method
+        //       table (which may be NULL).
+        SCSymbolCursor(SCMachOImage *image, SCMethodTable *methods);
+        ~SCSymbolCursor();
+
+        SCMachOImage *image() const { return image_; }
+
+        // NOTE: Returns NO once all records have been read.
+        BOOL next(SCSymbolRecord *record);
+
+        // NOTE: Positions the cursor at the first record whose address is
+        //       greater than or equal to the given address.
+        void seek(uint64_t address);
+        void rewind() { seek(0); }
+
+    private:
+        SCSymbolCursor(const SCSymbolCursor &);
+        SCSymbolCursor &operator=(const SCSymbolCursor &);
+
+        void rewindFunctionStarts();
+        void advanceFunctionStart();
+
+        SCMachOImage *image_;
+        std::vector<SCSymbolStream *> streams_;
+        // NOTE: Only the current function start and the one following it
+        //       (which gives the size of the function) are kept.
+        SCFunctionStartsIterator firstFunctionStart_;
+        SCFunctionStartsIterator functionStarts_;
+        uint64_t functionStart_;
+        uint64_t nextFunctionStart_;
+        BOOL hasFunctionStart_;
+        BOOL hasNextFunctionStart_;
+        uint64_t textEnd_;
+};
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_SYMBOLS_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,50 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "SCCrashReport.h"
+
+#import "SCBinaryInfo.h"
+
+NSString *stringForView(const SCStringView &view) {
+    return [[[NSString alloc] initWithBytes:view.data length:view.length encoding:NSUTF8StringEncoding] autorelease];
+}
+
+NSString *uuidForView(const SCStringView &view) {
+    char buf[35];
+    unsigned length = 0;
+    buf[length++] = '<';
+    for (size_t i = 0; i < view.length; ++i) {
+        char c = view.data[i];
+        if ((c >= 'A') && (c <= 'F')) {
+            c = c - 'A' + 'a';
+        } else if (!(((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'f')))) {
+            continue;
+        }
+        if (length > 32) {
+            return nil;
+        }
+        buf[length++] = c;
+    }
+    if (length != 33) {
+        return nil;
+    }
+    buf[length++] = '>';
+    return [[[NSString alloc] initWithBytes:buf length:length encoding:NSASCIIStringEncoding] autorelease];
+}
+
+SCBinaryInfo *SCBinaryInfoCreateForReportImage(const SCStringView &path, uint64_t address, const SCStringView &architecture, const SCStringView &uuid) {
+    NSString *uuidString = uuidForView(uuid);
+    if ((path.length == 0) || (uuidString == nil)) {
+        return nil;
+    }
+    return [[SCBinaryInfo alloc] initWithPath:stringForView(path) address:address
+        architecture:stringForView(architecture) uuid:uuidString];
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -12,7 +12,26 @@
 @implementation SCSymbolInfo
 
 @synthesize name = name_;
+@synthesize addressRange = addressRange_;
+@synthesize offset = offset_;
 @synthesize sourcePath = sourcePath_;
+@synthesize sourceLineNumber = sourceLineNumber_;
+
+- (id)initWithResult:(const SCSymbolResult *)result {
+    self = [super init];
+    if (self != nil) {
+        if (result->name != NULL) {
+            name_ = [[NSString alloc] initWithUTF8String:result->name];
+        }
+        addressRange_ = result->addressRange;
+        offset_ = result->offset;
+        if (result->sourcePath != NULL) {
+            sourcePath_ = [[NSString alloc] initWithUTF8String:result->sourcePath];
+        }
+        sourceLineNumber_ = result->sourceLineNumber;
+    }
+    return self;
+}
 
 - (void)dealloc {
     [name_ release];
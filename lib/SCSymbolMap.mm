@@ -0,0 +1,90 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "SCSymbolMap.h"
+
+#include <algorithm>
+#include <vector>
+#include "addressTable.h"
+
+typedef struct _SCSymbolMapEntry {
+    uint64_t address;
+    NSString *name;
+} SCSymbolMapEntry;
+
+static bool compareSymbolMapEntries(const SCSymbolMapEntry &a, const SCSymbolMapEntry &b) {
+    return a.address < b.address;
+}
+
+@implementation SCSymbolMap {
+    SCAddressTable *addresses_;
+    NSArray *names_;
+}
+
+#pragma mark - Creation & Destruction
+
+- (id)initWithDictionary:(NSDictionary *)dictionary {
+    self = [super init];
+    if (self != nil) {
+        std::vector<SCSymbolMapEntry> entries;
+        entries.reserve([dictionary count]);
+        for (NSNumber *number in dictionary) {
+            SCSymbolMapEntry entry = {[number unsignedLongLongValue], [dictionary objectForKey:number]};
+            entries.push_back(entry);
+        }
+        std::sort(entries.begin(), entries.end(), compareSymbolMapEntries);
+
+        std::vector<uint64_t> addresses;
+        addresses.reserve(entries.size());
+        NSMutableArray *names = [[NSMutableArray alloc] initWithCapacity:entries.size()];
+        for (std::vector<SCSymbolMapEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+            addresses.push_back(i->address);
+            [names addObject:i->name];
+        }
+        addresses_ = SCAddressTable::create(addresses.empty() ? NULL : &addresses[0], addresses.size());
+        names_ = names;
+        if (addresses_ == NULL) {
+            [self release];
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (addresses_ != NULL) {
+        addresses_->release();
+    }
+    [names_ release];
+    [super dealloc];
+}
+
+#pragma mark - Properties
+
+- (NSUInteger)count {
+    return addresses_->count();
+}
+
+#pragma mark - Public Methods
+
+- (NSString *)nameForAddress:(uint64_t)address symbolAddress:(uint64_t *)symbolAddress {
+    const size_t index = addresses_->indexBeforeAddress(address);
+    if (index == addresses_->count()) {
+        return nil;
+    }
+
+    if (symbolAddress != NULL) {
+        *symbolAddress = addresses_->addressAtIndex(index);
+    }
+    return [names_ objectAtIndex:index];
+}
+
+@end
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,432 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "SCSymbolicationContext.h"
+
+#import "SCBinaryInfo.h"
+#import "SCBinaryInfo-Private.h"
+#import "SCSymbolInfo.h"
+#import "SCSymbolMap.h"
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "addressTable.h"
+#include "demangle.h"
+#include "image.h"
+#include "input.h"
+#include "methods.h"
+#include "nameIndex.h"
+#include "registry.h"
+#include "resultCache.h"
+#include "sharedCache.h"
+#include "symbols.h"
+
+// NOTE: Enough for the frames of a few thousand crash logs.
+static const size_t kResultCacheCapacity = 65536;
+
+@implementation SCSymbolicationContext {
+    // NOTE: Compiled versions of the symbol maps, keyed by binary path.
+    NSDictionary *compiledSymbolMaps_;
+
+    SCResultCache *resultCache_;
+}
+
+@synthesize architecture = architecture_;
+@synthesize symbolMaps = symbolMaps_;
+@synthesize systemRoot = systemRoot_;
+@synthesize sharedCachePath = sharedCachePath_;
+
+#pragma mark - Creation & Destruction
+
+// NOTE: Each map is compiled once, here, so that lookups do not need to sort
+//       the keys of the map.
+- (id)initWithArchitecture:(NSString *)architecture systemRoot:(NSString *)systemRoot symbolMaps:(NSDictionary *)symbolMaps {
+    self = [super init];
+    if (self != nil) {
+        architecture_ = [(architecture ?: @"armv7") copy];
+        systemRoot_ = [(systemRoot ?: @"/") copy];
+        symbolMaps_ = [symbolMaps copy];
+
+        NSMutableDictionary *compiledSymbolMaps = [[NSMutableDictionary alloc] initWithCapacity:[symbolMaps_ count]];
+        for (NSString *path in symbolMaps_) {
+            SCSymbolMap *symbolMap = [[SCSymbolMap alloc] initWithDictionary:[symbolMaps_ objectForKey:path]];
+            if (symbolMap != nil) {
+                [compiledSymbolMaps setObject:symbolMap forKey:path];
+                [symbolMap release];
+            }
+        }
+        compiledSymbolMaps_ = compiledSymbolMaps;
+
+        // Determine path of shared cache.
+        NSString *sharedCachePath = @"/System/Library/Caches/com.apple.dyld/dyld_shared_cache_";
+        sharedCachePath = [systemRoot_ stringByAppendingPathComponent:sharedCachePath];
+        sharedCachePath_ = [[sharedCachePath stringByAppendingString:architecture_] retain];
+
+        resultCache_ = SCResultCache::create(kResultCacheCapacity);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    resultCache_->release();
+    [architecture_ release];
+    [symbolMaps_ release];
+    [compiledSymbolMaps_ release];
+    [systemRoot_ release];
+    [sharedCachePath_ release];
+    [super dealloc];
+}
+
+#pragma mark - Properties
+
+- (uint64_t)cacheHits {
+    return resultCache_->hits();
+}
+
+- (uint64_t)cacheMisses {
+    return resultCache_->misses();
+}
+
+#pragma mark - Public Methods
+
+typedef struct _SCBatchEntry {
+    SCBinaryInfo *binaryInfo;
+    uint64_t address;
+    NSUInteger index;
+} SCBatchEntry;
+
+// NOTE: Cursors into the tables of the binary of a group of batch entries;
+//       the method table is only retrieved once a lookup needs it.
+typedef struct _SCBatchCursors {
+    SCAddressCursor symbolAddresses;
+    SCAddressCursor methodAddresses;
+} SCBatchCursors;
+
+static bool compareBatchEntries(const SCBatchEntry &a, const SCBatchEntry &b) {
+    if (a.binaryInfo != b.binaryInfo) {
+        return a.binaryInfo < b.binaryInfo;
+    }
+    return a.address < b.address;
+}
+
+static BOOL isFoundResult(const SCSymbolResult &result) {
+    return (result.name != NULL) || (result.sourcePath != NULL);
+}
+
+// NOTE: Results are cached by binary and by offset from the load address of
+//       the binary, so that a repeated frame does not require determining the
+//       slide, nor any allocation.
+- (BOOL)getResult:(SCSymbolResult *)result forAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo {
+    memset(result, 0, sizeof(*result));
+
+    if (binaryInfo != nil) {
+        SCBinaryState *state = [binaryInfo sharedState];
+        const uint64_t offset = address - [binaryInfo address];
+        if (!resultCache_->lookup(state->identifier(), offset, result)) {
+            [self getResult:result forSlidAddress:(address + [binaryInfo slide]) inBinary:binaryInfo cursors:NULL];
+            resultCache_->insert(state->identifier(), offset, *result);
+        }
+    }
+
+    return isFoundResult(*result);
+}
+
+- (SCSymbolInfo *)symbolInfoForAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo {
+    SCSymbolResult result;
+    if (![self getResult:&result forAddress:address inBinary:binaryInfo]) {
+        return nil;
+    }
+    return [[[SCSymbolInfo alloc] initWithResult:&result] autorelease];
+}
+
+// NOTE: Addresses are grouped by binary and sorted, so that the per-binary
+//       work (e.g. determining the slide) is done at most once per batch, and
+//       so that the symbol address and method tables of a binary are searched
+//       with cursors that only move forward (a merge of the sorted addresses
+//       with each table). A binary with few addresses in the batch uses the
+//       same lookups as a single address (see -symbolAddressForAddress: of
+//       SCBinaryInfo), so as not to build its tables.
+- (void)getResults:(SCSymbolResult *)results forAddresses:(const uint64_t *)addresses inBinaries:(SCBinaryInfo * const *)binaryInfos count:(NSUInteger)count {
+    memset(results, 0, count * sizeof(*results));
+
+    std::vector<SCBatchEntry> entries;
+    entries.reserve(count);
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (binaryInfos[i] != nil) {
+            SCBatchEntry entry = {binaryInfos[i], addresses[i], i};
+            entries.push_back(entry);
+        }
+    }
+
+    // Group entries by binary, in ascending address order.
+    std::sort(entries.begin(), entries.end(), compareBatchEntries);
+
+    std::vector<SCBatchEntry>::const_iterator entry = entries.begin();
+    while (entry != entries.end()) {
+        SCBinaryInfo *binaryInfo = entry->binaryInfo;
+        SCBinaryState *state = [binaryInfo sharedState];
+        const uint64_t loadAddress = [binaryInfo address];
+        int64_t slide = 0;
+        BOOL hasSlide = NO;
+
+        std::vector<SCBatchEntry>::const_iterator groupEnd = entry;
+        while ((groupEnd != entries.end()) && (groupEnd->binaryInfo == binaryInfo)) {
+            ++groupEnd;
+        }
+        SCBatchCursors cursors;
+        SCBatchCursors *groupCursors = NULL;
+        if ((groupEnd - entry) > SYMBOL_ADDRESS_SCAN_LIMIT) {
+            cursors.symbolAddresses = SCAddressCursor([binaryInfo symbolAddressTable]);
+            groupCursors = &cursors;
+        }
+
+        for (; entry != groupEnd; ++entry) {
+            SCSymbolResult *result = &results[entry->index];
+            const uint64_t offset = entry->address - loadAddress;
+            if (!resultCache_->lookup(state->identifier(), offset, result)) {
+                if (!hasSlide) {
+                    slide = [binaryInfo slide];
+                    hasSlide = YES;
+                }
+                [self getResult:result forSlidAddress:(entry->address + slide) inBinary:binaryInfo cursors:groupCursors];
+                resultCache_->insert(state->identifier(), offset, *result);
+            }
+        }
+    }
+}
+
+// NOTE: The binaries array may contain NSNull for addresses with no known
+//       binary. The returned array is in the same order as the addresses, and
+//       contains NSNull for addresses that could not be symbolicated.
+- (NSArray *)symbolInfosForAddresses:(NSArray *)addresses inBinaries:(NSArray *)binaryInfos {
+    const NSUInteger count = [addresses count];
+    if ([binaryInfos count] != count) {
+        fprintf(stderr, "ERROR: Number of addresses and binaries must match.\n");
+        return nil;
+    }
+
+    NSNull *null = [NSNull null];
+    std::vector<uint64_t> addressValues(count);
+    std::vector<SCBinaryInfo *> binaries(count);
+    for (NSUInteger i = 0; i < count; ++i) {
+        addressValues[i] = [[addresses objectAtIndex:i] unsignedLongLongValue];
+        id binaryInfo = [binaryInfos objectAtIndex:i];
+        binaries[i] = (binaryInfo != null) ? binaryInfo : nil;
+    }
+
+    std::vector<SCSymbolResult> results(count);
+    if (count != 0) {
+        [self getResults:&results[0] forAddresses:&addressValues[0] inBinaries:&binaries[0] count:count];
+    }
+
+    NSMutableArray *symbolInfos = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (isFoundResult(results[i])) {
+            SCSymbolInfo *symbolInfo = [[SCSymbolInfo alloc] initWithResult:&results[i]];
+            [symbolInfos addObject:symbolInfo];
+            [symbolInfo release];
+        } else {
+            [symbolInfos addObject:null];
+        }
+    }
+    return symbolInfos;
+}
+
+- (NSArray *)symbolInfosForName:(NSString *)name inSharedCacheDylib:(NSString *)dylibPath {
+    std::vector<SCNameIndexEntry> entries;
+    SCNameIndex *nameIndex = [self createNameIndexForSharedCacheDylib:dylibPath];
+    if (nameIndex != NULL) {
+        nameIndex->findName([name UTF8String], entries);
+    }
+    NSArray *symbolInfos = symbolInfosForNameIndexEntries(entries, 0);
+    if (nameIndex != NULL) {
+        nameIndex->release();
+    }
+    return symbolInfos;
+}
+
+- (NSArray *)symbolInfosForNamePrefix:(NSString *)prefix inSharedCacheDylib:(NSString *)dylibPath {
+    std::vector<SCNameIndexEntry> entries;
+    SCNameIndex *nameIndex = [self createNameIndexForSharedCacheDylib:dylibPath];
+    if (nameIndex != NULL) {
+        nameIndex->findPrefix([prefix UTF8String], entries, SIZE_MAX);
+    }
+    NSArray *symbolInfos = symbolInfosForNameIndexEntries(entries, 0);
+    if (nameIndex != NULL) {
+        nameIndex->release();
+    }
+    return symbolInfos;
+}
+
+#pragma mark - Private Methods
+
+// NOTE: The index is kept in the state of the dylib (found by the UUID of the
+//       dylib), so that it is shared with other contexts.
+// NOTE: Only the load commands of the dylib are read to find its state; the
+//       symbol cursor (which sorts the symbols) is only created on a miss.
+// NOTE: The returned index must be released by the caller.
+- (SCNameIndex *)createNameIndexForSharedCacheDylib:(NSString *)dylibPath {
+    const char *sharedCachePath = [[self sharedCachePath] UTF8String];
+    SCInput *input = SCInputCreateWithPath(sharedCachePath);
+    if (input == NULL) {
+        return NULL;
+    }
+    SCMachOImage *image = SCMachOImage::createWithSharedCache(input, [dylibPath UTF8String]);
+    input->release();
+    if (image == NULL) {
+        fprintf(stderr, "ERROR: Failed to load image for dylib \"%s\" from shared cache: %s\n", [dylibPath UTF8String], sharedCachePath);
+        return NULL;
+    }
+
+    SCBinaryState *state = NULL;
+    const uint8_t *uuid = image->uuid();
+    if (uuid != NULL) {
+        char uuidString[33];
+        for (unsigned i = 0; i < 16; ++i) {
+            snprintf(&uuidString[2 * i], 3, "%02x", uuid[i]);
+        }
+        state = SCBinaryRegistry::sharedInstance()->stateFor(uuidString, [architecture_ UTF8String]);
+    }
+
+    SCNameIndex *nameIndex = NULL;
+    if ((state == NULL) || !state->getNameIndex(&nameIndex)) {
+        // NOTE: The cursor takes ownership of the image.
+        SCSymbolCursor *cursor = new SCSymbolCursor(image, NULL);
+        image = NULL;
+        nameIndex = SCNameIndex::createWithCursor(cursor);
+        delete cursor;
+        if (state != NULL) {
+            nameIndex = state->setNameIndex(nameIndex);
+        }
+    }
+    if (state != NULL) {
+        state->release();
+    }
+    delete image;
+    return nameIndex;
+}
+
+// NOTE: Runs the full lookup chain, and interns the strings of the result in
+//       the state of the binary. Objects created by the chain do not outlive
+//       this method.
+// NOTE: Cursors, if given, must be used with ascending addresses.
+- (void)getResult:(SCSymbolResult *)result forSlidAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo cursors:(SCBatchCursors *)cursors {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    SCSymbolInfo *symbolInfo = [self symbolInfoForSlidAddress:address inBinary:binaryInfo cursors:cursors];
+    if (symbolInfo != nil) {
+        SCBinaryState *state = [binaryInfo sharedState];
+        result->addressRange = [symbolInfo addressRange];
+        result->offset = [symbolInfo offset];
+        result->name = state->internString([[symbolInfo name] UTF8String]);
+        result->sourcePath = state->internString([[symbolInfo sourcePath] UTF8String]);
+        result->sourceLineNumber = [symbolInfo sourceLineNumber];
+    }
+    [pool drain];
+}
+
+// NOTE: The address must already include the slide of the binary.
+- (SCSymbolInfo *)symbolInfoForSlidAddress:(uint64_t)address inBinary:(SCBinaryInfo *)binaryInfo cursors:(SCBatchCursors *)cursors {
+    SCSymbolInfo *symbolInfo = [binaryInfo sourceInfoForAddress:address];
+    if (symbolInfo != nil) {
+        return symbolInfo;
+    }
+
+    // Determine symbol address.
+    // NOTE: Only possible if LC_FUNCTION_STARTS exists in the binary.
+    uint64_t symbolAddress = 0;
+    if (cursors != NULL) {
+        SCAddressCursor &symbolAddresses = cursors->symbolAddresses;
+        const size_t index = symbolAddresses.indexForAddress(address);
+        if (index < symbolAddresses.count()) {
+            symbolAddress = symbolAddresses.table()->addressAtIndex(index);
+        }
+    } else {
+        symbolAddress = [binaryInfo symbolAddressForAddress:address];
+    }
+
+    // Attempt to retrieve symbol name and hex offset.
+    // NOTE: (symbolAddress & ~1) is to account for Thumb.
+    NSString *name = nil;
+    uint64_t offset = 0;
+    symbolInfo = [binaryInfo symbolInfoForAddress:address];
+    if (symbolInfo != nil && ([symbolInfo addressRange].location == (symbolAddress & ~1) || symbolAddress == 0)) {
+        name = [symbolInfo name];
+        if ([name isEqualToString:@"<redacted>"]) {
+            NSString *sharedCachePath = [self sharedCachePath];
+            if (sharedCachePath != nil) {
+                // NOTE: In the past, the dylib offset was retrieved via
+                //       -[VMUMachOHeader address]. For some unknown
+                //       reason, the value retrieved using our own
+                //       function always differs by 0x200000.
+                // TODO: Determine the reason for this difference.
+                const char *cachePath = [sharedCachePath UTF8String];
+                uint64_t dylibOffset = offsetOfDylibInSharedCache(cachePath, [[binaryInfo path] UTF8String]);
+                // TODO: Determine max allowed length for symbol names (if such a limit exists).
+                char localNameBuffer[1025];
+                const char *localName = nameForLocalSymbol(cachePath, dylibOffset, [symbolInfo addressRange].location, localNameBuffer, sizeof(localNameBuffer));
+                if ((localName != NULL) && (strlen(localName) > 0)) {
+                    name = [NSString stringWithCString:localName encoding:NSASCIIStringEncoding];
+                } else {
+                    fprintf(stderr, "Unable to determine name for: %s, 0x%08llx\n", [[binaryInfo path] UTF8String], [symbolInfo addressRange].location);
+                }
+            }
+        }
+        // Attempt to demangle name
+        // NOTE: It seems that Apple's demangler fails for some
+        //       names, so we attempt to do it ourselves.
+        [symbolInfo setName:demangle(name)];
+        [symbolInfo setOffset:(address - [symbolInfo addressRange].location)];
+    } else {
+        SCSymbolMap *symbolMap = [compiledSymbolMaps_ objectForKey:[binaryInfo path]];
+        if (symbolMap != nil) {
+            uint64_t mapSymbolAddress;
+            NSString *mapName = [symbolMap nameForAddress:address symbolAddress:&mapSymbolAddress];
+            if (mapName != nil) {
+                name = demangle(mapName);
+                offset = address - mapSymbolAddress;
+            }
+        } else if (![binaryInfo isEncrypted]) {
+            // Determine methods, attempt to match with symbol address.
+            if (symbolAddress != 0) {
+                SCMethodTable *methodTable = [binaryInfo methodTable];
+                size_t index = 0;
+                if ((methodTable != NULL) && (cursors != NULL)) {
+                    SCAddressCursor &methodAddresses = cursors->methodAddresses;
+                    if (methodAddresses.table() == NULL) {
+                        methodAddresses = SCAddressCursor(methodTable->addressTable());
+                    }
+                    index = methodAddresses.indexForAddress(address);
+                } else if (methodTable != NULL) {
+                    index = methodTable->indexForAddress(address);
+                }
+                if ((methodTable != NULL) && (index < methodTable->count()) && (methodTable->addressAtIndex(index) >= symbolAddress)) {
+                    name = methodTable->nameAtIndex(index);
+                    offset = address - methodTable->addressAtIndex(index);
+                } else {
+                    uint64_t textStart = [binaryInfo baseAddress];
+                    name = [NSString stringWithFormat:@"0x%08llx", (symbolAddress - textStart)];
+                    offset = address - symbolAddress;
+                }
+            }
+        }
+
+        if (name != nil) {
+            symbolInfo = [[[SCSymbolInfo alloc] init] autorelease];
+            [symbolInfo setName:name];
+            [symbolInfo setOffset:offset];
+        }
+    }
+
+    return symbolInfo;
+}
+
+@end
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
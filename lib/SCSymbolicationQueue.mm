@@ -0,0 +1,261 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "SCSymbolicationQueue.h"
+
+#import "SCBinaryInfo.h"
+#import "SCBinaryInfo-Private.h"
+#import "SCCrashReport.h"
+#import "SCSymbolicationContext.h"
+
+#include "crashReport.h"
+#include "ipsReport.h"
+
+#include <algorithm>
+#include <vector>
+
+// NOTE: Loads the parts of each binary that are needed for every lookup (the
+//       CoreSymbolication owner and, for binaries with enough addresses in
+//       the request, the symbol address table; see SYMBOL_ADDRESS_SCAN_LIMIT).
+//       Other parts (e.g. methods) are only loaded if a lookup requires them.
+static void loadBinaries(NSArray *binaryInfos) {
+    NSNull *null = [NSNull null];
+    std::vector<SCBinaryInfo *> binaries;
+    binaries.reserve([binaryInfos count]);
+    for (id binaryInfo in binaryInfos) {
+        if (binaryInfo != null) {
+            binaries.push_back(binaryInfo);
+        }
+    }
+    std::sort(binaries.begin(), binaries.end());
+
+    // Count the addresses of each binary.
+    std::vector<std::pair<SCBinaryInfo *, size_t> > counts;
+    for (std::vector<SCBinaryInfo *>::const_iterator i = binaries.begin(); i != binaries.end(); ++i) {
+        if (counts.empty() || (counts.back().first != *i)) {
+            counts.push_back(std::make_pair(*i, 0));
+        }
+        ++counts.back().second;
+    }
+
+    if (!counts.empty()) {
+        const std::pair<SCBinaryInfo *, size_t> *count = &counts[0];
+        dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        dispatch_apply(counts.size(), queue, ^(size_t i) {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            SCBinaryInfo *binaryInfo = count[i].first;
+            [binaryInfo owner];
+            if (count[i].second > SYMBOL_ADDRESS_SCAN_LIMIT) {
+                [binaryInfo symbolAddressTable];
+            }
+            [pool drain];
+        });
+    }
+}
+
+#pragma mark - Crash Reports
+
+// NOTE: Returns NSNull if the image lacks a path or a valid UUID.
+static id binaryInfoForImage(const SCStringView &path, uint64_t address, const SCStringView &architecture, const SCStringView &uuid) {
+    SCBinaryInfo *binaryInfo = SCBinaryInfoCreateForReportImage(path, address, architecture, uuid);
+    return (binaryInfo != nil) ? [binaryInfo autorelease] : [NSNull null];
+}
+
+static BOOL getFramesOfTextReport(const char *data, size_t length, NSMutableArray *addresses, NSMutableArray *binaryInfos) {
+    std::vector<uint64_t> frameAddresses;
+    std::vector<id> imageBinaryInfos;
+    SCCrashImageRanges ranges;
+
+    SCCrashReportParser parser(data, length);
+    SCCrashEvent event;
+    while (parser.next(&event)) {
+        if (event.type == SCCrashEventBinaryImage) {
+            const SCCrashBinaryImage &binaryImage = event.binaryImage;
+            ranges.addImage(binaryImage.address, binaryImage.endAddress, imageBinaryInfos.size());
+            imageBinaryInfos.push_back(binaryInfoForImage(binaryImage.path, binaryImage.address, binaryImage.architecture, binaryImage.uuid));
+        } else if (event.type == SCCrashEventFrame) {
+            frameAddresses.push_back(event.frame.address);
+        }
+    }
+    if (ranges.isEmpty()) {
+        return NO;
+    }
+
+    NSNull *null = [NSNull null];
+    for (std::vector<uint64_t>::const_iterator i = frameAddresses.begin(); i != frameAddresses.end(); ++i) {
+        const uint32_t index = ranges.imageIndexForAddress(*i);
+        [addresses addObject:[NSNumber numberWithUnsignedLongLong:*i]];
+        [binaryInfos addObject:((index != SCCrashImageRanges::kNoImage) ? imageBinaryInfos[index] : null)];
+    }
+    return YES;
+}
+
+static BOOL getFramesOfJSONReport(const char *data, size_t length, NSMutableArray *addresses, NSMutableArray *binaryInfos) {
+    SCIPSReport report;
+    if (!report.parse(data, length)) {
+        return NO;
+    }
+
+    NSNull *null = [NSNull null];
+    const std::vector<SCIPSImage> &images = report.images();
+    std::vector<id> imageBinaryInfos(images.size(), null);
+    std::vector<BOOL> isCreated(images.size(), NO);
+
+    const std::vector<SCIPSThread> &threads = report.threads();
+    const std::vector<SCIPSFrame> &frames = report.frames();
+    for (std::vector<SCIPSThread>::const_iterator thread = threads.begin(); thread != threads.end(); ++thread) {
+        for (uint32_t i = 0; i < thread->frameCount; ++i) {
+            const SCIPSFrame &frame = frames[thread->firstFrame + i];
+            id binaryInfo = null;
+            if (frame.imageIndex < images.size()) {
+                // NOTE: Only images that frames refer to are created.
+                if (!isCreated[frame.imageIndex]) {
+                    const SCIPSImage &image = images[frame.imageIndex];
+                    imageBinaryInfos[frame.imageIndex] = binaryInfoForImage(image.path, image.address, image.architecture, image.uuid);
+                    isCreated[frame.imageIndex] = YES;
+                }
+                binaryInfo = imageBinaryInfos[frame.imageIndex];
+            }
+            [addresses addObject:[NSNumber numberWithUnsignedLongLong:report.addressForFrame(frame)]];
+            [binaryInfos addObject:binaryInfo];
+        }
+    }
+    return YES;
+}
+
+@implementation SCSymbolicationQueue {
+    dispatch_semaphore_t semaphore_;
+    dispatch_group_t group_;
+    volatile int32_t pendingRequests_;
+}
+
+@synthesize maxPendingRequests = maxPendingRequests_;
+
+#pragma mark - Creation & Destruction
+
+- (id)initWithMaxPendingRequests:(NSUInteger)maxPendingRequests {
+    if (maxPendingRequests == 0) {
+        fprintf(stderr, "ERROR: Maximum number of pending requests must be non-zero.\n");
+        [self release];
+        return nil;
+    }
+
+    self = [super init];
+    if (self != nil) {
+        maxPendingRequests_ = maxPendingRequests;
+        semaphore_ = dispatch_semaphore_create(maxPendingRequests);
+        group_ = dispatch_group_create();
+    }
+    return self;
+}
+
+- (id)init {
+    return [self initWithMaxPendingRequests:(4 * [[NSProcessInfo processInfo] activeProcessorCount])];
+}
+
+// NOTE: Each request retains the queue, and so all requests have finished.
+- (void)dealloc {
+    dispatch_release(group_);
+    dispatch_release(semaphore_);
+    [super dealloc];
+}
+
+#pragma mark - Properties
+
+- (NSUInteger)pendingRequests {
+    return pendingRequests_;
+}
+
+#pragma mark - Public Methods
+
+- (BOOL)submitAddresses:(NSArray *)addresses inBinaries:(NSArray *)binaryInfos context:(SCSymbolicationContext *)context timeout:(dispatch_time_t)timeout completionQueue:(dispatch_queue_t)completionQueue completionHandler:(SCSymbolicationCompletionHandler)completionHandler {
+    if ([addresses count] != [binaryInfos count]) {
+        fprintf(stderr, "ERROR: Number of addresses and binaries must match.\n");
+        return NO;
+    }
+
+    if (dispatch_semaphore_wait(semaphore_, timeout) != 0) {
+        return NO;
+    }
+    __sync_add_and_fetch(&pendingRequests_, 1);
+
+    if (completionQueue == NULL) {
+        completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    }
+    dispatch_retain(completionQueue);
+
+    // NOTE: The arrays are copied so that the caller may reuse them.
+    addresses = [addresses copy];
+    binaryInfos = [binaryInfos copy];
+
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_async(group_, queue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        loadBinaries(binaryInfos);
+        NSArray *symbolInfos = [[context symbolInfosForAddresses:addresses inBinaries:binaryInfos] retain];
+        [pool drain];
+
+        dispatch_group_async(group_, completionQueue, ^{
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            completionHandler(symbolInfos);
+            [symbolInfos release];
+            [addresses release];
+            [binaryInfos release];
+            [pool drain];
+        });
+        dispatch_release(completionQueue);
+
+        // NOTE: The bound covers symbolication only; a slow completion
+        //       handler does not hold up other requests.
+        __sync_sub_and_fetch(&pendingRequests_, 1);
+        dispatch_semaphore_signal(semaphore_);
+    });
+
+    return YES;
+}
+
+- (BOOL)submitCrashReport:(NSData *)report context:(SCSymbolicationContext *)context timeout:(dispatch_time_t)timeout completionQueue:(dispatch_queue_t)completionQueue completionHandler:(SCSymbolicationCompletionHandler)completionHandler {
+    BOOL succeeded = NO;
+
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSMutableArray *addresses = [NSMutableArray array];
+    NSMutableArray *binaryInfos = [NSMutableArray array];
+
+    // NOTE: Older .ips reports have a text body following the JSON header.
+    const char *data = reinterpret_cast<const char *>([report bytes]);
+    const size_t length = [report length];
+    const char *body;
+    BOOL isJSON;
+    BOOL isParsed;
+    if (!findIPSReportBody(data, length, &body, &isJSON)) {
+        isParsed = getFramesOfTextReport(data, length, addresses, binaryInfos);
+    } else if (isJSON) {
+        isParsed = getFramesOfJSONReport(data, length, addresses, binaryInfos);
+    } else {
+        isParsed = getFramesOfTextReport(body, (data + length) - body, addresses, binaryInfos);
+    }
+
+    if (isParsed) {
+        succeeded = [self submitAddresses:addresses inBinaries:binaryInfos context:context timeout:timeout
+            completionQueue:completionQueue completionHandler:completionHandler];
+    } else {
+        fprintf(stderr, "ERROR: Failed to parse crash report.\n");
+    }
+    [pool drain];
+
+    return succeeded;
+}
+
+- (void)waitUntilAllRequestsAreFinished {
+    dispatch_group_wait(group_, DISPATCH_TIME_FOREVER);
+}
+
+@end
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
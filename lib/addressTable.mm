@@ -0,0 +1,156 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "addressTable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// NOTE: Number of keys per 64-byte cache line.
+#define CACHE_LINE_SIZE 64
+#define KEYS_PER_CACHE_LINE (CACHE_LINE_SIZE / sizeof(uint64_t))
+
+#pragma mark - Creation & Destruction
+
+SCAddressTable *SCAddressTable::create(const uint64_t *addresses, size_t count) {
+    // NOTE: Ranks are stored as 32-bit values.
+    if (count > UINT32_MAX) {
+        fprintf(stderr, "ERROR: Too many addresses for address table.\n");
+        return NULL;
+    }
+
+    SCAddressTable *table = new SCAddressTable();
+    if (count != 0) {
+        void *keys;
+        if (posix_memalign(&keys, CACHE_LINE_SIZE, (count + 1) * sizeof(uint64_t)) != 0) {
+            fprintf(stderr, "ERROR: Failed to allocate memory for address table.\n");
+            table->release();
+            return NULL;
+        }
+        table->keys_ = reinterpret_cast<uint64_t *>(keys);
+        table->count_ = count;
+        table->depth_ = 64 - __builtin_clzll(count);
+        table->lastLevelCount_ = count - ((1ULL << (table->depth_ - 1)) - 1);
+        table->ranks_.resize(count + 1);
+        for (size_t i = 0; i < count; ++i) {
+            const size_t k = table->layoutIndex(i);
+            table->keys_[k] = addresses[i];
+            table->ranks_[k] = i;
+        }
+    }
+    return table;
+}
+
+SCAddressTable::~SCAddressTable() {
+    free(keys_);
+}
+
+#pragma mark - Public Methods
+
+// NOTE: Each step moves to the left (2k) or right (2k + 1) child, depending on
+//       the comparison, which is added rather than branched on. On leaving the
+//       tree, the trailing one bits of k are the right turns taken since the
+//       last left turn; shifting them (and that left turn) out gives the node
+//       at which the search last went left, which is the result.
+// NOTE: The sixteen descendants four levels below the current node (16k to
+//       16k + 15) are adjacent; as the keys are aligned to a cache line, they
+//       occupy exactly two cache lines, both of which are prefetched.
+// NOTE: Prefetching past the end of the keys is harmless.
+size_t SCAddressTable::lowerBound(uint64_t address) const {
+    const size_t count = count_;
+    const uint64_t *keys = keys_;
+    size_t k = 1;
+    while (k <= count) {
+        __builtin_prefetch(keys + (KEYS_PER_CACHE_LINE * 2) * k);
+        __builtin_prefetch(keys + (KEYS_PER_CACHE_LINE * 2) * k + KEYS_PER_CACHE_LINE);
+        k = (2 * k) + (keys[k] < address);
+    }
+    k >>= __builtin_ffsll(~(unsigned long long)k);
+    return (k != 0) ? ranks_[k] : count;
+}
+
+size_t SCAddressTable::upperBound(uint64_t address) const {
+    const size_t count = count_;
+    const uint64_t *keys = keys_;
+    size_t k = 1;
+    while (k <= count) {
+        __builtin_prefetch(keys + (KEYS_PER_CACHE_LINE * 2) * k);
+        __builtin_prefetch(keys + (KEYS_PER_CACHE_LINE * 2) * k + KEYS_PER_CACHE_LINE);
+        k = (2 * k) + (keys[k] <= address);
+    }
+    k >>= __builtin_ffsll(~(unsigned long long)k);
+    return (k != 0) ? ranks_[k] : count;
+}
+
+size_t SCAddressTable::memoryUsage() const {
+    return sizeof(*this) +
+        (((count_ != 0) ? (count_ + 1) : 0) * sizeof(uint64_t)) +
+        (ranks_.capacity() * sizeof(uint32_t));
+}
+
+#pragma mark - Private Methods
+
+// NOTE: An in-order walk of the implicit tree visits the nodes in sorted order.
+//       In a perfect tree, the node of (one-based) in-order position p is on
+//       the level t above the leaves, where t is the number of trailing zero
+//       bits of p, and the remaining bits of p give its place on that level.
+// NOTE: The last level holds only the leftmost lastLevelCount_ leaves. In the
+//       in-order walk of the perfect tree, the missing leaves are the odd
+//       positions after the first 2 * lastLevelCount_; skipping them maps the
+//       index to its position in the perfect tree.
+size_t SCAddressTable::layoutIndex(size_t index) const {
+    size_t p = index + 1;
+    if (p > (2 * lastLevelCount_)) {
+        p = (2 * p) - (2 * lastLevelCount_);
+    }
+    const unsigned t = __builtin_ctzll(p);
+    return (1ULL << (depth_ - 1 - t)) + (p >> (t + 1));
+}
+
+#pragma mark - SCAddressCursor
+
+// NOTE: Addresses before position_ are known to be less than or equal to the
+//       address. The gallop doubles its step until it passes an address that
+//       is greater, then the upper bound is searched for between the last two
+//       steps.
+size_t SCAddressCursor::indexForAddress(uint64_t address) {
+    const size_t count = this->count();
+    if (count == 0) {
+        return 0;
+    }
+
+    if (address < address_) {
+        position_ = table_->upperBound(address);
+    } else {
+        size_t low = position_;
+        size_t high = position_;
+        size_t step = 1;
+        while ((high < count) && (table_->addressAtIndex(high) <= address)) {
+            low = high + 1;
+            high = low + step;
+            step *= 2;
+        }
+        if (high > count) {
+            high = count;
+        }
+        while (low < high) {
+            const size_t middle = low + ((high - low) / 2);
+            if (table_->addressAtIndex(middle) <= address) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        position_ = low;
+    }
+    address_ = address;
+    return (position_ != 0) ? (position_ - 1) : count;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
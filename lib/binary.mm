@@ -11,51 +11,47 @@
 
 #include <mach-o/fat.h>
 #include <mach-o/loader.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
+#include "input.h"
 
-BOOL offsetAndSizeOfBinaryInFile(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size) {
+BOOL offsetAndSizeOfBinaryInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size) {
+    const uint64_t length = input->size();
     off_t offsetOfBinary = 0;
     size_t sizeOfBinary = 0;
 
-    // Open the file.
-    int fd = open(filepath, O_RDONLY);
-    if (fd < 0) {
-        fprintf(stderr, "ERROR: Failed to open file: %s\n", filepath);
-        return NO;
-    }
-
     // Determine the file type.
     // NOTE: Both fat and mach-o file types (and all other such types,
     //       presumably) start with a uint32_t sized "magic" type identifier.
     uint32_t magic;
-    if (read(fd, &magic, sizeof(magic)) < 0) {
-        fprintf(stderr, "ERROR: Failed to read magic for file: %s\n", filepath);
-        close(fd);
+    if (!input->read(&magic, sizeof(magic), 0)) {
+        fprintf(stderr, "ERROR: Failed to read magic of binary.\n");
         return NO;
     }
 
-    // Determine offset and size of binary to map.
+    // Determine offset and size of binary.
     if ((magic == FAT_MAGIC) || (magic == FAT_CIGAM)) {
         BOOL isSwapped = (magic == FAT_CIGAM);
 
-        uint32_t nfat_arch;
-        if (read(fd, &nfat_arch, sizeof(nfat_arch)) < 0) {
-            fprintf(stderr, "ERROR: Failed to read number of binaries contained in fat file: %s\n", filepath);
-            close(fd);
+        fat_header header;
+        if (!input->read(&header, sizeof(header), 0)) {
+            fprintf(stderr, "ERROR: Failed to read fat header.\n");
             return NO;
         }
+        uint32_t nfat_arch = header.nfat_arch;
         if (isSwapped) {
             nfat_arch = OSSwapInt32(nfat_arch);
         }
 
+        if ((length - sizeof(fat_header)) / sizeof(fat_arch) < nfat_arch) {
+            fprintf(stderr, "ERROR: Architecture structs extend beyond end of fat binary.\n");
+            return NO;
+        }
+
         size_t archsSize = nfat_arch * sizeof(fat_arch);
         fat_arch *archs = reinterpret_cast<fat_arch *>(malloc(archsSize));
         if (archs != NULL) {
-            if (read(fd, archs, archsSize) < 0) {
-                fprintf(stderr, "ERROR: Failed to read architecture structs contained in fat file: %s\n", filepath);
+            if (!input->read(archs, archsSize, sizeof(fat_header))) {
+                fprintf(stderr, "ERROR: Failed to read architecture structs contained in fat binary.\n");
                 free(archs);
-                close(fd);
                 return NO;
             }
 
@@ -80,73 +76,53 @@ BOOL offsetAndSizeOfBinaryInFile(const char *filepath, cpu_type_t cputype, cpu_s
                 }
             }
             free(archs);
+        }
 
-            if (sizeOfBinary > 0) {
-                // Read magic of contained architecture.
-                // NOTE: We want to reposition the offset of the file descriptor
-                //       for reading cpu type information later on.
-                if (lseek(fd, offsetOfBinary, SEEK_SET) < 0) {
-                    fprintf(stderr, "ERROR: Failed to seek to offset of contained architecture in fat file: %s\n", filepath);
-                    close(fd);
-                    return NO;
-                }
+        if (sizeOfBinary == 0) {
+            fprintf(stderr, "ERROR: Requested architecture \"%u %u\" not found in fat binary.\n", cputype, cpusubtype);
+            return NO;
+        }
 
-                if (read(fd, &magic, sizeof(magic)) < 0) {
-                    fprintf(stderr, "ERROR: Failed to read magic of contained architecture in fat file: %s\n", filepath);
-                    close(fd);
-                    return NO;
-                }
-            } else {
-                fprintf(stderr, "ERROR: Requested architecture \"%u %u\" not found in fat file: %s\n", cputype, cpusubtype, filepath);
-                close(fd);
-                return NO;
-            }
+        if (((uint64_t)offsetOfBinary > length) || (sizeOfBinary > length - offsetOfBinary)) {
+            fprintf(stderr, "ERROR: Contained architecture extends beyond end of fat binary.\n");
+            return NO;
         }
-    }
 
-    // Confirm binary is Mach-O.
-    if ((magic == MH_MAGIC_64) || (magic == MH_CIGAM_64) || (magic == MH_MAGIC) || (magic == MH_CIGAM)) {
-        if (sizeOfBinary == 0) {
-            // Set size to size of file.
-            struct stat st;
-            if (fstat(fd, &st) < 0) {
-                fprintf(stderr, "ERROR: Failed to fstat() file: %s\n", filepath);
-                close(fd);
-                return NO;
-            }
-            sizeOfBinary = st.st_size;;
+        // Read magic of contained architecture.
+        if (!input->read(&magic, sizeof(magic), offsetOfBinary)) {
+            fprintf(stderr, "ERROR: Failed to read magic of contained architecture in fat binary.\n");
+            return NO;
         }
     } else {
-        fprintf(stderr, "ERROR: Unknown magic \"0x%x\"for binary in file: %s\n", magic, filepath);
-        close(fd);
+        // Set size to size of input.
+        sizeOfBinary = length;
+    }
+
+    // Confirm binary is Mach-O.
+    if ((magic != MH_MAGIC_64) && (magic != MH_CIGAM_64) && (magic != MH_MAGIC) && (magic != MH_CIGAM)) {
+        fprintf(stderr, "ERROR: Unknown magic \"0x%x\" for binary.\n", magic);
         return NO;
     }
 
     // Confirm binary matches the requested architecture.
     // NOTE: The first six members of 32-bit and 64-bit mach header have the
     //       same name and type.
-    cpu_type_t type;
-    cpu_subtype_t subtype;
-    BOOL isSwapped = ((magic == MH_CIGAM) || (magic == MH_CIGAM_64));
-    if ((read(fd, &type, sizeof(type)) < 0) ||
-        (read(fd, &subtype, sizeof(subtype)) < 0)) {
-        fprintf(stderr, "ERROR: Failed to read cpu type information of binary in file: %s\n", filepath);
-        close(fd);
+    mach_header header;
+    if ((sizeOfBinary < sizeof(header)) || !input->read(&header, sizeof(header), offsetOfBinary)) {
+        fprintf(stderr, "ERROR: Failed to read mach header of binary.\n");
         return NO;
     }
-    if (isSwapped) {
+    cpu_type_t type = header.cputype;
+    cpu_subtype_t subtype = header.cpusubtype;
+    if ((magic == MH_CIGAM) || (magic == MH_CIGAM_64)) {
         type = OSSwapInt32(type);
         subtype = OSSwapInt32(subtype);
     }
     if ((type != cputype) || (subtype != cpusubtype)) {
-        fprintf(stderr, "ERROR: Requested architecture \"%u %u\" not found in file: %s\n", cputype, cpusubtype, filepath);
-        close(fd);
+        fprintf(stderr, "ERROR: Requested architecture \"%u %u\" not found in binary.\n", cputype, cpusubtype);
         return NO;
     }
 
-    // Clean-up.
-    close(fd);
-
     // Output.
     if (offset != NULL) {
         *offset = offsetOfBinary;
@@ -158,59 +134,222 @@ BOOL offsetAndSizeOfBinaryInFile(const char *filepath, cpu_type_t cputype, cpu_s
     return YES;
 }
 
-BOOL isEncrypted(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
-    BOOL isEncrypted = NO;
-
-    // Determine offset and size of the requested architecture in the file.
-    // NOTE: File may contain multiple architectures, or incorrect architecture.
+// NOTE: Maps only the mach header and load commands of the requested
+//       architecture; the mapping must be released with unmapMachHeader().
+static const mach_header *mapMachHeader(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype, uint64_t *mapOffset, size_t *mapLength) {
+    // Determine offset and size of the requested architecture in the input.
+    // NOTE: Input may contain multiple architectures, or incorrect architecture.
     off_t offset;
     size_t size;
-    if (!offsetAndSizeOfBinaryInFile(filepath, cputype, cpusubtype, &offset, &size)) {
-        fprintf(stderr, "ERROR: Failed to determine offset and size of requested architecture in file: %s\n", filepath);
-        return nil;
+    if (!offsetAndSizeOfBinaryInInput(input, cputype, cpusubtype, &offset, &size)) {
+        return NULL;
     }
 
-    // Open the file.
-    int fd = open(filepath, O_RDONLY);
-    if (fd < 0) {
-        fprintf(stderr, "ERROR: Failed to open file: %s\n", filepath);
-        return nil;
+    // Determine if requested architecture is 32-bit or 64-bit.
+    BOOL is32Bit = !(cputype & CPU_ARCH_ABI64);
+    size_t headerSize = (is32Bit ? sizeof(mach_header) : sizeof(mach_header_64));
+
+    mach_header header;
+    if ((size < headerSize) || !input->read(&header, sizeof(header), offset)) {
+        fprintf(stderr, "ERROR: Failed to read mach header of binary.\n");
+        return NULL;
+    }
+    if (header.sizeofcmds > size - headerSize) {
+        fprintf(stderr, "ERROR: Load commands extend beyond end of binary.\n");
+        return NULL;
     }
 
-    // Map the binary.
-    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, offset);
-    close(fd);
+    const size_t length = headerSize + header.sizeofcmds;
+    const mach_header *mapped = reinterpret_cast<const mach_header *>(input->map(offset, length));
+    if (mapped == NULL) {
+        fprintf(stderr, "ERROR: Failed to map load commands of binary.\n");
+        return NULL;
+    }
+
+    *mapOffset = offset;
+    *mapLength = length;
+    return mapped;
+}
+
+static void unmapMachHeader(SCInput *input, const mach_header *header, uint64_t mapOffset, size_t mapLength) {
+    input->unmap(reinterpret_cast<const uint8_t *>(header), mapOffset, mapLength);
+}
+
+// NOTE: Whether the load command is large enough for, and its struct lies
+//       within, the mapped load commands.
+static inline BOOL isLoadCommandOfSize(const load_command *cmd, size_t size, const uint8_t *cmdsEnd) {
+    return (cmd->cmdsize >= size) && (size <= (size_t)(cmdsEnd - reinterpret_cast<const uint8_t *>(cmd)));
+}
+
+BOOL isEncryptedInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    BOOL isEncrypted = NO;
 
-    // Determine encryption status.
-    if (data != MAP_FAILED) {
+    uint64_t mapOffset;
+    size_t mapLength;
+    const mach_header *header = mapMachHeader(input, cputype, cpusubtype, &mapOffset, &mapLength);
+    if (header != NULL) {
         // Determine if requested architecture is 32-bit or 64-bit.
         BOOL is32Bit = !(cputype & CPU_ARCH_ABI64);
         size_t headerSize = (is32Bit ? sizeof(mach_header) : sizeof(mach_header_64));
 
         // Search for encryption info load command.
-        uint8_t *memory = reinterpret_cast<uint8_t *>(data);
-        mach_header *header = reinterpret_cast<mach_header *>(memory);
+        const uint8_t *cmdsEnd = reinterpret_cast<const uint8_t *>(header) + mapLength;
         uint32_t ncmds = header->ncmds;
-        load_command *cmd = reinterpret_cast<load_command *>(memory + headerSize);
+        const load_command *cmd = reinterpret_cast<const load_command *>(reinterpret_cast<const uint8_t *>(header) + headerSize);
         for (uint32_t i = 0; i < ncmds; ++i) {
+            if ((reinterpret_cast<const uint8_t *>(cmd) + sizeof(load_command) > cmdsEnd) || (cmd->cmdsize < sizeof(load_command))) {
+                fprintf(stderr, "ERROR: Encountered malformed load command.\n");
+                break;
+            }
+
             if ((cmd->cmd == LC_ENCRYPTION_INFO) || (cmd->cmd == LC_ENCRYPTION_INFO_64)) {
                 // NOTE: Both 32-bit and 64-bit encryption info structs are the
                 //       same, except for padding at the end.
-                encryption_info_command *enc = reinterpret_cast<encryption_info_command *>(cmd);
+                if (!isLoadCommandOfSize(cmd, sizeof(encryption_info_command), cmdsEnd)) {
+                    fprintf(stderr, "ERROR: Encountered malformed encryption info command.\n");
+                    break;
+                }
+                const encryption_info_command *enc = reinterpret_cast<const encryption_info_command *>(cmd);
                 isEncrypted = (enc->cryptid != 0);
                 break;
             }
 
             // Prepare next command.
-            cmd = reinterpret_cast<load_command *>(reinterpret_cast<uint8_t *>(cmd) + cmd->cmdsize);
+            cmd = reinterpret_cast<const load_command *>(reinterpret_cast<const uint8_t *>(cmd) + cmd->cmdsize);
         }
 
-        munmap(data, size);
-    } else {
-        fprintf(stderr, "ERROR: Failed to mmap file: %s\n", filepath);
+        unmapMachHeader(input, header, mapOffset, mapLength);
+    }
+
+    return isEncrypted;
+}
+
+BOOL isExecutableInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    BOOL isExecutable = NO;
+
+    uint64_t mapOffset;
+    size_t mapLength;
+    const mach_header *header = mapMachHeader(input, cputype, cpusubtype, &mapOffset, &mapLength);
+    if (header != NULL) {
+        isExecutable = (header->filetype == MH_EXECUTE);
+        unmapMachHeader(input, header, mapOffset, mapLength);
+    }
+
+    return isExecutable;
+}
+
+// NOTE: This is the virtual address of the __TEXT segment.
+uint64_t baseAddressOfBinaryInInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    uint64_t baseAddress = 0;
+
+    uint64_t mapOffset;
+    size_t mapLength;
+    const mach_header *header = mapMachHeader(input, cputype, cpusubtype, &mapOffset, &mapLength);
+    if (header != NULL) {
+        // Determine if requested architecture is 32-bit or 64-bit.
+        BOOL is32Bit = !(cputype & CPU_ARCH_ABI64);
+        size_t headerSize = (is32Bit ? sizeof(mach_header) : sizeof(mach_header_64));
+
+        // Search for __TEXT segment load command.
+        const uint8_t *cmdsEnd = reinterpret_cast<const uint8_t *>(header) + mapLength;
+        uint32_t ncmds = header->ncmds;
+        const load_command *cmd = reinterpret_cast<const load_command *>(reinterpret_cast<const uint8_t *>(header) + headerSize);
+        for (uint32_t i = 0; i < ncmds; ++i) {
+            if ((reinterpret_cast<const uint8_t *>(cmd) + sizeof(load_command) > cmdsEnd) || (cmd->cmdsize < sizeof(load_command))) {
+                fprintf(stderr, "ERROR: Encountered malformed load command.\n");
+                break;
+            }
+
+            if (cmd->cmd == LC_SEGMENT) {
+                if (!isLoadCommandOfSize(cmd, sizeof(segment_command), cmdsEnd)) {
+                    fprintf(stderr, "ERROR: Encountered malformed segment command.\n");
+                    break;
+                }
+                const segment_command *seg = reinterpret_cast<const segment_command *>(cmd);
+                if (strncmp(seg->segname, "__TEXT", sizeof(seg->segname)) == 0) {
+                    baseAddress = seg->vmaddr;
+                    break;
+                }
+            } else if (cmd->cmd == LC_SEGMENT_64) {
+                if (!isLoadCommandOfSize(cmd, sizeof(segment_command_64), cmdsEnd)) {
+                    fprintf(stderr, "ERROR: Encountered malformed segment command.\n");
+                    break;
+                }
+                const segment_command_64 *seg = reinterpret_cast<const segment_command_64 *>(cmd);
+                if (strncmp(seg->segname, "__TEXT", sizeof(seg->segname)) == 0) {
+                    baseAddress = seg->vmaddr;
+                    break;
+                }
+            }
+
+            // Prepare next command.
+            cmd = reinterpret_cast<const load_command *>(reinterpret_cast<const uint8_t *>(cmd) + cmd->cmdsize);
+        }
+
+        unmapMachHeader(input, header, mapOffset, mapLength);
     }
 
+    return baseAddress;
+}
+
+#pragma mark - File
+
+BOOL offsetAndSizeOfBinaryInFile(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size) {
+    SCInput *input = SCInputCreateWithPath(filepath);
+    if (input == NULL) {
+        return NO;
+    }
+
+    BOOL result = offsetAndSizeOfBinaryInInput(input, cputype, cpusubtype, offset, size);
+    if (!result) {
+        fprintf(stderr, "ERROR: Failed to locate requested architecture in file: %s\n", filepath);
+    }
+
+    input->release();
+
+    return result;
+}
+
+BOOL isEncrypted(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    SCInput *input = SCInputCreateWithPath(filepath);
+    if (input == NULL) {
+        return NO;
+    }
+
+    BOOL isEncrypted = isEncryptedInInput(input, cputype, cpusubtype);
+    input->release();
+
     return isEncrypted;
 }
 
+#pragma mark - Memory
+
+BOOL offsetAndSizeOfBinaryInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype, off_t *offset, size_t *size) {
+    SCInput *input = SCInputCreateWithMemory(memory, length);
+    BOOL result = offsetAndSizeOfBinaryInInput(input, cputype, cpusubtype, offset, size);
+    input->release();
+    return result;
+}
+
+BOOL isEncryptedInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    SCInput *input = SCInputCreateWithMemory(memory, length);
+    BOOL isEncrypted = isEncryptedInInput(input, cputype, cpusubtype);
+    input->release();
+    return isEncrypted;
+}
+
+BOOL isExecutableInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    SCInput *input = SCInputCreateWithMemory(memory, length);
+    BOOL isExecutable = isExecutableInInput(input, cputype, cpusubtype);
+    input->release();
+    return isExecutable;
+}
+
+uint64_t baseAddressOfBinaryInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    SCInput *input = SCInputCreateWithMemory(memory, length);
+    uint64_t baseAddress = baseAddressOfBinaryInInput(input, cputype, cpusubtype);
+    input->release();
+    return baseAddress;
+}
+
 /* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
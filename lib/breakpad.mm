@@ -0,0 +1,157 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#import "breakpad.h"
+
+#import "SCBinaryInfo.h"
+#import "SCBinaryInfo-Private.h"
+
+#include "CoreSymbolication.h"
+#include "demangle.h"
+#include "image.h"
+#include "symbols.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef struct _SCLineRecord {
+    uint64_t address;
+    uint64_t size;
+    unsigned line;
+    const char *path;
+} SCLineRecord;
+
+static bool compareLineRecords(const SCLineRecord &a, const SCLineRecord &b) {
+    return a.address < b.address;
+}
+
+static const char *demangledName(const char *name) {
+    NSString *string = [NSString stringWithUTF8String:name];
+    return (string != nil) ? [demangle(string) UTF8String] : name;
+}
+
+static void writeFunction(FILE *file, uint64_t address, uint64_t size, uint64_t baseAddress, const char *name, CSSymbolOwnerRef owner, std::map<std::string, unsigned> &files) {
+    std::vector<SCLineRecord> lines;
+
+    if (!CSIsNull(owner)) {
+        CSSymbolRef symbol = CSSymbolOwnerGetSymbolWithAddress(owner, address);
+        if (!CSIsNull(symbol)) {
+            if (name == NULL) {
+                name = CSSymbolGetName(symbol);
+                if ((name != NULL) && (strcmp(name, "<redacted>") == 0)) {
+                    name = NULL;
+                }
+            }
+
+            std::vector<SCLineRecord> *linesRef = &lines;
+            CSSymbolForeachSourceInfo(symbol, ^(CSSourceInfoRef sourceInfo) {
+                const char *path = CSSourceInfoGetPath(sourceInfo);
+                if (path != NULL) {
+                    CSRange range = CSSourceInfoGetRange(sourceInfo);
+                    SCLineRecord record = {range.location, range.length, (unsigned)CSSourceInfoGetLineNumber(sourceInfo), path};
+                    linesRef->push_back(record);
+                }
+                return 0;
+            });
+            std::sort(lines.begin(), lines.end(), compareLineRecords);
+        }
+    }
+
+    // NOTE: FILE records must precede the line records that refer to them.
+    for (std::vector<SCLineRecord>::iterator i = lines.begin(); i != lines.end(); ++i) {
+        std::string path(i->path);
+        if (files.find(path) == files.end()) {
+            unsigned index = files.size();
+            files[path] = index;
+            fprintf(file, "FILE %u %s\n", index, i->path);
+        }
+    }
+
+    if (name != NULL) {
+        fprintf(file, "FUNC %llx %llx 0 %s\n", address - baseAddress, size, demangledName(name));
+    } else {
+        // NOTE: Use the same placeholder that SCSymbolicator uses for unnamed
+        //       functions.
+        fprintf(file, "FUNC %llx %llx 0 0x%08llx\n", address - baseAddress, size, address - baseAddress);
+    }
+
+    for (std::vector<SCLineRecord>::iterator i = lines.begin(); i != lines.end(); ++i) {
+        fprintf(file, "%llx %llx %u %u\n", i->address - baseAddress, i->size, i->line, files[std::string(i->path)]);
+    }
+}
+
+static BOOL writeBreakpadSymbols(SCSymbolCursor *cursor, const char *architecture, const char *moduleName, CSSymbolOwnerRef owner, FILE *file) {
+    SCMachOImage *image = cursor->image();
+
+    // Write module record.
+    // NOTE: The identifier is the UUID followed by an "age" of zero.
+    fprintf(file, "MODULE mac %s ", architecture);
+    const uint8_t *uuid = image->uuid();
+    for (unsigned i = 0; i < 16; ++i) {
+        fprintf(file, "%02X", (uuid != NULL) ? uuid[i] : 0);
+    }
+    fprintf(file, "0 %s\n", moduleName);
+
+    // Write records in address order.
+    const uint64_t baseAddress = image->baseAddress();
+    std::map<std::string, unsigned> files;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    SCSymbolRecord record;
+    for (unsigned recordCount = 1; cursor->next(&record); ++recordCount) {
+        if (record.isFunctionStart) {
+            writeFunction(file, record.address, record.size, baseAddress, record.name, owner, files);
+        } else {
+            fprintf(file, "PUBLIC %llx 0 %s\n", record.address - baseAddress, demangledName(record.name));
+        }
+
+        // NOTE: Drain periodically so that memory use does not grow with the
+        //       number of records.
+        if ((recordCount % 1024) == 0) {
+            [pool drain];
+            pool = [[NSAutoreleasePool alloc] init];
+        }
+    }
+    [pool drain];
+
+    return (ferror(file) == 0);
+}
+
+BOOL writeBreakpadSymbolsForBinary(SCBinaryInfo *binaryInfo, FILE *file) {
+    SCSymbolCursor *cursor = SCSymbolCursor::createWithBinaryInfo(binaryInfo);
+    if (cursor == NULL) {
+        return NO;
+    }
+
+    BOOL result = writeBreakpadSymbols(cursor, [[binaryInfo architecture] UTF8String], [[[binaryInfo path] lastPathComponent] UTF8String], [binaryInfo owner], file);
+    delete cursor;
+
+    return result;
+}
+
+// NOTE: Methods and source lines are not available for dylibs in the shared
+//       cache; function starts, exported symbols and local symbols are used.
+BOOL writeBreakpadSymbolsForSharedCacheDylib(const char *sharedCachePath, const char *dylibPath, const char *architecture, FILE *file) {
+    SCSymbolCursor *cursor = SCSymbolCursor::createWithSharedCache(sharedCachePath, dylibPath);
+    if (cursor == NULL) {
+        return NO;
+    }
+
+    const char *moduleName = strrchr(dylibPath, '/');
+    moduleName = (moduleName != NULL) ? (moduleName + 1) : dylibPath;
+
+    CSSymbolOwnerRef owner = {NULL, NULL};
+    BOOL result = writeBreakpadSymbols(cursor, architecture, moduleName, owner, file);
+    delete cursor;
+
+    return result;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,466 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "crashReport.h"
+
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+
+#pragma mark - Helpers
+
+static inline BOOL isSpace(char c) {
+    return (c == ' ') || (c == '\t');
+}
+
+static inline BOOL isDigit(char c) {
+    return (c >= '0') && (c <= '9');
+}
+
+static inline const char *skipSpaces(const char *p, const char *end) {
+    while ((p < end) && isSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static inline const char *skipToken(const char *p, const char *end) {
+    while ((p < end) && !isSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static inline SCStringView makeView(const char *start, const char *end) {
+    while ((start < end) && isSpace(*start)) {
+        ++start;
+    }
+    while ((end > start) && isSpace(*(end - 1))) {
+        --end;
+    }
+    SCStringView view = {start, (size_t)(end - start)};
+    return view;
+}
+
+static inline BOOL hasPrefix(const char *p, const char *end, const char *prefix) {
+    const size_t length = strlen(prefix);
+    return ((size_t)(end - p) >= length) && (memcmp(p, prefix, length) == 0);
+}
+
+// NOTE: Fails if the value does not fit in an int.
+static BOOL parseDecimal(const char **p, const char *end, int *value) {
+    const char *q = *p;
+    int result = 0;
+    while ((q < end) && isDigit(*q)) {
+        const int digit = *q - '0';
+        if (result > ((INT_MAX - digit) / 10)) {
+            return NO;
+        }
+        result = (result * 10) + digit;
+        ++q;
+    }
+    if (q == *p) {
+        return NO;
+    }
+    *p = q;
+    *value = result;
+    return YES;
+}
+
+// NOTE: Requires the "0x" prefix.
+static BOOL parseHex(const char **p, const char *end, uint64_t *value) {
+    const char *q = *p;
+    if (!hasPrefix(q, end, "0x")) {
+        return NO;
+    }
+    q += 2;
+
+    const char *start = q;
+    uint64_t result = 0;
+    for (; q < end; ++q) {
+        const char c = *q;
+        unsigned digit;
+        if (isDigit(c)) {
+            digit = c - '0';
+        } else if ((c >= 'a') && (c <= 'f')) {
+            digit = c - 'a' + 10;
+        } else if ((c >= 'A') && (c <= 'F')) {
+            digit = c - 'A' + 10;
+        } else {
+            break;
+        }
+        result = (result << 4) | digit;
+    }
+    if (q == start) {
+        return NO;
+    }
+    *p = q;
+    *value = result;
+    return YES;
+}
+
+#pragma mark - Creation & Destruction
+
+SCCrashReportParser::SCCrashReportParser(const char *data, size_t length) :
+    p_(data), end_(data + length), line_(data), lineEnd_(data),
+    section_(SCSectionHeader), threadIndex_(0), threadNameIndex_(-1) {
+    threadName_.data = NULL;
+    threadName_.length = 0;
+}
+
+#pragma mark - Public Methods
+
+BOOL SCCrashReportParser::next(SCCrashEvent *event) {
+    memset(event, 0, sizeof(*event));
+
+    for (;;) {
+        if (line_ >= lineEnd_) {
+            if (!nextLine()) {
+                return NO;
+            }
+            if (parseSectionStart(event)) {
+                return YES;
+            }
+        }
+        if ((line_ < lineEnd_) && parseLine(event)) {
+            return YES;
+        }
+    }
+}
+
+#pragma mark - Private Methods
+
+BOOL SCCrashReportParser::nextLine() {
+    if (p_ >= end_) {
+        return NO;
+    }
+
+    const char *newline = static_cast<const char *>(memchr(p_, '\n', end_ - p_));
+    line_ = p_;
+    lineEnd_ = (newline != NULL) ? newline : end_;
+    p_ = (newline != NULL) ? (newline + 1) : end_;
+
+    // NOTE: Logs may have been saved with DOS line endings.
+    if ((lineEnd_ > line_) && (*(lineEnd_ - 1) == '\r')) {
+        --lineEnd_;
+    }
+    return YES;
+}
+
+// NOTE: Returns YES if the line starts a section and produces an event. The
+//       line is consumed if it starts a section, whether or not it produces an
+//       event.
+BOOL SCCrashReportParser::parseSectionStart(SCCrashEvent *event) {
+    const char *p = line_;
+    const char *end = lineEnd_;
+
+    if (skipSpaces(p, end) == end) {
+        // NOTE: Backtraces and thread states end with a blank line. Binary
+        //       images are the last section of a log.
+        if (section_ != SCSectionBinaryImages) {
+            section_ = SCSectionHeader;
+        }
+        line_ = lineEnd_;
+        return NO;
+    }
+
+    if (hasPrefix(p, end, "Binary Images:")) {
+        section_ = SCSectionBinaryImages;
+        line_ = lineEnd_;
+        return NO;
+    }
+
+    if (hasPrefix(p, end, "Last Exception Backtrace:")) {
+        section_ = SCSectionBacktrace;
+        threadIndex_ = -1;
+        event->type = SCCrashEventThread;
+        event->thread.index = -1;
+        line_ = lineEnd_;
+        return YES;
+    }
+
+    if (hasPrefix(p, end, "Thread ")) {
+        p += 7;
+        int index;
+        if (!parseDecimal(&p, end, &index)) {
+            return NO;
+        }
+
+        if (hasPrefix(p, end, " name:")) {
+            threadNameIndex_ = index;
+            threadName_ = makeView(p + 6, end);
+            line_ = lineEnd_;
+            return NO;
+        }
+
+        if (hasPrefix(p, end, " crashed with ")) {
+            // e.g. "Thread 0 crashed with ARM Thread State (64-bit):"
+            p += 14;
+            const char *colon = end;
+            while ((colon > p) && (*(colon - 1) != ':')) {
+                --colon;
+            }
+            section_ = SCSectionThreadState;
+            threadIndex_ = index;
+            event->type = SCCrashEventThreadState;
+            event->threadState.threadIndex = index;
+            event->threadState.flavor = makeView(p, (colon > p) ? (colon - 1) : end);
+            line_ = lineEnd_;
+            return YES;
+        }
+
+        BOOL isCrashed = NO;
+        if (hasPrefix(p, end, " Crashed:")) {
+            isCrashed = YES;
+        } else if (!hasPrefix(p, end, ":")) {
+            return NO;
+        }
+
+        section_ = SCSectionBacktrace;
+        threadIndex_ = index;
+        event->type = SCCrashEventThread;
+        event->thread.index = index;
+        event->thread.isCrashed = isCrashed;
+        if (threadNameIndex_ == index) {
+            event->thread.name = threadName_;
+        }
+        line_ = lineEnd_;
+        return YES;
+    }
+
+    return NO;
+}
+
+BOOL SCCrashReportParser::parseLine(SCCrashEvent *event) {
+    switch (section_) {
+        case SCSectionBacktrace: {
+            // NOTE: The remainder of a partially parsed address list starts
+            //       with an address; a frame never does.
+            const char *p = skipSpaces(line_, lineEnd_);
+            if ((p < lineEnd_) && ((*p == '(') || hasPrefix(p, lineEnd_, "0x"))) {
+                return parseAddressList(event);
+            }
+            return parseFrame(event);
+        }
+        case SCSectionThreadState:
+            return parseRegister(event);
+        case SCSectionBinaryImages:
+            return parseBinaryImage(event);
+        default:
+            return parseHeaderField(event);
+    }
+}
+
+// e.g. "3   UIKit                         0x2f0a3f8f -[UIView layoutSubviews] + 42"
+// NOTE: Image names may contain spaces; the name ends at the address.
+BOOL SCCrashReportParser::parseFrame(SCCrashEvent *event) {
+    const char *p = skipSpaces(line_, lineEnd_);
+    const char *end = lineEnd_;
+    line_ = lineEnd_;
+
+    int index;
+    if (!parseDecimal(&p, end, &index) || (p == end) || !isSpace(*p)) {
+        return NO;
+    }
+
+    const char *nameStart = p;
+    const char *addressStart = NULL;
+    for (const char *q = p; (q + 2) < end; ++q) {
+        if (isSpace(*q) && (q[1] == '0') && (q[2] == 'x')) {
+            addressStart = q + 1;
+            break;
+        }
+    }
+    if (addressStart == NULL) {
+        return NO;
+    }
+
+    p = addressStart;
+    uint64_t address;
+    if (!parseHex(&p, end, &address)) {
+        return NO;
+    }
+
+    event->type = SCCrashEventFrame;
+    event->frame.threadIndex = threadIndex_;
+    event->frame.index = index;
+    event->frame.address = address;
+    event->frame.imageName = makeView(nameStart, addressStart);
+    event->frame.symbol = makeView(p, end);
+    return YES;
+}
+
+// e.g. "(0x2d7bae83 0x3834e6c7 0x2d6f1d7b)"
+BOOL SCCrashReportParser::parseAddressList(SCCrashEvent *event) {
+    const char *p = line_;
+    const char *end = lineEnd_;
+    while (p < end) {
+        p = skipSpaces(p, end);
+        if ((p < end) && ((*p == '(') || (*p == ')'))) {
+            ++p;
+            continue;
+        }
+
+        uint64_t address;
+        if (parseHex(&p, end, &address)) {
+            line_ = p;
+            event->type = SCCrashEventFrame;
+            event->frame.threadIndex = threadIndex_;
+            event->frame.index = -1;
+            event->frame.address = address;
+            return YES;
+        }
+        p = skipToken(p, end);
+    }
+    line_ = lineEnd_;
+    return NO;
+}
+
+// e.g. "    r0: 0x00000000    r1: 0x00000001    r2: 0x00000000    r3: 0x00000000"
+BOOL SCCrashReportParser::parseRegister(SCCrashEvent *event) {
+    const char *p = skipSpaces(line_, lineEnd_);
+    const char *end = lineEnd_;
+
+    const char *nameStart = p;
+    while ((p < end) && (*p != ':') && !isSpace(*p)) {
+        ++p;
+    }
+    const char *nameEnd = p;
+    if ((p == end) || (*p != ':') || (nameEnd == nameStart)) {
+        line_ = lineEnd_;
+        return NO;
+    }
+
+    p = skipSpaces(p + 1, end);
+    uint64_t value;
+    if (!parseHex(&p, end, &value)) {
+        line_ = lineEnd_;
+        return NO;
+    }
+    line_ = p;
+
+    event->type = SCCrashEventRegister;
+    event->reg.threadIndex = threadIndex_;
+    event->reg.name = makeView(nameStart, nameEnd);
+    event->reg.value = value;
+    return YES;
+}
+
+// e.g. "0x9c000 - 0x1a3fff +MobileSafari armv7  <a2b4c6d8...> /Applications/..."
+// NOTE: Image names may contain spaces; the architecture is the last word
+//       before the UUID.
+BOOL SCCrashReportParser::parseBinaryImage(SCCrashEvent *event) {
+    const char *p = skipSpaces(line_, lineEnd_);
+    const char *end = lineEnd_;
+    line_ = lineEnd_;
+
+    uint64_t address;
+    uint64_t endAddress;
+    if (!parseHex(&p, end, &address)) {
+        return NO;
+    }
+    p = skipSpaces(p, end);
+    if ((p == end) || (*p != '-')) {
+        return NO;
+    }
+    p = skipSpaces(p + 1, end);
+    if (!parseHex(&p, end, &endAddress)) {
+        return NO;
+    }
+    p = skipSpaces(p, end);
+
+    SCCrashBinaryImage &image = event->binaryImage;
+    if ((p < end) && (*p == '+')) {
+        image.isUserImage = YES;
+        ++p;
+    }
+
+    const char *uuidStart = static_cast<const char *>(memchr(p, '<', end - p));
+    const char *uuidEnd = (uuidStart != NULL) ? static_cast<const char *>(memchr(uuidStart, '>', end - uuidStart)) : NULL;
+    if (uuidEnd != NULL) {
+        // Find the architecture, the last word before the UUID.
+        const char *archEnd = uuidStart;
+        while ((archEnd > p) && isSpace(*(archEnd - 1))) {
+            --archEnd;
+        }
+        const char *archStart = archEnd;
+        while ((archStart > p) && !isSpace(*(archStart - 1))) {
+            --archStart;
+        }
+        image.name = makeView(p, archStart);
+        image.architecture = makeView(archStart, archEnd);
+        image.uuid = makeView(uuidStart + 1, uuidEnd);
+        image.path = makeView(uuidEnd + 1, end);
+    } else {
+        // NOTE: Without a UUID, the name is assumed to be a single word.
+        const char *nameEnd = skipToken(p, end);
+        const char *archStart = skipSpaces(nameEnd, end);
+        const char *archEnd = skipToken(archStart, end);
+        image.name = makeView(p, nameEnd);
+        image.architecture = makeView(archStart, archEnd);
+        image.path = makeView(archEnd, end);
+    }
+
+    event->type = SCCrashEventBinaryImage;
+    image.address = address;
+    image.endAddress = endAddress;
+    return YES;
+}
+
+// e.g. "Hardware Model:      iPhone6,1"
+BOOL SCCrashReportParser::parseHeaderField(SCCrashEvent *event) {
+    const char *p = line_;
+    const char *end = lineEnd_;
+    line_ = lineEnd_;
+
+    if (isSpace(*p)) {
+        return NO;
+    }
+
+    const char *colon = static_cast<const char *>(memchr(p, ':', end - p));
+    if ((colon == NULL) || (colon == p)) {
+        return NO;
+    }
+
+    event->type = SCCrashEventHeaderField;
+    event->headerField.key = makeView(p, colon);
+    event->headerField.value = makeView(colon + 1, end);
+    return YES;
+}
+
+#pragma mark - SCCrashImageRanges
+
+void SCCrashImageRanges::addImage(uint64_t address, uint64_t endAddress, uint32_t index) {
+    SCImageRange range = {address, endAddress, index};
+    if (!ranges_.empty() && (address < ranges_.back().address)) {
+        isSorted_ = NO;
+    }
+    ranges_.push_back(range);
+}
+
+uint32_t SCCrashImageRanges::imageIndexForAddress(uint64_t address) {
+    if (!isSorted_) {
+        std::sort(ranges_.begin(), ranges_.end(), compareRanges);
+        isSorted_ = YES;
+    }
+
+    SCImageRange key = {address, 0, 0};
+    std::vector<SCImageRange>::const_iterator i = std::upper_bound(ranges_.begin(), ranges_.end(), key, compareRanges);
+    if (i == ranges_.begin()) {
+        return kNoImage;
+    }
+    --i;
+    return (address <= i->endAddress) ? i->index : kNoImage;
+}
+
+bool SCCrashImageRanges::compareRanges(const SCImageRange &a, const SCImageRange &b) {
+    return a.address < b.address;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
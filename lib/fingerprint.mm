@@ -0,0 +1,160 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "fingerprint.h"
+
+#define NUM_SHARDS 16
+
+// NOTE: Approximate size of the bookkeeping of an entry (map node, list node).
+static const size_t kEntryCost = 128;
+
+// NOTE: Tags of the records of a fingerprint.
+enum {
+    SCRecordBacktrace = 'B',
+    SCRecordFrame = 'F',
+    SCRecordAddress = 'A'
+};
+
+static inline void appendValue(std::string &key, uint64_t value) {
+    for (unsigned i = 0; i < 8; ++i) {
+        key += (char)(value >> (8 * i));
+    }
+}
+
+static inline int valueForHexDigit(char c) {
+    if ((c >= '0') && (c <= '9')) return c - '0';
+    if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+    return -1;
+}
+
+#pragma mark - Fingerprint
+
+BOOL SCBacktraceFingerprint::addFrame(const SCStringView &uuid, uint64_t imageAddress, uint64_t address) {
+    uint8_t bytes[16];
+    unsigned numDigits = 0;
+    for (size_t i = 0; i < uuid.length; ++i) {
+        const int value = valueForHexDigit(uuid.data[i]);
+        if (value < 0) {
+            continue;
+        }
+        if (numDigits == 32) {
+            numDigits = 0;
+            break;
+        }
+        if ((numDigits % 2) == 0) {
+            bytes[numDigits / 2] = value << 4;
+        } else {
+            bytes[numDigits / 2] |= value;
+        }
+        ++numDigits;
+    }
+    if (numDigits != 32) {
+        addFrame(address);
+        return NO;
+    }
+
+    key_ += (char)SCRecordFrame;
+    key_.append(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    appendValue(key_, address - imageAddress);
+    return YES;
+}
+
+void SCBacktraceFingerprint::addFrame(uint64_t address) {
+    key_ += (char)SCRecordAddress;
+    appendValue(key_, address);
+}
+
+void SCBacktraceFingerprint::addBacktrace(int index) {
+    key_ += (char)SCRecordBacktrace;
+    appendValue(key_, (uint64_t)(int64_t)index);
+}
+
+// NOTE: FNV-1a.
+uint64_t SCBacktraceFingerprint::hash() const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::string::const_iterator i = key_.begin(); i != key_.end(); ++i) {
+        hash ^= (uint8_t)*i;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#pragma mark - Cache
+
+SCFingerprintCache *SCFingerprintCache::create(size_t capacity) {
+    return new SCFingerprintCache((capacity + NUM_SHARDS - 1) / NUM_SHARDS);
+}
+
+SCFingerprintCache::SCFingerprintCache(size_t capacityPerShard) :
+    refCount_(1), capacityPerShard_(capacityPerShard), hits_(0), misses_(0) {
+    shards_ = new SCShard[NUM_SHARDS];
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+        pthread_mutex_init(&shards_[i].mutex, NULL);
+        shards_[i].size = 0;
+    }
+}
+
+SCFingerprintCache::~SCFingerprintCache() {
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+        pthread_mutex_destroy(&shards_[i].mutex);
+    }
+    delete[] shards_;
+}
+
+BOOL SCFingerprintCache::lookup(const SCBacktraceFingerprint &fingerprint, std::string &value) {
+    SCShard &shard = shards_[fingerprint.hash() % NUM_SHARDS];
+
+    BOOL isHit = NO;
+    pthread_mutex_lock(&shard.mutex);
+    std::map<std::string, SCEntry>::iterator it = shard.entries.find(fingerprint.key());
+    if (it != shard.entries.end()) {
+        SCEntry &entry = it->second;
+        shard.order.splice(shard.order.begin(), shard.order, entry.order);
+        value = entry.value;
+        isHit = YES;
+    }
+    pthread_mutex_unlock(&shard.mutex);
+
+    __sync_add_and_fetch(isHit ? &hits_ : &misses_, 1);
+    return isHit;
+}
+
+// NOTE: Another thread may have inserted the same fingerprint in the meantime,
+//       in which case the existing entry is kept.
+void SCFingerprintCache::insert(const SCBacktraceFingerprint &fingerprint, const std::string &value) {
+    const std::string &key = fingerprint.key();
+    const size_t cost = key.size() + value.size() + kEntryCost;
+    if (cost > capacityPerShard_) {
+        return;
+    }
+
+    SCShard &shard = shards_[fingerprint.hash() % NUM_SHARDS];
+    pthread_mutex_lock(&shard.mutex);
+    std::pair<std::map<std::string, SCEntry>::iterator, bool> result =
+        shard.entries.insert(std::make_pair(key, SCEntry()));
+    if (result.second) {
+        SCEntry &entry = result.first->second;
+        entry.value = value;
+        shard.order.push_front(&result.first->first);
+        entry.order = shard.order.begin();
+        shard.size += cost;
+
+        // Remove the least recently used entries.
+        while (shard.size > capacityPerShard_) {
+            std::map<std::string, SCEntry>::iterator oldest = shard.entries.find(*shard.order.back());
+            shard.size -= oldest->first.size() + oldest->second.value.size() + kEntryCost;
+            shard.order.pop_back();
+            shard.entries.erase(oldest);
+        }
+    }
+    pthread_mutex_unlock(&shard.mutex);
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
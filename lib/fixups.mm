@@ -0,0 +1,249 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "fixups.h"
+
+#include <libkern/OSByteOrder.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// NOTE: Formats and layouts are from mach-o/fixup-chains.h (from dyld-852
+//       source). They are declared here as that header is not available in
+//       older SDKs.
+#define DYLD_CHAINED_PTR_ARM64E            1
+#define DYLD_CHAINED_PTR_64                2
+#define DYLD_CHAINED_PTR_64_OFFSET         6
+#define DYLD_CHAINED_PTR_ARM64E_USERLAND   9
+#define DYLD_CHAINED_PTR_ARM64E_USERLAND24 12
+
+#define DYLD_CHAINED_PTR_START_NONE  0xffff
+#define DYLD_CHAINED_PTR_START_MULTI 0x8000
+
+#define DYLD_CHAINED_IMPORT          1
+#define DYLD_CHAINED_IMPORT_ADDEND   2
+#define DYLD_CHAINED_IMPORT_ADDEND64 3
+
+// NOTE: All fields are little endian.
+typedef struct _dyld_chained_fixups_header {
+    uint32_t fixups_version;
+    uint32_t starts_offset;
+    uint32_t imports_offset;
+    uint32_t symbols_offset;
+    uint32_t imports_count;
+    uint32_t imports_format;
+    uint32_t symbols_format;
+} dyld_chained_fixups_header;
+
+// NOTE: The segment start structure is not naturally aligned, and so its
+//       fields are read at these offsets.
+#define STARTS_SEGMENT_PAGE_SIZE      4
+#define STARTS_SEGMENT_POINTER_FORMAT 6
+#define STARTS_SEGMENT_PAGE_COUNT     20
+#define STARTS_SEGMENT_PAGE_START     22
+
+static inline uint16_t read16(const uint8_t *data) { return OSReadLittleInt16(data, 0); }
+static inline uint32_t read32(const uint8_t *data) { return OSReadLittleInt32(data, 0); }
+static inline uint64_t read64(const uint8_t *data) { return OSReadLittleInt64(data, 0); }
+
+#pragma mark - Creation & Destruction
+
+SCChainedFixups *SCChainedFixups::create(const uint8_t *data, uint32_t dataSize, const std::vector<SCSegmentInfo> &segments) {
+    if ((data == NULL) || (dataSize < sizeof(dyld_chained_fixups_header))) {
+        fprintf(stderr, "ERROR: Chained fixups data is out of bounds.\n");
+        return NULL;
+    }
+
+    if (read32(data + offsetof(dyld_chained_fixups_header, fixups_version)) != 0) {
+        fprintf(stderr, "ERROR: Unsupported chained fixups version.\n");
+        return NULL;
+    }
+
+    SCChainedFixups *fixups = new SCChainedFixups();
+    if (!fixups->parseStarts(data, dataSize, segments)) {
+        delete fixups;
+        return NULL;
+    }
+
+    // NOTE: Import names are only used for display; failure to read them is
+    //       not fatal.
+    fixups->parseImports(data, dataSize);
+    return fixups;
+}
+
+#pragma mark - Public Methods
+
+SCFixupKind SCChainedFixups::fixupAtOffset(uint64_t offset, uint64_t raw, uint64_t *value) const {
+    for (std::vector<SCFixupSegment>::const_iterator i = segments_.begin(); i != segments_.end(); ++i) {
+        if ((offset < i->fileoff) || ((offset - i->fileoff) >= i->filesize)) {
+            continue;
+        }
+
+        // NOTE: Pointers only hold fixups on pages that have a chain, from
+        //       the start of that chain onward. A zero value is never part of
+        //       a chain.
+        const uint64_t page = (offset - i->fileoff) / i->pageSize;
+        if ((page >= i->pageCount) || (raw == 0)) {
+            break;
+        }
+        const uint16_t pageStart = pageStarts_[i->firstPage + page];
+        if ((pageStart == DYLD_CHAINED_PTR_START_NONE) || (pageStart & DYLD_CHAINED_PTR_START_MULTI) ||
+                (((offset - i->fileoff) % i->pageSize) < pageStart)) {
+            break;
+        }
+
+        BOOL isBind;
+        if ((i->pointerFormat == DYLD_CHAINED_PTR_64) || (i->pointerFormat == DYLD_CHAINED_PTR_64_OFFSET)) {
+            isBind = (raw >> 63) & 1;
+            if (isBind) {
+                *value = raw & 0xffffff;
+            } else {
+                *value = raw & 0xfffffffffULL;
+                if (i->pointerFormat == DYLD_CHAINED_PTR_64_OFFSET) {
+                    *value += baseAddress_;
+                }
+            }
+        } else {
+            const BOOL isAuth = (raw >> 63) & 1;
+            isBind = (raw >> 62) & 1;
+            if (isBind) {
+                *value = raw & ((i->pointerFormat == DYLD_CHAINED_PTR_ARM64E_USERLAND24) ? 0xffffff : 0xffff);
+            } else if (isAuth) {
+                // NOTE: Authenticated rebases always store an offset.
+                *value = baseAddress_ + (raw & 0xffffffff);
+            } else {
+                *value = raw & 0x7ffffffffffULL;
+                if (i->pointerFormat != DYLD_CHAINED_PTR_ARM64E) {
+                    *value += baseAddress_;
+                }
+            }
+        }
+        return isBind ? SCFixupBind : SCFixupRebase;
+    }
+    return SCFixupNone;
+}
+
+const char *SCChainedFixups::importName(uint64_t ordinal) const {
+    return (ordinal < importNames_.size()) ? importNames_[ordinal] : NULL;
+}
+
+#pragma mark - Private Methods
+
+BOOL SCChainedFixups::parseStarts(const uint8_t *data, uint32_t dataSize, const std::vector<SCSegmentInfo> &segments) {
+    // Determine the preferred load address.
+    for (std::vector<SCSegmentInfo>::const_iterator i = segments.begin(); i != segments.end(); ++i) {
+        if ((i->fileoff == 0) && (i->filesize != 0)) {
+            baseAddress_ = i->vmaddr;
+            break;
+        }
+    }
+
+    const uint32_t startsOffset = read32(data + offsetof(dyld_chained_fixups_header, starts_offset));
+    if ((startsOffset > dataSize) || ((dataSize - startsOffset) < sizeof(uint32_t))) {
+        fprintf(stderr, "ERROR: Chained fixups starts are out of bounds.\n");
+        return NO;
+    }
+    const uint8_t *starts = data + startsOffset;
+    const uint32_t startsSize = dataSize - startsOffset;
+    const uint32_t segCount = read32(starts);
+    if (segCount > ((startsSize - sizeof(uint32_t)) / sizeof(uint32_t))) {
+        fprintf(stderr, "ERROR: Chained fixups starts are out of bounds.\n");
+        return NO;
+    }
+
+    for (uint32_t i = 0; (i < segCount) && (i < segments.size()); ++i) {
+        // NOTE: An offset of zero means that the segment has no fixups.
+        const uint32_t segInfoOffset = read32(starts + sizeof(uint32_t) * (i + 1));
+        if ((segInfoOffset == 0) || (segInfoOffset > startsSize) ||
+                ((startsSize - segInfoOffset) < STARTS_SEGMENT_PAGE_START)) {
+            continue;
+        }
+        const uint8_t *segInfo = starts + segInfoOffset;
+        const uint16_t pageSize = read16(segInfo + STARTS_SEGMENT_PAGE_SIZE);
+        const uint16_t pointerFormat = read16(segInfo + STARTS_SEGMENT_POINTER_FORMAT);
+        const uint16_t pageCount = read16(segInfo + STARTS_SEGMENT_PAGE_COUNT);
+        if ((pageSize == 0) ||
+                (((startsSize - segInfoOffset - STARTS_SEGMENT_PAGE_START) / sizeof(uint16_t)) < pageCount)) {
+            continue;
+        }
+
+        switch (pointerFormat) {
+            case DYLD_CHAINED_PTR_ARM64E:
+            case DYLD_CHAINED_PTR_ARM64E_USERLAND:
+            case DYLD_CHAINED_PTR_ARM64E_USERLAND24:
+            case DYLD_CHAINED_PTR_64:
+            case DYLD_CHAINED_PTR_64_OFFSET:
+                break;
+            default:
+                fprintf(stderr, "ERROR: Unsupported chained pointer format: %u\n", pointerFormat);
+                return NO;
+        }
+
+        SCFixupSegment fixupSegment;
+        fixupSegment.fileoff = segments[i].fileoff;
+        fixupSegment.filesize = segments[i].filesize;
+        fixupSegment.pageSize = pageSize;
+        fixupSegment.pointerFormat = pointerFormat;
+        fixupSegment.pageCount = pageCount;
+        fixupSegment.firstPage = pageStarts_.size();
+        segments_.push_back(fixupSegment);
+
+        // NOTE: Multiple starts per page are only used by 32-bit formats.
+        for (uint32_t page = 0; page < pageCount; ++page) {
+            pageStarts_.push_back(read16(segInfo + STARTS_SEGMENT_PAGE_START + sizeof(uint16_t) * page));
+        }
+    }
+
+    return YES;
+}
+
+BOOL SCChainedFixups::parseImports(const uint8_t *data, uint32_t dataSize) {
+    const uint32_t importsOffset = read32(data + offsetof(dyld_chained_fixups_header, imports_offset));
+    const uint32_t importsCount = read32(data + offsetof(dyld_chained_fixups_header, imports_count));
+    const uint32_t importsFormat = read32(data + offsetof(dyld_chained_fixups_header, imports_format));
+    const uint32_t symbolsOffset = read32(data + offsetof(dyld_chained_fixups_header, symbols_offset));
+    const uint32_t symbolsFormat = read32(data + offsetof(dyld_chained_fixups_header, symbols_format));
+
+    // NOTE: Compressed symbol names are not supported.
+    if ((symbolsFormat != 0) || (symbolsOffset >= dataSize)) {
+        return NO;
+    }
+
+    uint32_t importSize;
+    switch (importsFormat) {
+        case DYLD_CHAINED_IMPORT: importSize = 4; break;
+        case DYLD_CHAINED_IMPORT_ADDEND: importSize = 8; break;
+        case DYLD_CHAINED_IMPORT_ADDEND64: importSize = 16; break;
+        default: return NO;
+    }
+    if ((importsOffset > dataSize) || (((dataSize - importsOffset) / importSize) < importsCount)) {
+        return NO;
+    }
+
+    const uint8_t *imports = data + importsOffset;
+    const char *symbols = reinterpret_cast<const char *>(data + symbolsOffset);
+    const uint32_t symbolsSize = dataSize - symbolsOffset;
+    importNames_.reserve(importsCount);
+    for (uint32_t i = 0; i < importsCount; ++i) {
+        const uint8_t *import = imports + i * importSize;
+        const uint32_t nameOffset = (importsFormat == DYLD_CHAINED_IMPORT_ADDEND64) ?
+            (uint32_t)(read64(import) >> 32) : (read32(import) >> 9);
+
+        // NOTE: Names must be terminated within the data.
+        const char *name = NULL;
+        if ((nameOffset < symbolsSize) && (memchr(symbols + nameOffset, '\0', symbolsSize - nameOffset) != NULL)) {
+            name = symbols + nameOffset;
+        }
+        importNames_.push_back(name);
+    }
+    return YES;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,328 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "image.h"
+
+#include <mach-o/loader.h>
+#include <mach-o/nlist.h>
+#include <launch-cache/dyld_cache_format.h>
+#include "binary.h"
+#include "input.h"
+
+#include <algorithm>
+
+#ifndef LC_FUNCTION_STARTS
+#define LC_FUNCTION_STARTS 0x26
+#endif
+
+SCMachOImage::SCMachOImage(SCInput *input) :
+    input_(input), is64Bit_(NO), isFromSharedCache_(NO), cputype_(0), hasUUID_(NO),
+    functionStartsOffset_(0), functionStartsSize_(0),
+    symbolsOffset_(0), symbolsCount_(0), stringsOffset_(0), stringsSize_(0),
+    headerOffset_(0), cacheLocalSymbolsOffset_(0), cacheLocalSymbolsSize_(0), hasLoadedLocalSymbols_(NO),
+    localSymbolsOffset_(0), localSymbolsCount_(0), localStringsOffset_(0), localStringsSize_(0) {
+    input_->retain();
+}
+
+SCMachOImage::~SCMachOImage() {
+    for (std::vector<SCRegion>::iterator i = regions_.begin(); i != regions_.end(); ++i) {
+        input_->unmap(i->data, i->offset, i->length);
+    }
+    input_->release();
+}
+
+SCMachOImage *SCMachOImage::createWithBinary(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    // Determine offset and size of the requested architecture in the input.
+    // NOTE: Input may contain multiple architectures, or incorrect architecture.
+    off_t offset;
+    size_t size;
+    if (!offsetAndSizeOfBinaryInInput(input, cputype, cpusubtype, &offset, &size)) {
+        return NULL;
+    }
+
+    // NOTE: For a standalone binary, __LINKEDIT file offsets are relative to
+    //       the start of the (possibly fat-contained) binary.
+    SCMachOImage *image = new SCMachOImage(input);
+    if (!image->parseLoadCommands(offset, offset)) {
+        delete image;
+        image = NULL;
+    }
+    return image;
+}
+
+SCMachOImage *SCMachOImage::createWithSharedCache(SCInput *sharedCache, const char *dylibPath) {
+    dyld_cache_header header;
+    if (!sharedCache->read(&header, sizeof(header), 0)) {
+        fprintf(stderr, "ERROR: Failed to read header of shared cache.\n");
+        return NULL;
+    }
+
+    std::vector<dyld_cache_mapping_info> mappings(header.mappingCount);
+    std::vector<dyld_cache_image_info> images(header.imagesCount);
+    if ((header.mappingCount == 0) || (header.imagesCount == 0) ||
+            !sharedCache->read(&mappings[0], mappings.size() * sizeof(dyld_cache_mapping_info), header.mappingOffset) ||
+            !sharedCache->read(&images[0], images.size() * sizeof(dyld_cache_image_info), header.imagesOffset)) {
+        fprintf(stderr, "ERROR: Failed to read mappings and image infos of shared cache.\n");
+        return NULL;
+    }
+
+    // Find the address of the dylib.
+    uint64_t address = 0;
+    const uint64_t size = sharedCache->size();
+    for (std::vector<dyld_cache_image_info>::iterator i = images.begin(); i != images.end(); ++i) {
+        // NOTE: The maximum allowed path length is 1024 bytes.
+        //       (According to /usr/include/sys/syslimits.h)
+        char path[1025];
+        const size_t pathLength = (i->pathFileOffset < size) ? (size_t)std::min<uint64_t>(1024, size - i->pathFileOffset) : 0;
+        if ((pathLength != 0) && sharedCache->read(path, pathLength, i->pathFileOffset)) {
+            path[pathLength] = '\0';
+            if (strcmp(path, dylibPath) == 0) {
+                address = i->address;
+                break;
+            }
+        }
+    }
+    if (address == 0) {
+        fprintf(stderr, "ERROR: Dylib not found in shared cache: %s\n", dylibPath);
+        return NULL;
+    }
+
+    // Convert the address to a file offset.
+    uint64_t headerOffset = 0;
+    BOOL isMapped = NO;
+    for (std::vector<dyld_cache_mapping_info>::iterator i = mappings.begin(); i != mappings.end(); ++i) {
+        if ((i->address <= address) && (address < i->address + i->size)) {
+            headerOffset = i->fileOffset + (address - i->address);
+            isMapped = YES;
+            break;
+        }
+    }
+    if (!isMapped) {
+        fprintf(stderr, "ERROR: Dylib is not contained in any mapping of shared cache: %s\n", dylibPath);
+        return NULL;
+    }
+
+    // NOTE: For a dylib in the shared cache, __LINKEDIT file offsets are
+    //       relative to the start of the cache file.
+    SCMachOImage *image = new SCMachOImage(sharedCache);
+    image->isFromSharedCache_ = YES;
+    image->headerOffset_ = headerOffset;
+    // NOTE: Local symbol offset/size fields did not exist in earlier firmware.
+    if (header.mappingOffset >= sizeof(dyld_cache_header)) {
+        image->cacheLocalSymbolsOffset_ = header.localSymbolsOffset;
+        image->cacheLocalSymbolsSize_ = header.localSymbolsSize;
+    }
+    if (!image->parseLoadCommands(headerOffset, 0)) {
+        delete image;
+        image = NULL;
+    }
+    return image;
+}
+
+BOOL SCMachOImage::parseLoadCommands(uint64_t headerOffset, uint64_t linkeditBase) {
+    mach_header header;
+    if (!input_->read(&header, sizeof(header), headerOffset)) {
+        fprintf(stderr, "ERROR: Failed to read mach header.\n");
+        return NO;
+    }
+
+    if (header.magic == MH_MAGIC_64) {
+        is64Bit_ = YES;
+    } else if (header.magic != MH_MAGIC) {
+        fprintf(stderr, "ERROR: Unsupported magic \"0x%x\" for image.\n", header.magic);
+        return NO;
+    }
+    cputype_ = header.cputype;
+    headerOffset_ = headerOffset;
+
+    // NOTE: Load commands are small; read them rather than keep them mapped.
+    const size_t headerSize = (is64Bit_ ? sizeof(mach_header_64) : sizeof(mach_header));
+    std::vector<uint8_t> cmds(header.sizeofcmds);
+    if ((header.sizeofcmds == 0) || !input_->read(&cmds[0], cmds.size(), headerOffset + headerSize)) {
+        fprintf(stderr, "ERROR: Failed to read load commands.\n");
+        return NO;
+    }
+
+    const uint8_t *cmdsEnd = &cmds[0] + cmds.size();
+    const load_command *cmd = reinterpret_cast<const load_command *>(&cmds[0]);
+    for (uint32_t i = 0; i < header.ncmds; ++i) {
+        if ((reinterpret_cast<const uint8_t *>(cmd) + sizeof(load_command) > cmdsEnd) ||
+                (cmd->cmdsize < sizeof(load_command)) ||
+                (reinterpret_cast<const uint8_t *>(cmd) + cmd->cmdsize > cmdsEnd)) {
+            fprintf(stderr, "ERROR: Encountered malformed load command.\n");
+            return NO;
+        }
+
+        switch (cmd->cmd) {
+            case LC_SEGMENT: {
+                const segment_command *seg = reinterpret_cast<const segment_command *>(cmd);
+                SCSegmentInfo info;
+                memcpy(info.name, seg->segname, sizeof(seg->segname));
+                info.name[sizeof(seg->segname)] = '\0';
+                info.vmaddr = seg->vmaddr;
+                info.vmsize = seg->vmsize;
+                info.fileoff = seg->fileoff;
+                info.filesize = seg->filesize;
+                segments_.push_back(info);
+                break;
+            }
+            case LC_SEGMENT_64: {
+                const segment_command_64 *seg = reinterpret_cast<const segment_command_64 *>(cmd);
+                SCSegmentInfo info;
+                memcpy(info.name, seg->segname, sizeof(seg->segname));
+                info.name[sizeof(seg->segname)] = '\0';
+                info.vmaddr = seg->vmaddr;
+                info.vmsize = seg->vmsize;
+                info.fileoff = seg->fileoff;
+                info.filesize = seg->filesize;
+                segments_.push_back(info);
+                break;
+            }
+            case LC_SYMTAB: {
+                const symtab_command *symtab = reinterpret_cast<const symtab_command *>(cmd);
+                symbolsOffset_ = linkeditBase + symtab->symoff;
+                symbolsCount_ = symtab->nsyms;
+                stringsOffset_ = linkeditBase + symtab->stroff;
+                stringsSize_ = symtab->strsize;
+                break;
+            }
+            case LC_FUNCTION_STARTS: {
+                const linkedit_data_command *data = reinterpret_cast<const linkedit_data_command *>(cmd);
+                functionStartsOffset_ = linkeditBase + data->dataoff;
+                functionStartsSize_ = data->datasize;
+                break;
+            }
+            case LC_UUID: {
+                const uuid_command *uuid = reinterpret_cast<const uuid_command *>(cmd);
+                memcpy(uuid_, uuid->uuid, sizeof(uuid_));
+                hasUUID_ = YES;
+                break;
+            }
+            default:
+                break;
+        }
+
+        // Prepare next command.
+        cmd = reinterpret_cast<const load_command *>(reinterpret_cast<const uint8_t *>(cmd) + cmd->cmdsize);
+    }
+
+    return YES;
+}
+
+const uint8_t *SCMachOImage::mapRegion(uint64_t offset, size_t length) {
+    if (length == 0) {
+        return NULL;
+    }
+
+    for (std::vector<SCRegion>::iterator i = regions_.begin(); i != regions_.end(); ++i) {
+        if ((i->offset == offset) && (i->length == length)) {
+            return i->data;
+        }
+    }
+
+    const uint8_t *data = input_->map(offset, length);
+    if (data != NULL) {
+        SCRegion region = {offset, length, data};
+        regions_.push_back(region);
+    } else {
+        fprintf(stderr, "ERROR: Failed to map region at offset 0x%llx of image.\n", offset);
+    }
+    return data;
+}
+
+uint64_t SCMachOImage::baseAddress() const {
+    const SCSegmentInfo *text = segmentNamed("__TEXT");
+    return (text != NULL) ? text->vmaddr : 0;
+}
+
+const SCSegmentInfo *SCMachOImage::segmentNamed(const char *name) const {
+    for (std::vector<SCSegmentInfo>::const_iterator i = segments_.begin(); i != segments_.end(); ++i) {
+        if (strcmp(i->name, name) == 0) {
+            return &*i;
+        }
+    }
+    return NULL;
+}
+
+const uint8_t *SCMachOImage::functionStarts(size_t *length) {
+    const uint8_t *data = mapRegion(functionStartsOffset_, functionStartsSize_);
+    *length = (data != NULL) ? functionStartsSize_ : 0;
+    return data;
+}
+
+const uint8_t *SCMachOImage::symbols(uint32_t *count) {
+    const size_t nlistSize = (is64Bit_ ? sizeof(struct nlist_64) : sizeof(struct nlist));
+    const uint8_t *data = mapRegion(symbolsOffset_, symbolsCount_ * nlistSize);
+    *count = (data != NULL) ? symbolsCount_ : 0;
+    return data;
+}
+
+const char *SCMachOImage::strings(uint32_t *size) {
+    const char *data = reinterpret_cast<const char *>(mapRegion(stringsOffset_, stringsSize_));
+    *size = (data != NULL) ? stringsSize_ : 0;
+    return data;
+}
+
+BOOL SCMachOImage::loadLocalSymbols() {
+    if (!hasLoadedLocalSymbols_) {
+        hasLoadedLocalSymbols_ = YES;
+
+        if (!isFromSharedCache_ || (cacheLocalSymbolsSize_ == 0)) {
+            return NO;
+        }
+
+        dyld_cache_local_symbols_info info;
+        if (!input_->read(&info, sizeof(info), cacheLocalSymbolsOffset_)) {
+            fprintf(stderr, "ERROR: Failed to read local symbols info of shared cache.\n");
+            return NO;
+        }
+
+        std::vector<dyld_cache_local_symbols_entry> entries(info.entriesCount);
+        if ((info.entriesCount == 0) || !input_->read(&entries[0], entries.size() * sizeof(dyld_cache_local_symbols_entry), cacheLocalSymbolsOffset_ + info.entriesOffset)) {
+            fprintf(stderr, "ERROR: Failed to read local symbols entries of shared cache.\n");
+            return NO;
+        }
+
+        // NOTE: The dylib offset of an entry is the file offset of the dylib's
+        //       mach header.
+        const size_t nlistSize = (is64Bit_ ? sizeof(struct nlist_64) : sizeof(struct nlist));
+        for (std::vector<dyld_cache_local_symbols_entry>::iterator i = entries.begin(); i != entries.end(); ++i) {
+            if (i->dylibOffset == headerOffset_) {
+                localSymbolsOffset_ = cacheLocalSymbolsOffset_ + info.nlistOffset + (uint64_t)i->nlistStartIndex * nlistSize;
+                localSymbolsCount_ = i->nlistCount;
+                localStringsOffset_ = cacheLocalSymbolsOffset_ + info.stringsOffset;
+                localStringsSize_ = info.stringsSize;
+                break;
+            }
+        }
+    }
+
+    return (localSymbolsCount_ != 0);
+}
+
+const uint8_t *SCMachOImage::localSymbols(uint32_t *count) {
+    const uint8_t *data = NULL;
+    if (loadLocalSymbols()) {
+        const size_t nlistSize = (is64Bit_ ? sizeof(struct nlist_64) : sizeof(struct nlist));
+        data = mapRegion(localSymbolsOffset_, localSymbolsCount_ * nlistSize);
+    }
+    *count = (data != NULL) ? localSymbolsCount_ : 0;
+    return data;
+}
+
+const char *SCMachOImage::localStrings(uint32_t *size) {
+    const char *data = NULL;
+    if (loadLocalSymbols()) {
+        data = reinterpret_cast<const char *>(mapRegion(localStringsOffset_, localStringsSize_));
+    }
+    *size = (data != NULL) ? localStringsSize_ : 0;
+    return data;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,792 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "input.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// NOTE: Size of uncompressed data between access points of a deflate stream.
+//       Each access point stores a 32 KiB window, so this trades memory used by
+//       the index against the amount of data inflated to reach an offset.
+#define kInflateSpan (4 * 1024 * 1024)
+
+// NOTE: Maximum amount of inflated data kept per archive entry. Blocks that
+//       are mapped are kept regardless, and so may exceed this.
+#define kBlockCacheSize (32 * 1024 * 1024)
+
+// NOTE: Maximum number of archive entries kept open (and indexed) at once.
+#define kArchiveEntryCacheCount 4
+
+#define kWindowSize 32768
+#define kChunkSize 16384
+
+static inline BOOL isRangeWithinSize(uint64_t offset, uint64_t length, uint64_t size) {
+    return (offset <= size) && (length <= size - offset);
+}
+
+static BOOL readFully(int fd, void *buffer, size_t length, uint64_t offset) {
+    uint8_t *p = reinterpret_cast<uint8_t *>(buffer);
+    while (length > 0) {
+        ssize_t n = pread(fd, p, length, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        } else if (n == 0) {
+            return NO;
+        }
+        p += n;
+        length -= n;
+        offset += n;
+    }
+    return YES;
+}
+
+// NOTE: mmap() may fail if offset is not page-aligned.
+static const uint8_t *mapRange(int fd, uint64_t offset, size_t length) {
+    if (length == 0) {
+        return NULL;
+    }
+
+    const uint64_t pagesize = getpagesize();
+    const uint64_t pageOffset = offset - (offset % pagesize);
+    const size_t mapLength = (offset - pageOffset) + length;
+
+    void *data = mmap(NULL, mapLength, PROT_READ, MAP_PRIVATE, fd, pageOffset);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    return reinterpret_cast<const uint8_t *>(data) + (offset - pageOffset);
+}
+
+static void unmapRange(const uint8_t *data, uint64_t offset, size_t length) {
+    if (data != NULL) {
+        const uint64_t pagesize = getpagesize();
+        const uint64_t pageOffset = offset - (offset % pagesize);
+        const size_t mapLength = (offset - pageOffset) + length;
+        munmap(const_cast<uint8_t *>(data - (offset - pageOffset)), mapLength);
+    }
+}
+
+static inline uint16_t readLE16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t readLE64(const uint8_t *p) {
+    return (uint64_t)readLE32(p) | ((uint64_t)readLE32(p + 4) << 32);
+}
+
+#pragma mark - File
+
+class SCFileInput : public SCInput {
+    public:
+        SCFileInput(int fd, uint64_t size) : fd_(fd), size_(size) {}
+
+        uint64_t size() const {
+            return size_;
+        }
+
+        BOOL read(void *buffer, size_t length, uint64_t offset) {
+            return isRangeWithinSize(offset, length, size_) && readFully(fd_, buffer, length, offset);
+        }
+
+        const uint8_t *map(uint64_t offset, size_t length) {
+            return isRangeWithinSize(offset, length, size_) ? mapRange(fd_, offset, length) : NULL;
+        }
+
+        void unmap(const uint8_t *data, uint64_t offset, size_t length) {
+            unmapRange(data, offset, length);
+        }
+
+    protected:
+        ~SCFileInput() {
+            close(fd_);
+        }
+
+    private:
+        int fd_;
+        uint64_t size_;
+};
+
+#pragma mark - Memory
+
+class SCMemoryInput : public SCInput {
+    public:
+        SCMemoryInput(const void *memory, size_t length) : memory_(reinterpret_cast<const uint8_t *>(memory)), length_(length) {}
+
+        uint64_t size() const {
+            return length_;
+        }
+
+        BOOL read(void *buffer, size_t length, uint64_t offset) {
+            if (!isRangeWithinSize(offset, length, length_)) {
+                return NO;
+            }
+            memcpy(buffer, memory_ + offset, length);
+            return YES;
+        }
+
+        const uint8_t *map(uint64_t offset, size_t length) {
+            return isRangeWithinSize(offset, length, length_) ? (memory_ + offset) : NULL;
+        }
+
+        void unmap(const uint8_t *data, uint64_t offset, size_t length) {}
+
+    private:
+        const uint8_t *memory_;
+        size_t length_;
+};
+
+#pragma mark - Archive
+
+typedef struct _SCZipEntry {
+    uint64_t dataOffset;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint16_t method;
+} SCZipEntry;
+
+#define kZipMethodStored 0
+#define kZipMethodDeflated 8
+
+// NOTE: A point at which inflation of a deflate stream can be resumed.
+//       This is the approach used by zran.c from the zlib distribution.
+typedef struct _SCInflatePoint {
+    uint64_t out; // Offset in uncompressed data.
+    uint64_t in; // Offset in compressed data.
+    int bits; // Number of bits (1-7) from byte at (in - 1), or 0.
+    uint8_t *window; // Preceding 32 KiB of uncompressed data.
+} SCInflatePoint;
+
+typedef struct _SCInflatedBlock {
+    uint8_t *data;
+    size_t length;
+    // NOTE: Number of outstanding map() views of the block; mapped blocks are
+    //       not evicted.
+    unsigned mapCount;
+    std::list<size_t>::iterator lruPosition;
+} SCInflatedBlock;
+
+static BOOL findZipEntry(int fd, uint64_t fileSize, const char *name, SCZipEntry *entry) {
+    // Locate the end of central directory record.
+    // NOTE: The record is followed by a comment of up to 64 KiB.
+    const size_t eocdSize = 22;
+    if (fileSize < eocdSize) {
+        return NO;
+    }
+    const size_t tailLength = (size_t)std::min<uint64_t>(fileSize, eocdSize + 0xffff);
+    const uint64_t tailOffset = fileSize - tailLength;
+    std::vector<uint8_t> tail(tailLength);
+    if (!readFully(fd, &tail[0], tailLength, tailOffset)) {
+        return NO;
+    }
+
+    ssize_t eocd = -1;
+    for (ssize_t i = tailLength - eocdSize; i >= 0; --i) {
+        if (readLE32(&tail[i]) == 0x06054b50) {
+            eocd = i;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        return NO;
+    }
+
+    uint64_t numEntries = readLE16(&tail[eocd + 10]);
+    uint64_t cdSize = readLE32(&tail[eocd + 12]);
+    uint64_t cdOffset = readLE32(&tail[eocd + 16]);
+    if ((numEntries == 0xffff) || (cdSize == 0xffffffff) || (cdOffset == 0xffffffff)) {
+        // NOTE: Archive is in Zip64 format (e.g. it contains a shared cache
+        //       larger than 4 GiB).
+        uint8_t locator[20];
+        if ((tailOffset + eocd < sizeof(locator)) ||
+                !readFully(fd, locator, sizeof(locator), tailOffset + eocd - sizeof(locator)) ||
+                (readLE32(locator) != 0x07064b50)) {
+            fprintf(stderr, "ERROR: Failed to find Zip64 end of central directory locator.\n");
+            return NO;
+        }
+
+        uint8_t eocd64[56];
+        if (!readFully(fd, eocd64, sizeof(eocd64), readLE64(&locator[8])) || (readLE32(eocd64) != 0x06064b50)) {
+            fprintf(stderr, "ERROR: Failed to read Zip64 end of central directory record.\n");
+            return NO;
+        }
+        numEntries = readLE64(&eocd64[32]);
+        cdSize = readLE64(&eocd64[40]);
+        cdOffset = readLE64(&eocd64[48]);
+    }
+
+    if (!isRangeWithinSize(cdOffset, cdSize, fileSize)) {
+        fprintf(stderr, "ERROR: Central directory extends beyond end of archive.\n");
+        return NO;
+    }
+    std::vector<uint8_t> cd(cdSize);
+    if ((cdSize == 0) || !readFully(fd, &cd[0], cdSize, cdOffset)) {
+        return NO;
+    }
+
+    // Search the central directory for the requested entry.
+    const size_t nameLength = strlen(name);
+    size_t pos = 0;
+    for (uint64_t i = 0; i < numEntries; ++i) {
+        if (pos + 46 > cdSize) {
+            break;
+        }
+        const uint8_t *header = &cd[pos];
+        if (readLE32(header) != 0x02014b50) {
+            break;
+        }
+
+        const uint16_t flags = readLE16(header + 8);
+        const uint16_t method = readLE16(header + 10);
+        uint64_t compressedSize = readLE32(header + 20);
+        uint64_t uncompressedSize = readLE32(header + 24);
+        const uint16_t n = readLE16(header + 28);
+        const uint16_t e = readLE16(header + 30);
+        const uint16_t c = readLE16(header + 32);
+        uint64_t localOffset = readLE32(header + 42);
+        if (pos + 46 + n + e + c > cdSize) {
+            break;
+        }
+
+        if ((n == nameLength) && (memcmp(header + 46, name, n) == 0)) {
+            // Apply Zip64 extended information, if present.
+            const uint8_t *extra = header + 46 + n;
+            for (size_t p = 0; p + 4 <= e;) {
+                const uint16_t extraId = readLE16(extra + p);
+                const uint16_t extraSize = readLE16(extra + p + 2);
+                if (p + 4 + extraSize > e) {
+                    break;
+                }
+                if (extraId == 0x0001) {
+                    const uint8_t *field = extra + p + 4;
+                    size_t q = 0;
+                    if ((uncompressedSize == 0xffffffff) && (q + 8 <= extraSize)) {
+                        uncompressedSize = readLE64(field + q);
+                        q += 8;
+                    }
+                    if ((compressedSize == 0xffffffff) && (q + 8 <= extraSize)) {
+                        compressedSize = readLE64(field + q);
+                        q += 8;
+                    }
+                    if ((localOffset == 0xffffffff) && (q + 8 <= extraSize)) {
+                        localOffset = readLE64(field + q);
+                        q += 8;
+                    }
+                }
+                p += 4 + extraSize;
+            }
+
+            if (flags & 1) {
+                fprintf(stderr, "ERROR: Encrypted archive entries are not supported: %s\n", name);
+                return NO;
+            }
+            if ((method != kZipMethodStored) && (method != kZipMethodDeflated)) {
+                fprintf(stderr, "ERROR: Unsupported compression method %u for archive entry: %s\n", method, name);
+                return NO;
+            }
+
+            // Determine the start of the entry's data from its local header.
+            uint8_t local[30];
+            if (!readFully(fd, local, sizeof(local), localOffset) || (readLE32(local) != 0x04034b50)) {
+                fprintf(stderr, "ERROR: Failed to read local header for archive entry: %s\n", name);
+                return NO;
+            }
+            const uint64_t dataOffset = localOffset + sizeof(local) + readLE16(local + 26) + readLE16(local + 28);
+            if (!isRangeWithinSize(dataOffset, compressedSize, fileSize)) {
+                fprintf(stderr, "ERROR: Archive entry extends beyond end of archive: %s\n", name);
+                return NO;
+            }
+
+            entry->dataOffset = dataOffset;
+            entry->compressedSize = compressedSize;
+            entry->uncompressedSize = uncompressedSize;
+            entry->method = method;
+            return YES;
+        }
+
+        pos += 46 + n + e + c;
+    }
+
+    return NO;
+}
+
+class SCArchiveEntryInput : public SCInput {
+    public:
+        SCArchiveEntryInput(int fd, const SCZipEntry &entry) : fd_(fd), entry_(entry), cachedLength_(0) {
+            pthread_mutex_init(&mutex_, NULL);
+        }
+
+        uint64_t size() const {
+            return entry_.uncompressedSize;
+        }
+
+        BOOL buildIndex();
+        BOOL read(void *buffer, size_t length, uint64_t offset);
+
+        const uint8_t *map(uint64_t offset, size_t length) {
+            if (!isRangeWithinSize(offset, length, entry_.uncompressedSize)) {
+                return NULL;
+            }
+
+            if (entry_.method == kZipMethodStored) {
+                return mapRange(fd_, entry_.dataOffset + offset, length);
+            }
+
+            // NOTE: A range that lies within a single block is a view of the
+            //       cached block; only ranges that span blocks are copied.
+            //       Either way, only the blocks overlapping the range are
+            //       inflated. Callers that scan large ranges should read them
+            //       in windows instead.
+            const uint8_t *view = mapWithinBlock(offset, length);
+            if (view != NULL) {
+                return view;
+            }
+            uint8_t *data = reinterpret_cast<uint8_t *>(malloc(length));
+            if ((data != NULL) && !read(data, length, offset)) {
+                free(data);
+                data = NULL;
+            }
+            return data;
+        }
+
+        void unmap(const uint8_t *data, uint64_t offset, size_t length) {
+            if (entry_.method == kZipMethodStored) {
+                unmapRange(data, entry_.dataOffset + offset, length);
+            } else if (!unmapWithinBlock(data, offset)) {
+                free(const_cast<uint8_t *>(data));
+            }
+        }
+
+    protected:
+        ~SCArchiveEntryInput() {
+            for (std::map<size_t, SCInflatedBlock>::iterator i = blocks_.begin(); i != blocks_.end(); ++i) {
+                free(i->second.data);
+            }
+            for (std::vector<SCInflatePoint>::iterator i = points_.begin(); i != points_.end(); ++i) {
+                free(i->window);
+            }
+            pthread_mutex_destroy(&mutex_);
+            close(fd_);
+        }
+
+    private:
+        BOOL addPoint(int bits, uint64_t in, uint64_t out, unsigned left, const uint8_t *window);
+        SCInflatedBlock *blockAtIndex(size_t index);
+        size_t indexForOffset(uint64_t offset) const;
+        uint8_t *inflateBlock(size_t index, size_t length);
+        const uint8_t *mapWithinBlock(uint64_t offset, size_t length);
+        BOOL unmapWithinBlock(const uint8_t *data, uint64_t offset);
+
+        int fd_;
+        SCZipEntry entry_;
+        std::vector<SCInflatePoint> points_;
+        std::map<size_t, SCInflatedBlock> blocks_;
+        std::list<size_t> lru_;
+        size_t cachedLength_;
+        pthread_mutex_t mutex_;
+};
+
+BOOL SCArchiveEntryInput::addPoint(int bits, uint64_t in, uint64_t out, unsigned left, const uint8_t *window) {
+    SCInflatePoint point;
+    point.out = out;
+    point.in = in;
+    point.bits = bits;
+    point.window = reinterpret_cast<uint8_t *>(malloc(kWindowSize));
+    if (point.window == NULL) {
+        return NO;
+    }
+
+    // NOTE: The window is circular; left is the number of unused bytes at its
+    //       end.
+    if (window != NULL) {
+        if (left != 0) {
+            memcpy(point.window, window + kWindowSize - left, left);
+        }
+        if (left < kWindowSize) {
+            memcpy(point.window + left, window, kWindowSize - left);
+        }
+    }
+
+    points_.push_back(point);
+    return YES;
+}
+
+// NOTE: Building the index requires inflating the entire entry once; after
+//       that, any offset can be reached by inflating at most one span.
+BOOL SCArchiveEntryInput::buildIndex() {
+    if (entry_.method == kZipMethodStored) {
+        return YES;
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+        return NO;
+    }
+
+    uint8_t *input = reinterpret_cast<uint8_t *>(malloc(kChunkSize));
+    uint8_t *window = reinterpret_cast<uint8_t *>(malloc(kWindowSize));
+    BOOL succeeded = (input != NULL) && (window != NULL) && addPoint(0, 0, 0, 0, NULL);
+
+    uint64_t totalIn = 0;
+    uint64_t totalOut = 0;
+    uint64_t last = 0;
+    uint64_t readPos = 0;
+    int ret = Z_OK;
+    strm.avail_out = 0;
+    while (succeeded && (ret != Z_STREAM_END)) {
+        if (strm.avail_in == 0) {
+            const size_t n = (size_t)std::min<uint64_t>(kChunkSize, entry_.compressedSize - readPos);
+            if ((n != 0) && !readFully(fd_, input, n, entry_.dataOffset + readPos)) {
+                succeeded = NO;
+                break;
+            }
+            readPos += n;
+            strm.next_in = input;
+            strm.avail_in = n;
+        }
+
+        if (strm.avail_out == 0) {
+            strm.next_out = window;
+            strm.avail_out = kWindowSize;
+        }
+
+        // NOTE: Z_BLOCK causes inflate() to return at the end of each deflate
+        //       block, which is where access points can be placed.
+        totalIn += strm.avail_in;
+        totalOut += strm.avail_out;
+        ret = inflate(&strm, Z_BLOCK);
+        totalIn -= strm.avail_in;
+        totalOut -= strm.avail_out;
+        if ((ret == Z_NEED_DICT) || (ret == Z_DATA_ERROR) || (ret == Z_MEM_ERROR) || (ret == Z_BUF_ERROR)) {
+            // NOTE: Z_BUF_ERROR means that the compressed data is truncated.
+            succeeded = NO;
+            break;
+        }
+
+        if ((ret != Z_STREAM_END) && (strm.data_type & 128) && !(strm.data_type & 64) && (totalOut - last > kInflateSpan)) {
+            if (!addPoint(strm.data_type & 7, totalIn, totalOut, strm.avail_out, window)) {
+                succeeded = NO;
+                break;
+            }
+            last = totalOut;
+        }
+    }
+
+    if (succeeded && (totalOut != entry_.uncompressedSize)) {
+        fprintf(stderr, "ERROR: Inflated size of archive entry does not match recorded size.\n");
+        succeeded = NO;
+    }
+
+    inflateEnd(&strm);
+    free(input);
+    free(window);
+
+    return succeeded;
+}
+
+uint8_t *SCArchiveEntryInput::inflateBlock(size_t index, size_t length) {
+    const SCInflatePoint &point = points_[index];
+
+    uint8_t *block = reinterpret_cast<uint8_t *>(malloc(length));
+    if (block == NULL) {
+        return NULL;
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+        free(block);
+        return NULL;
+    }
+
+    BOOL succeeded = YES;
+    if (point.bits != 0) {
+        uint8_t byte;
+        if (readFully(fd_, &byte, 1, entry_.dataOffset + point.in - 1)) {
+            inflatePrime(&strm, point.bits, byte >> (8 - point.bits));
+        } else {
+            succeeded = NO;
+        }
+    }
+    if (succeeded && (point.out != 0)) {
+        inflateSetDictionary(&strm, point.window, kWindowSize);
+    }
+
+    uint8_t input[kChunkSize];
+    uint64_t in = point.in;
+    int ret = Z_OK;
+    strm.next_out = block;
+    strm.avail_out = length;
+    while (succeeded && (strm.avail_out != 0) && (ret != Z_STREAM_END)) {
+        if (strm.avail_in == 0) {
+            const size_t n = (size_t)std::min<uint64_t>(sizeof(input), entry_.compressedSize - in);
+            if ((n == 0) || !readFully(fd_, input, n, entry_.dataOffset + in)) {
+                succeeded = NO;
+                break;
+            }
+            in += n;
+            strm.next_in = input;
+            strm.avail_in = n;
+        }
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+        if ((ret == Z_NEED_DICT) || (ret == Z_DATA_ERROR) || (ret == Z_MEM_ERROR)) {
+            succeeded = NO;
+        }
+    }
+    inflateEnd(&strm);
+
+    if (!succeeded || (strm.avail_out != 0)) {
+        fprintf(stderr, "ERROR: Failed to inflate block %zu of archive entry.\n", index);
+        free(block);
+        block = NULL;
+    }
+
+    return block;
+}
+
+// NOTE: Must be called with the mutex held.
+SCInflatedBlock *SCArchiveEntryInput::blockAtIndex(size_t index) {
+    std::map<size_t, SCInflatedBlock>::iterator it = blocks_.find(index);
+    if (it != blocks_.end()) {
+        // Mark as most recently used.
+        lru_.splice(lru_.begin(), lru_, it->second.lruPosition);
+        return &it->second;
+    }
+
+    const uint64_t start = points_[index].out;
+    const uint64_t end = (index + 1 < points_.size()) ? points_[index + 1].out : entry_.uncompressedSize;
+    const size_t length = end - start;
+
+    uint8_t *data = inflateBlock(index, length);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    // Evict least recently used blocks to stay within the cache size.
+    // NOTE: Blocks that are currently mapped are skipped.
+    std::list<size_t>::iterator position = lru_.end();
+    while ((position != lru_.begin()) && (cachedLength_ + length > kBlockCacheSize)) {
+        --position;
+        std::map<size_t, SCInflatedBlock>::iterator victim = blocks_.find(*position);
+        if (victim->second.mapCount == 0) {
+            cachedLength_ -= victim->second.length;
+            free(victim->second.data);
+            blocks_.erase(victim);
+            position = lru_.erase(position);
+        }
+    }
+
+    lru_.push_front(index);
+    SCInflatedBlock &block = blocks_[index];
+    block.data = data;
+    block.length = length;
+    block.mapCount = 0;
+    block.lruPosition = lru_.begin();
+    cachedLength_ += length;
+
+    return &block;
+}
+
+static bool comparePointOut(uint64_t offset, const SCInflatePoint &point) {
+    return offset < point.out;
+}
+
+// NOTE: Returns the index of the last access point at or before the offset.
+size_t SCArchiveEntryInput::indexForOffset(uint64_t offset) const {
+    std::vector<SCInflatePoint>::const_iterator it = std::upper_bound(points_.begin(), points_.end(), offset, comparePointOut);
+    return (it - points_.begin()) - 1;
+}
+
+const uint8_t *SCArchiveEntryInput::mapWithinBlock(uint64_t offset, size_t length) {
+    if (length == 0) {
+        return NULL;
+    }
+
+    const uint8_t *data = NULL;
+    pthread_mutex_lock(&mutex_);
+    const size_t index = indexForOffset(offset);
+    const size_t skip = offset - points_[index].out;
+    const uint64_t end = (index + 1 < points_.size()) ? points_[index + 1].out : entry_.uncompressedSize;
+    if (offset + length <= end) {
+        SCInflatedBlock *block = blockAtIndex(index);
+        if (block != NULL) {
+            ++block->mapCount;
+            data = block->data + skip;
+        }
+    }
+    pthread_mutex_unlock(&mutex_);
+
+    return data;
+}
+
+// NOTE: Returns NO if the data is not a view of a block (i.e. is a copy).
+BOOL SCArchiveEntryInput::unmapWithinBlock(const uint8_t *data, uint64_t offset) {
+    BOOL isView = NO;
+    pthread_mutex_lock(&mutex_);
+    const size_t index = indexForOffset(offset);
+    std::map<size_t, SCInflatedBlock>::iterator it = blocks_.find(index);
+    if ((it != blocks_.end()) && (it->second.mapCount != 0) &&
+            (data == it->second.data + (offset - points_[index].out))) {
+        --it->second.mapCount;
+        isView = YES;
+    }
+    pthread_mutex_unlock(&mutex_);
+    return isView;
+}
+
+BOOL SCArchiveEntryInput::read(void *buffer, size_t length, uint64_t offset) {
+    if (!isRangeWithinSize(offset, length, entry_.uncompressedSize)) {
+        return NO;
+    }
+
+    if (entry_.method == kZipMethodStored) {
+        return readFully(fd_, buffer, length, entry_.dataOffset + offset);
+    }
+
+    BOOL succeeded = YES;
+    uint8_t *p = reinterpret_cast<uint8_t *>(buffer);
+
+    pthread_mutex_lock(&mutex_);
+    while (length > 0) {
+        // Find the last access point at or before the offset.
+        const size_t index = indexForOffset(offset);
+
+        const SCInflatedBlock *block = blockAtIndex(index);
+        if (block == NULL) {
+            succeeded = NO;
+            break;
+        }
+
+        const size_t skip = offset - points_[index].out;
+        const size_t n = std::min(length, block->length - skip);
+        memcpy(p, block->data + skip, n);
+        p += n;
+        offset += n;
+        length -= n;
+    }
+    pthread_mutex_unlock(&mutex_);
+
+    return succeeded;
+}
+
+// NOTE: Indexing a deflated entry requires inflating it in full, so opened
+//       entries are kept around for reuse by subsequent calls.
+static pthread_mutex_t archiveEntryCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, SCInput *> archiveEntryCache;
+static std::list<std::string> archiveEntryCacheOrder;
+
+static SCInput *createArchiveEntryInput(const char *archivePath, const char *entryName) {
+    // Skip leading slashes (e.g. from appending a path to the archive path).
+    while (*entryName == '/') {
+        ++entryName;
+    }
+
+    std::string key = std::string(archivePath) + "!/" + entryName;
+
+    pthread_mutex_lock(&archiveEntryCacheMutex);
+    std::map<std::string, SCInput *>::iterator it = archiveEntryCache.find(key);
+    if (it != archiveEntryCache.end()) {
+        SCInput *input = it->second;
+        input->retain();
+        pthread_mutex_unlock(&archiveEntryCacheMutex);
+        return input;
+    }
+    pthread_mutex_unlock(&archiveEntryCacheMutex);
+
+    int fd = open(archivePath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Failed to open archive: %s\n", archivePath);
+        return NULL;
+    }
+
+    struct stat st;
+    SCZipEntry entry;
+    if ((fstat(fd, &st) < 0) || !findZipEntry(fd, st.st_size, entryName, &entry)) {
+        fprintf(stderr, "ERROR: Failed to find entry \"%s\" in archive: %s\n", entryName, archivePath);
+        close(fd);
+        return NULL;
+    }
+
+    SCArchiveEntryInput *input = new SCArchiveEntryInput(fd, entry);
+    if (!input->buildIndex()) {
+        fprintf(stderr, "ERROR: Failed to index entry \"%s\" in archive: %s\n", entryName, archivePath);
+        input->release();
+        return NULL;
+    }
+
+    pthread_mutex_lock(&archiveEntryCacheMutex);
+    it = archiveEntryCache.find(key);
+    if (it == archiveEntryCache.end()) {
+        input->retain();
+        archiveEntryCache[key] = input;
+        archiveEntryCacheOrder.push_back(key);
+        if (archiveEntryCacheOrder.size() > kArchiveEntryCacheCount) {
+            std::string oldest = archiveEntryCacheOrder.front();
+            archiveEntryCacheOrder.pop_front();
+            archiveEntryCache[oldest]->release();
+            archiveEntryCache.erase(oldest);
+        }
+    }
+    pthread_mutex_unlock(&archiveEntryCacheMutex);
+
+    return input;
+}
+
+#pragma mark - Creation
+
+SCInput *SCInputCreateWithPath(const char *path) {
+    // Check if path refers to an entry inside of an archive.
+    for (const char *separator = strstr(path, "!/"); separator != NULL; separator = strstr(separator + 2, "!/")) {
+        std::string archivePath(path, separator - path);
+        struct stat st;
+        if ((stat(archivePath.c_str(), &st) == 0) && S_ISREG(st.st_mode)) {
+            return createArchiveEntryInput(archivePath.c_str(), separator + 2);
+        }
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Failed to open file: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "ERROR: Failed to fstat() file: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    return new SCFileInput(fd, st.st_size);
+}
+
+SCInput *SCInputCreateWithMemory(const void *memory, size_t length) {
+    return new SCMemoryInput(memory, length);
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
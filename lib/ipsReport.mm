@@ -0,0 +1,629 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "ipsReport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCAN_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#endif
+
+#pragma mark - Structural Scanning
+
+// NOTE: Most of a report is skipped rather than parsed (e.g. thread states,
+//       symbol names, VM region info), and so the time spent on a report is
+//       mostly spent looking for the end of strings and of nested values. The
+//       vector code looks at sixteen bytes at a time.
+
+static inline BOOL isQuoteOrBackslash(char c) {
+    return (c == '"') || (c == '\\');
+}
+
+// NOTE: '[' and '{' differ only in bit 5, as do ']' and '}'.
+static inline BOOL isStructural(char c) {
+    const char folded = c | 0x20;
+    return (c == '"') || (folded == '{') || (folded == '}');
+}
+
+#if SCAN_NEON
+
+// NOTE: NEON has no equivalent of movemask; narrowing gives four bits per byte.
+static inline uint64_t nibbleMask(uint8x16_t matches) {
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+static const char *findQuoteOrBackslash(const char *p, const char *end) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    for (; (end - p) >= 16; p += 16) {
+        const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint64_t mask = nibbleMask(vorrq_u8(vceqq_u8(bytes, quote), vceqq_u8(bytes, backslash)));
+        if (mask != 0) {
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+    while ((p < end) && !isQuoteOrBackslash(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static const char *findStructural(const char *p, const char *end) {
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t bit5 = vdupq_n_u8(0x20);
+    const uint8x16_t open = vdupq_n_u8('{');
+    const uint8x16_t close = vdupq_n_u8('}');
+    for (; (end - p) >= 16; p += 16) {
+        const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t folded = vorrq_u8(bytes, bit5);
+        const uint8x16_t matches = vorrq_u8(vceqq_u8(bytes, quote),
+            vorrq_u8(vceqq_u8(folded, open), vceqq_u8(folded, close)));
+        const uint64_t mask = nibbleMask(matches);
+        if (mask != 0) {
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+    while ((p < end) && !isStructural(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+#elif SCAN_SSE2
+
+static const char *findQuoteOrBackslash(const char *p, const char *end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; (end - p) >= 16; p += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    while ((p < end) && !isQuoteOrBackslash(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static const char *findStructural(const char *p, const char *end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bit5 = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    for (; (end - p) >= 16; p += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i folded = _mm_or_si128(bytes, bit5);
+        const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+            _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)));
+        const int mask = _mm_movemask_epi8(matches);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    while ((p < end) && !isStructural(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+#else
+
+static const char *findQuoteOrBackslash(const char *p, const char *end) {
+    while ((p < end) && !isQuoteOrBackslash(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static const char *findStructural(const char *p, const char *end) {
+    while ((p < end) && !isStructural(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+#endif
+
+#pragma mark - Helpers
+
+static inline BOOL viewEquals(const SCStringView &view, const char *string) {
+    const size_t length = strlen(string);
+    return (view.length == length) && (memcmp(view.data, string, length) == 0);
+}
+
+static void appendUTF8(std::string &string, uint32_t c) {
+    if (c < 0x80) {
+        string += (char)c;
+    } else if (c < 0x800) {
+        string += (char)(0xc0 | (c >> 6));
+        string += (char)(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+        string += (char)(0xe0 | (c >> 12));
+        string += (char)(0x80 | ((c >> 6) & 0x3f));
+        string += (char)(0x80 | (c & 0x3f));
+    } else {
+        string += (char)(0xf0 | (c >> 18));
+        string += (char)(0x80 | ((c >> 12) & 0x3f));
+        string += (char)(0x80 | ((c >> 6) & 0x3f));
+        string += (char)(0x80 | (c & 0x3f));
+    }
+}
+
+static BOOL parseHex4(const char *p, const char *end, uint32_t *value) {
+    if ((end - p) < 4) {
+        return NO;
+    }
+    uint32_t result = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        const char c = p[i];
+        unsigned digit;
+        if ((c >= '0') && (c <= '9')) {
+            digit = c - '0';
+        } else if ((c >= 'a') && (c <= 'f')) {
+            digit = c - 'a' + 10;
+        } else if ((c >= 'A') && (c <= 'F')) {
+            digit = c - 'A' + 10;
+        } else {
+            return NO;
+        }
+        result = (result << 4) | digit;
+    }
+    *value = result;
+    return YES;
+}
+
+#pragma mark - Public Methods
+
+BOOL SCIPSReport::parse(const char *data, size_t length) {
+    p_ = data;
+    end_ = data + length;
+    failed_ = NO;
+    bugType_.data = NULL;
+    bugType_.length = 0;
+    images_.clear();
+    threads_.clear();
+    frames_.clear();
+    strings_.clear();
+
+    parseHeader();
+    skipWhitespace();
+    if (!failed_ && (p_ < end_) && (*p_ != '{')) {
+        // NOTE: Older reports have a text body; see SCCrashReportParser.
+        fail("Report body is not JSON.");
+    }
+    parseBody();
+
+    return !failed_;
+}
+
+#pragma mark - Private Methods
+
+// NOTE: Moves to the end of the input so that all pending loops finish.
+void SCIPSReport::fail(const char *message) {
+    if (!failed_) {
+        fprintf(stderr, "ERROR: Failed to parse report: %s\n", message);
+        failed_ = YES;
+    }
+    p_ = end_;
+}
+
+void SCIPSReport::skipWhitespace() {
+    while ((p_ < end_) && ((*p_ == ' ') || (*p_ == '\n') || (*p_ == '\r') || (*p_ == '\t'))) {
+        ++p_;
+    }
+}
+
+BOOL SCIPSReport::expect(char c) {
+    skipWhitespace();
+    if ((p_ < end_) && (*p_ == c)) {
+        ++p_;
+        return YES;
+    }
+    fail("Unexpected character.");
+    return NO;
+}
+
+// NOTE: Returns NO at the end of the object, or on error.
+BOOL SCIPSReport::nextMember(BOOL *isFirst, SCStringView *key) {
+    skipWhitespace();
+    if ((p_ < end_) && (*p_ == '}')) {
+        ++p_;
+        return NO;
+    }
+    if (!*isFirst && !expect(',')) {
+        return NO;
+    }
+    *isFirst = NO;
+    return parseString(key) && expect(':');
+}
+
+// NOTE: Returns NO at the end of the array, or on error.
+BOOL SCIPSReport::nextElement(BOOL *isFirst) {
+    skipWhitespace();
+    if ((p_ < end_) && (*p_ == ']')) {
+        ++p_;
+        return NO;
+    }
+    if (!*isFirst && !expect(',')) {
+        return NO;
+    }
+    *isFirst = NO;
+    skipWhitespace();
+    return !failed_;
+}
+
+BOOL SCIPSReport::parseString(SCStringView *string) {
+    if (!expect('"')) {
+        return NO;
+    }
+
+    const char *start = p_;
+    const char *p = findQuoteOrBackslash(start, end_);
+    if ((p < end_) && (*p == '"')) {
+        string->data = start;
+        string->length = p - start;
+        p_ = p + 1;
+        return YES;
+    }
+
+    // Decode escape sequences.
+    std::string decoded(start, p - start);
+    while (p < end_) {
+        if (*p == '"') {
+            break;
+        }
+        if (*p != '\\') {
+            const char *next = findQuoteOrBackslash(p, end_);
+            decoded.append(p, next - p);
+            p = next;
+            continue;
+        }
+
+        if ((end_ - p) < 2) {
+            // NOTE: The escape sequence, and so the string, is cut off.
+            p_ = end_;
+            fail("Unterminated string.");
+            return NO;
+        }
+        const char c = p[1];
+        p += 2;
+        switch (c) {
+            case 'b': decoded += '\b'; break;
+            case 'f': decoded += '\f'; break;
+            case 'n': decoded += '\n'; break;
+            case 'r': decoded += '\r'; break;
+            case 't': decoded += '\t'; break;
+            case 'u': {
+                uint32_t unit;
+                if (!parseHex4(p, end_, &unit)) {
+                    p_ = p;
+                    fail("Invalid unicode escape.");
+                    return NO;
+                }
+                p += 4;
+                if ((unit >= 0xd800) && (unit < 0xdc00)) {
+                    uint32_t low;
+                    if (((end_ - p) >= 6) && (p[0] == '\\') && (p[1] == 'u') &&
+                            parseHex4(p + 2, end_, &low) && (low >= 0xdc00) && (low < 0xe000)) {
+                        unit = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+                        p += 6;
+                    }
+                }
+                appendUTF8(decoded, unit);
+                break;
+            }
+            default:
+                // NOTE: Includes '"', '\\' and '/'.
+                decoded += c;
+                break;
+        }
+    }
+    if (p >= end_) {
+        p_ = p;
+        fail("Unterminated string.");
+        return NO;
+    }
+    p_ = p + 1;
+
+    const std::string &interned = *strings_.insert(decoded).first;
+    string->data = interned.data();
+    string->length = interned.size();
+    return YES;
+}
+
+BOOL SCIPSReport::parseUnsigned(uint64_t *value) {
+    skipWhitespace();
+    const char *start = p_;
+    uint64_t result = 0;
+    while ((p_ < end_) && (*p_ >= '0') && (*p_ <= '9')) {
+        result = (result * 10) + (*p_ - '0');
+        ++p_;
+    }
+    if (p_ == start) {
+        fail("Expected an unsigned integer.");
+        return NO;
+    }
+    *value = result;
+    return YES;
+}
+
+BOOL SCIPSReport::parseBool(BOOL *value) {
+    skipWhitespace();
+    if (((end_ - p_) >= 4) && (memcmp(p_, "true", 4) == 0)) {
+        p_ += 4;
+        *value = YES;
+        return YES;
+    }
+    if (((end_ - p_) >= 5) && (memcmp(p_, "false", 5) == 0)) {
+        p_ += 5;
+        *value = NO;
+        return YES;
+    }
+    fail("Expected a boolean.");
+    return NO;
+}
+
+void SCIPSReport::skipValue() {
+    skipWhitespace();
+    if (p_ >= end_) {
+        fail("Expected a value.");
+        return;
+    }
+
+    const char c = *p_;
+    if ((c == '{') || (c == '[')) {
+        // NOTE: Brackets are not matched against each other; the report is
+        //       assumed to be well-formed.
+        unsigned depth = 0;
+        const char *p = p_;
+        for (;;) {
+            p = findStructural(p, end_);
+            if (p >= end_) {
+                p_ = p;
+                fail("Unterminated object or array.");
+                return;
+            }
+            const char s = *p++;
+            if (s == '"') {
+                // Skip the string.
+                for (;;) {
+                    p = findQuoteOrBackslash(p, end_);
+                    if ((p < end_) && (*p == '"')) {
+                        ++p;
+                        break;
+                    }
+                    if ((end_ - p) < 2) {
+                        p_ = end_;
+                        fail("Unterminated string.");
+                        return;
+                    }
+                    p += 2;
+                }
+            } else if ((s | 0x20) == '{') {
+                ++depth;
+            } else if (--depth == 0) {
+                break;
+            }
+        }
+        p_ = p;
+    } else if (c == '"') {
+        SCStringView string;
+        parseString(&string);
+    } else {
+        // Number, true, false or null.
+        while ((p_ < end_) && (*p_ != ',') && (*p_ != '}') && (*p_ != ']') &&
+                (*p_ != ' ') && (*p_ != '\n') && (*p_ != '\r') && (*p_ != '\t')) {
+            ++p_;
+        }
+    }
+}
+
+void SCIPSReport::parseHeader() {
+    if (!expect('{')) {
+        return;
+    }
+
+    BOOL isFirst = YES;
+    SCStringView key;
+    while (nextMember(&isFirst, &key)) {
+        if (viewEquals(key, "bug_type")) {
+            parseString(&bugType_);
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void SCIPSReport::parseBody() {
+    if (!expect('{')) {
+        return;
+    }
+
+    BOOL isFirst = YES;
+    SCStringView key;
+    while (nextMember(&isFirst, &key)) {
+        if (viewEquals(key, "usedImages")) {
+            parseImages();
+        } else if (viewEquals(key, "threads")) {
+            parseThreads();
+        } else if (viewEquals(key, "lastExceptionBacktrace")) {
+            parseThread(-1);
+        } else {
+            skipValue();
+        }
+    }
+}
+
+void SCIPSReport::parseImages() {
+    if (!expect('[')) {
+        return;
+    }
+
+    BOOL isFirst = YES;
+    while (nextElement(&isFirst)) {
+        parseImage();
+    }
+}
+
+// e.g. {"source":"P","arch":"arm64e","base":4372529152,"size":49152,
+//       "uuid":"...","path":"\/private\/var\/...","name":"MobileSafari"}
+void SCIPSReport::parseImage() {
+    SCIPSImage image;
+    memset(&image, 0, sizeof(image));
+
+    // NOTE: Images that are not objects are skipped, but still take up an
+    //       index, so that frames refer to the right images.
+    if ((p_ < end_) && (*p_ == '{')) {
+        ++p_;
+        BOOL isFirst = YES;
+        SCStringView key;
+        while (nextMember(&isFirst, &key)) {
+            if (viewEquals(key, "base")) {
+                parseUnsigned(&image.address);
+            } else if (viewEquals(key, "size")) {
+                parseUnsigned(&image.size);
+            } else if (viewEquals(key, "uuid")) {
+                parseString(&image.uuid);
+            } else if (viewEquals(key, "arch")) {
+                parseString(&image.architecture);
+            } else if (viewEquals(key, "path")) {
+                parseString(&image.path);
+            } else if (viewEquals(key, "name")) {
+                parseString(&image.name);
+            } else {
+                skipValue();
+            }
+        }
+    } else {
+        skipValue();
+    }
+
+    images_.push_back(image);
+}
+
+void SCIPSReport::parseThreads() {
+    if (!expect('[')) {
+        return;
+    }
+
+    BOOL isFirst = YES;
+    int index = 0;
+    while (nextElement(&isFirst)) {
+        parseThread(index++);
+    }
+}
+
+// NOTE: The "lastExceptionBacktrace" is just an array of frames.
+void SCIPSReport::parseThread(int index) {
+    SCIPSThread thread;
+    memset(&thread, 0, sizeof(thread));
+    thread.index = index;
+    thread.firstFrame = frames_.size();
+
+    if (index < 0) {
+        parseFrames();
+    } else {
+        if (!expect('{')) {
+            return;
+        }
+        BOOL isFirst = YES;
+        SCStringView key;
+        while (nextMember(&isFirst, &key)) {
+            if (viewEquals(key, "triggered")) {
+                parseBool(&thread.isCrashed);
+            } else if (viewEquals(key, "name")) {
+                parseString(&thread.name);
+            } else if (viewEquals(key, "queue")) {
+                parseString(&thread.queue);
+            } else if (viewEquals(key, "frames")) {
+                parseFrames();
+            } else {
+                skipValue();
+            }
+        }
+    }
+
+    thread.frameCount = frames_.size() - thread.firstFrame;
+    threads_.push_back(thread);
+}
+
+void SCIPSReport::parseFrames() {
+    if (!expect('[')) {
+        return;
+    }
+
+    BOOL isFirst = YES;
+    while (nextElement(&isFirst)) {
+        parseFrame();
+    }
+}
+
+// e.g. {"imageOffset":4660,"symbol":"objc_exception_throw","symbolLocation":56,
+//       "imageIndex":3}
+void SCIPSReport::parseFrame() {
+    SCIPSFrame frame;
+    frame.imageIndex = SCIPSNoImage;
+    frame.imageOffset = 0;
+
+    if (!expect('{')) {
+        return;
+    }
+    BOOL isFirst = YES;
+    SCStringView key;
+    while (nextMember(&isFirst, &key)) {
+        if (viewEquals(key, "imageIndex")) {
+            uint64_t imageIndex;
+            if (parseUnsigned(&imageIndex)) {
+                frame.imageIndex = (imageIndex < SCIPSNoImage) ? (uint32_t)imageIndex : SCIPSNoImage;
+            }
+        } else if (viewEquals(key, "imageOffset")) {
+            parseUnsigned(&frame.imageOffset);
+        } else {
+            skipValue();
+        }
+    }
+
+    frames_.push_back(frame);
+}
+
+#pragma mark - Functions
+
+BOOL findIPSReportBody(const char *data, size_t length, const char **body, BOOL *isJSON) {
+    if ((length == 0) || (data[0] != '{')) {
+        return NO;
+    }
+
+    // NOTE: A report without a line break is treated as JSON, and left for
+    //       the parser to reject if need be.
+    const char *end = data + length;
+    const char *p = reinterpret_cast<const char *>(memchr(data, '\n', length));
+    if (p == NULL) {
+        *body = end;
+        *isJSON = YES;
+        return YES;
+    }
+
+    *body = ++p;
+    while ((p < end) && ((*p == ' ') || (*p == '\n') || (*p == '\r') || (*p == '\t'))) {
+        ++p;
+    }
+    *isJSON = (p == end) || (*p == '{');
+    return YES;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,126 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "logWriter.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static inline void appendSegment(std::vector<struct iovec> &segments, const char *data, size_t length) {
+    if (length != 0) {
+        struct iovec segment;
+        segment.iov_base = const_cast<char *>(data);
+        segment.iov_len = length;
+        segments.push_back(segment);
+    }
+}
+
+#pragma mark - Creation & Destruction
+
+SCLogWriter::SCLogWriter(const char *data, size_t length) :
+    end_(data + length), p_(data), isFinished_(NO) {}
+
+#pragma mark - Public Methods
+
+BOOL SCLogWriter::replace(const char *start, const char *end, const char *text, size_t length) {
+    if (isFinished_ || (start < p_) || (end < start) || (end > end_)) {
+        fprintf(stderr, "ERROR: Replaced ranges must be in order and within the log.\n");
+        return NO;
+    }
+
+    appendSegment(segments_, p_, start - p_);
+    appendSegment(segments_, text, length);
+    p_ = end;
+    return YES;
+}
+
+const struct iovec *SCLogWriter::segments() {
+    finish();
+    return segments_.empty() ? NULL : &segments_[0];
+}
+
+size_t SCLogWriter::segmentCount() {
+    finish();
+    return segments_.size();
+}
+
+size_t SCLogWriter::length() {
+    finish();
+    size_t length = 0;
+    for (std::vector<struct iovec>::const_iterator i = segments_.begin(); i != segments_.end(); ++i) {
+        length += i->iov_len;
+    }
+    return length;
+}
+
+#pragma mark - Private Methods
+
+void SCLogWriter::finish() {
+    if (!isFinished_) {
+        isFinished_ = YES;
+        appendSegment(segments_, p_, end_ - p_);
+        p_ = end_;
+    }
+}
+
+#pragma mark - Functions
+
+BOOL writeSegments(int fd, const struct iovec *segments, size_t count) {
+    // NOTE: A partially written segment is resumed from a copy, as the
+    //       segments are not to be modified.
+    struct iovec partial;
+    while (count != 0) {
+        const int batchCount = (int)std::min(count, (size_t)IOV_MAX);
+        ssize_t written = writev(fd, segments, batchCount);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                // NOTE: The descriptor is non-blocking (e.g. an inherited
+                //       stdout); wait until it can be written to.
+                struct pollfd pollFD = {fd, POLLOUT, 0};
+                if ((poll(&pollFD, 1, -1) >= 0) || (errno == EINTR)) {
+                    continue;
+                }
+            }
+            fprintf(stderr, "ERROR: Failed to write: %s\n", strerror(errno));
+            return NO;
+        }
+
+        // Skip the segments that were written in full.
+        while ((count != 0) && ((size_t)written >= segments->iov_len)) {
+            written -= segments->iov_len;
+            ++segments;
+            --count;
+        }
+        if (written != 0) {
+            partial.iov_base = static_cast<char *>(segments->iov_base) + written;
+            partial.iov_len = segments->iov_len - written;
+            if (!writeSegments(fd, &partial, 1)) {
+                return NO;
+            }
+            ++segments;
+            --count;
+        }
+    }
+    return YES;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -9,369 +9,937 @@
 
 #include "methods.h"
 
+#include <dispatch/dispatch.h>
 #include <mach-o/loader.h>
-#include <sys/mman.h>
+#include <unistd.h>
+#include <launch-cache/FileAbstraction.hpp>
 
 #import "SCMethodInfo.h"
 #import "binary.h"
+#include "addressTable.h"
+#include "fixups.h"
+#include "image.h"
+#include "input.h"
+
+#include <algorithm>
+#include <stddef.h>
+
+#ifndef LC_DYLD_CHAINED_FIXUPS
+#define LC_DYLD_CHAINED_FIXUPS (0x34 | LC_REQ_DYLD)
+#endif
 
 #define RO_META     (1 << 0)
 #define RW_FUTURE   (1 << 30)
 #define RW_REALIZED (1 << 31)
 
+// NOTE: Method list flags are from objc-runtime-new.h (from objc4-818.2
+//       source). The low bits mark a list that was fixed up by the shared
+//       cache builder; the high bit marks a list of relative entries.
+#define METHOD_LIST_FIXED_UP     3
+#define METHOD_LIST_IS_RELATIVE  0x80000000
+#define METHOD_LIST_ENTSIZE_MASK 0x0000fffc
+
 // Declare necessary types.
 // NOTE: Type information is from objc-runtime-new.h (from objc4-551.1 source).
 //       Struct declarations have been altered to allow accessing only required
-//       information, and to differentiate 32 and 64 bit versions.
-
-struct objc_class {
-    uint32_t isa; // Actually declared in superstruct objc_object.
-    uint32_t superclass;
-    uint32_t buckets; // Part of cache_t struct.
-    uint16_t shiftmask; // Part of cache_t struct.
-    uint16_t occupied; // Part of cache_t struct.
-    uint32_t data_NEVER_USE; // class_rw/ro_t * plus custom rr/alloc flags
-
-    #define CLASS_FAST_FLAG_MASK 3
-    uint32_t data() {
-        return (data_NEVER_USE & ~CLASS_FAST_FLAG_MASK);
-    }
-};
+//       information. Pointer-sized fields use the abstractions from
+//       FileAbstraction.hpp, so that each struct serves both 32 and 64 bit.
 
-struct objc_class_64 {
-    uint64_t isa; // Actually declared in superstruct objc_object.
-    uint64_t superclass;
-    uint64_t buckets; // Part of cache_t struct.
-    uint32_t shiftmask; // Part of cache_t struct.
-    uint32_t occupied; // Part of cache_t struct.
-    uint64_t data_NEVER_USE; // class_rw/ro_t * plus custom rr/alloc flags
+template <typename P>
+struct objc_class_t {
+    typename P::uint_t isa; // Actually declared in superstruct objc_object.
+    typename P::uint_t superclass;
+    typename P::uint_t cache[2]; // cache_t struct (buckets, plus mask and occupied).
+    typename P::uint_t data_NEVER_USE; // class_rw/ro_t * plus custom rr/alloc flags
 
     #define CLASS_FAST_FLAG_MASK 3
-    uint64_t data() {
-        return (data_NEVER_USE & ~CLASS_FAST_FLAG_MASK);
-    }
 };
 
+template <typename P>
 struct class_ro_t {
     uint32_t flags;
     uint32_t instanceStart;
-    uint32_t instanceSize;
-    uint32_t ivarLayout;
-    uint32_t name;
-    uint32_t baseMethods;
+    // NOTE: For 64-bit, this slot also holds the 32-bit "reserved" field.
+    typename P::uint_t instanceSize;
+    typename P::uint_t ivarLayout;
+    typename P::uint_t name;
+    typename P::uint_t baseMethods;
     // ...
 };
 
-struct class_ro_64_t {
-    uint32_t flags;
-    uint32_t instanceStart;
-    uint32_t instanceSize;
-    uint32_t reserved;
-    uint64_t ivarLayout;
-    uint64_t name;
-    uint64_t baseMethods;
+template <typename P>
+struct category_t {
+    typename P::uint_t name;
+    typename P::uint_t cls;
+    typename P::uint_t instanceMethods;
+    typename P::uint_t classMethods;
     // ...
 };
 
+template <typename P>
 struct method_t {
-    uint32_t name;
-    uint32_t types;
-    uint32_t imp;
+    typename P::uint_t name;
+    typename P::uint_t types;
+    typename P::uint_t imp;
 };
 
-struct method_64_t {
-    uint64_t name;
-    uint64_t types;
-    uint64_t imp;
+// NOTE: Each offset is relative to the address of the field itself.
+struct relative_method_t {
+    int32_t name; // Offset to a selector reference.
+    int32_t types;
+    int32_t imp;
 };
 
-// NOTE: The first three fields of segment_command and segment_command_64, the
-//       only fields that we need for this function, are the same name and size.
-//       Therefore, it is not necessary to create separate 32/64 bit versions.
-static segment_command *segmentNamed(load_command *cmds, uint32_t ncmds, const char *name) {
-    segment_command *segment = NULL;
+template <typename P> struct macho_types;
 
-    load_command *cmd = cmds;
-    for (uint32_t i = 0; i < ncmds; ++i) {
-        if ((cmd->cmd == LC_SEGMENT) || (cmd->cmd == LC_SEGMENT_64)) {
-            segment_command *seg = reinterpret_cast<segment_command *>(cmd);
-            if (strcmp(seg->segname, name) == 0) {
-                segment = seg;
-                break;
-            }
+template <> struct macho_types<Pointer32<LittleEndian> > {
+    typedef mach_header header_t;
+    typedef segment_command segment_t;
+    typedef section section_t;
+    static const uint32_t kSegmentCommand = LC_SEGMENT;
+};
+
+template <> struct macho_types<Pointer64<LittleEndian> > {
+    typedef mach_header_64 header_t;
+    typedef segment_command_64 segment_t;
+    typedef section_64 section_t;
+    static const uint32_t kSegmentCommand = LC_SEGMENT_64;
+};
+
+typedef struct _SCMethodEntry {
+    uint64_t address;
+    uint32_t className;
+    uint32_t selector;
+    char type;
+} SCMethodEntry;
+
+static bool compareMethodEntries(const SCMethodEntry &a, const SCMethodEntry &b) {
+    return a.address < b.address;
+}
+
+// NOTE: Methods are collected in chunks of the class and category lists, each
+//       with its own buffers, so that chunks can be processed concurrently.
+typedef struct _SCMethodChunk {
+    std::vector<SCMethodEntry> entries;
+    std::vector<char> strings;
+} SCMethodChunk;
+
+// NOTE: Lists smaller than this are walked as a single chunk.
+static const uint64_t kMinimumClassesPerChunk = 512;
+
+// NOTE: Sections that are closer together than this are mapped as a single
+//       region.
+static const uint64_t kMaximumRegionGap = 0x1000;
+
+// NOTE: Names that are not located in a mapped section are read in pieces of
+//       this size, up to the given length.
+static const size_t kNameReadSize = 256;
+static const size_t kMaximumNameLength = 0x10000;
+
+template <typename P>
+class SCMethodTableBuilder {
+    public:
+        SCMethodTableBuilder(SCInput *input, uint64_t offset, size_t size) :
+            input_(input), offset_(offset), size_(size), fixups_(NULL),
+            classListOffset_(0), numClasses_(0), categoryListOffset_(0), numCategories_(0) {}
+        ~SCMethodTableBuilder();
+        SCMethodTable *build();
+
+    private:
+        typedef typename P::E E;
+        typedef typename P::uint_t pint_t;
+        typedef typename macho_types<P>::header_t header_t;
+        typedef typename macho_types<P>::segment_t segment_t;
+        typedef typename macho_types<P>::section_t section_t;
+        typedef SCMethodTable::SCRegion SCRegion;
+
+        BOOL parseLoadCommands();
+        // NOTE: Sorts the regions by offset and merges those that overlap or
+        //       are close together, then maps them.
+        BOOL mapRegions(std::vector<SCRegion> &regions);
+        const SCRegion *regionForOffset(const std::vector<SCRegion> &regions, uint64_t offset) const {
+            return SCMethodTable::regionForOffset(regions, offset);
         }
 
-        // Prepare next command.
-        cmd = reinterpret_cast<load_command *>(reinterpret_cast<uint8_t *>(cmd) + cmd->cmdsize);
-    }
+        // NOTE: Addresses are translated using the segments of the binary.
+        BOOL fileOffsetForAddress(uint64_t address, uint64_t *offset) const;
+        // NOTE: Data is copied from the mapped sections where possible, and
+        //       read from the input otherwise (e.g. for classes located in
+        //       __DATA,__data).
+        BOOL readData(uint64_t offset, void *buffer, size_t length) const;
+        template <typename T> BOOL readStruct(uint64_t address, T *object, uint64_t *offset) const {
+            return fileOffsetForAddress(address, offset) && readData(*offset, object, sizeof(T));
+        }
+        // NOTE: The raw value is the pointer as read from the given offset.
+        //       Pointers that are bound to symbols in other images resolve to
+        //       zero.
+        uint64_t resolvePointer(uint64_t offset, pint_t raw) const;
+        BOOL readPointerAtOffset(uint64_t offset, uint64_t *value) const;
+        BOOL readPointer(uint64_t address, uint64_t *value) const;
+        const char *importedClassName(uint64_t offset) const;
+
+        // NOTE: Returns NO if the name is not terminated within its section
+        //       (or within kMaximumNameLength, if it is not in a mapped
+        //       section); nothing is appended in that case.
+        BOOL appendName(uint64_t offset, std::vector<char> &strings) const;
+        // NOTE: Names in the mapped name sections are referenced in place;
+        //       others are copied to the buffer of the chunk. Such names are
+        //       rare (see appendName()), and so are not deduplicated.
+        BOOL getNameReference(uint64_t address, std::vector<char> &strings, uint32_t *reference) const;
+
+        void walkClass(uint64_t address, SCMethodChunk &chunk) const;
+        void walkCategory(uint64_t address, SCMethodChunk &chunk) const;
+        void walkMethodList(uint64_t address, uint32_t className, char methodType, SCMethodChunk &chunk) const;
+
+        // NOTE: Only needed for names that are not located in the binary
+        //       itself (selectors of preoptimized method lists, which point
+        //       into the shared cache of the running process).
+        static uint32_t appendString(std::vector<char> &strings, const char *string) {
+            const uint32_t offset = strings.size();
+            strings.insert(strings.end(), string, string + strlen(string) + 1);
+            return (offset | SCMethodTable::kStringBufferFlag);
+        }
+
+        SCInput *input_;
+        uint64_t offset_;
+        size_t size_;
+        std::vector<SCSegmentInfo> segments_;
+        std::vector<uint8_t> fixupsData_;
+        SCChainedFixups *fixups_;
+        // NOTE: Views of the Objective-C sections, sorted by offset. The views
+        //       of the name sections are handed over to the table.
+        std::vector<SCRegion> regions_;
+        std::vector<SCRegion> nameRegions_;
+        uint64_t classListOffset_;
+        uint64_t numClasses_;
+        uint64_t categoryListOffset_;
+        uint64_t numCategories_;
+};
 
-    return segment;
+template <typename P>
+SCMethodTableBuilder<P>::~SCMethodTableBuilder() {
+    for (std::vector<SCRegion>::const_iterator i = regions_.begin(); i != regions_.end(); ++i) {
+        input_->unmap(i->data, offset_ + i->offset, i->length);
+    }
+    for (std::vector<SCRegion>::const_iterator i = nameRegions_.begin(); i != nameRegions_.end(); ++i) {
+        input_->unmap(i->data, offset_ + i->offset, i->length);
+    }
+    delete fixups_;
 }
 
-static section *sectionNamed32(segment_command *segment, const char *name) {
-    section *section = NULL;
+template <typename P>
+BOOL SCMethodTableBuilder<P>::parseLoadCommands() {
+    header_t header;
+    if ((size_ < sizeof(header_t)) || !input_->read(&header, sizeof(header_t), offset_)) {
+        return NO;
+    }
+
+    // NOTE: Only the load commands are read here; sections are mapped below.
+    const uint32_t ncmds = E::get32(header.ncmds);
+    const uint32_t sizeofcmds = std::min((size_t)E::get32(header.sizeofcmds), size_ - sizeof(header_t));
+    std::vector<uint8_t> commands(sizeofcmds);
+    if ((sizeofcmds == 0) || !input_->read(&commands[0], sizeofcmds, offset_ + sizeof(header_t))) {
+        return NO;
+    }
 
-    struct section *sect = reinterpret_cast<struct section *>(reinterpret_cast<uint8_t *>(segment) + sizeof(segment_command));
-    for (uint32_t i = 0; i < segment->nsects; ++i, ++sect) {
-        if (strcmp(sect->sectname, name) == 0) {
-            section = sect;
+    const uint8_t *cmds = &commands[0];
+    const uint8_t *end = cmds + sizeofcmds;
+    const linkedit_data_command *fixupsCmd = NULL;
+    std::vector<SCRegion> regions;
+    std::vector<SCRegion> nameRegions;
+    for (uint32_t i = 0; i < ncmds; ++i) {
+        const load_command *cmd = reinterpret_cast<const load_command *>(cmds);
+        if ((size_t)(end - cmds) < sizeof(load_command)) {
             break;
         }
+        const uint32_t cmdsize = E::get32(cmd->cmdsize);
+        if ((cmdsize < sizeof(load_command)) || (cmdsize > (size_t)(end - cmds))) {
+            break;
+        }
+
+        if ((E::get32(cmd->cmd) == macho_types<P>::kSegmentCommand) && (cmdsize >= sizeof(segment_t))) {
+            const segment_t *seg = reinterpret_cast<const segment_t *>(cmd);
+
+            SCSegmentInfo segment;
+            memcpy(segment.name, seg->segname, 16);
+            segment.name[16] = '\0';
+            segment.vmaddr = P::getP(seg->vmaddr);
+            segment.vmsize = P::getP(seg->vmsize);
+            segment.fileoff = P::getP(seg->fileoff);
+            segment.filesize = P::getP(seg->filesize);
+            segments_.push_back(segment);
+
+            // Look for the Objective-C sections.
+            const uint32_t nsects = std::min(E::get32(seg->nsects), (uint32_t)((cmdsize - sizeof(segment_t)) / sizeof(section_t)));
+            const section_t *sect = reinterpret_cast<const section_t *>(seg + 1);
+            for (uint32_t j = 0; j < nsects; ++j, ++sect) {
+                if (strncmp(sect->sectname, "__objc_", 7) != 0) {
+                    continue;
+                }
+
+                const uint64_t offset = E::get32(sect->offset);
+                const uint64_t size = P::getP(sect->size);
+                if ((offset == 0) || (size == 0) || (offset > size_) || (size > (size_ - offset))) {
+                    continue;
+                }
+
+                // NOTE: Method types are not used.
+                SCRegion region = {offset, (size_t)size, NULL};
+                if ((strncmp(sect->sectname, "__objc_methname", 16) == 0) ||
+                        (strncmp(sect->sectname, "__objc_classname", 16) == 0)) {
+                    nameRegions.push_back(region);
+                } else if (strncmp(sect->sectname, "__objc_methtype", 16) != 0) {
+                    regions.push_back(region);
+                }
+
+                // NOTE: Depending on the linker version, the class and category
+                //       lists may be located in either __DATA or __DATA_CONST.
+                if (strncmp(sect->segname, "__DATA", 6) == 0) {
+                    if (strncmp(sect->sectname, "__objc_classlist", 16) == 0) {
+                        classListOffset_ = offset;
+                        numClasses_ = size / sizeof(pint_t);
+                    } else if (strncmp(sect->sectname, "__objc_catlist", 16) == 0) {
+                        categoryListOffset_ = offset;
+                        numCategories_ = size / sizeof(pint_t);
+                    }
+                }
+            }
+        } else if ((E::get32(cmd->cmd) == LC_DYLD_CHAINED_FIXUPS) && (cmdsize >= sizeof(linkedit_data_command))) {
+            fixupsCmd = reinterpret_cast<const linkedit_data_command *>(cmd);
+        }
+
+        // Prepare next command.
+        cmds += cmdsize;
+    }
+
+    if (!mapRegions(regions) || !mapRegions(nameRegions)) {
+        return NO;
+    }
+    regions_.swap(regions);
+    nameRegions_.swap(nameRegions);
+
+    // NOTE: Segments must all be known before the fixups can be decoded.
+    // NOTE: If the fixups cannot be decoded, pointers are read as plain
+    //       addresses; the walk will then simply find fewer methods.
+    if (fixupsCmd != NULL) {
+        const uint64_t dataOffset = E::get32(fixupsCmd->dataoff);
+        const uint32_t dataSize = E::get32(fixupsCmd->datasize);
+        if ((dataOffset <= size_) && (dataSize <= (size_ - dataOffset)) && (dataSize != 0)) {
+            fixupsData_.resize(dataSize);
+            if (input_->read(&fixupsData_[0], dataSize, offset_ + dataOffset)) {
+                fixups_ = SCChainedFixups::create(&fixupsData_[0], dataSize, segments_);
+            }
+        } else {
+            fprintf(stderr, "ERROR: Chained fixups data is out of bounds.\n");
+        }
     }
 
-    return section;
+    return YES;
 }
 
-static section_64 *sectionNamed64(segment_command_64 *segment, const char *name) {
-    section_64 *section = NULL;
+template <typename P>
+BOOL SCMethodTableBuilder<P>::mapRegions(std::vector<SCRegion> &regions) {
+    std::sort(regions.begin(), regions.end(), SCMethodTable::compareRegions);
+    std::vector<SCRegion> merged;
+    for (std::vector<SCRegion>::const_iterator i = regions.begin(); i != regions.end(); ++i) {
+        if (!merged.empty() && ((i->offset - merged.back().offset) <= (merged.back().length + kMaximumRegionGap))) {
+            SCRegion &last = merged.back();
+            last.length = std::max((uint64_t)last.length, (i->offset - last.offset) + i->length);
+        } else {
+            merged.push_back(*i);
+        }
+    }
+    regions.swap(merged);
+
+    for (std::vector<SCRegion>::iterator i = regions.begin(); i != regions.end(); ++i) {
+        i->data = input_->map(offset_ + i->offset, i->length);
+        if (i->data == NULL) {
+            fprintf(stderr, "ERROR: Failed to map Objective-C sections.\n");
+            for (std::vector<SCRegion>::iterator j = regions.begin(); j != i; ++j) {
+                input_->unmap(j->data, offset_ + j->offset, j->length);
+            }
+            regions.clear();
+            return NO;
+        }
+    }
+    return YES;
+}
 
-    struct section_64 *sect = reinterpret_cast<struct section_64 *>(reinterpret_cast<uint8_t *>(segment) + sizeof(segment_command_64));
-    for (uint32_t i = 0; i < segment->nsects; ++i, ++sect) {
-        if (strcmp(sect->sectname, name) == 0) {
-            section = sect;
+template <typename P>
+BOOL SCMethodTableBuilder<P>::fileOffsetForAddress(uint64_t address, uint64_t *offset) const {
+    for (std::vector<SCSegmentInfo>::const_iterator i = segments_.begin(); i != segments_.end(); ++i) {
+        if ((address >= i->vmaddr) && ((address - i->vmaddr) < i->filesize)) {
+            const uint64_t result = i->fileoff + (address - i->vmaddr);
+            if (result < size_) {
+                *offset = result;
+                return YES;
+            }
             break;
         }
     }
+    return NO;
+}
+
+template <typename P>
+BOOL SCMethodTableBuilder<P>::readData(uint64_t offset, void *buffer, size_t length) const {
+    if ((offset > size_) || (length > (size_ - offset))) {
+        return NO;
+    }
 
-    return section;
+    const SCRegion *region = regionForOffset(regions_, offset);
+    if ((region != NULL) && (length <= (region->length - (offset - region->offset)))) {
+        memcpy(buffer, region->data + (offset - region->offset), length);
+        return YES;
+    }
+    return input_->read(buffer, length, offset_ + offset);
 }
 
-static NSArray *methodsForMappedMemory32(uint8_t *memory) {
-    NSMutableArray *methods = [NSMutableArray array];
+template <typename P>
+uint64_t SCMethodTableBuilder<P>::resolvePointer(uint64_t offset, pint_t raw) const {
+    if (fixups_ != NULL) {
+        uint64_t value;
+        switch (fixups_->fixupAtOffset(offset, P::getP(raw), &value)) {
+            case SCFixupRebase:
+                return value;
+            case SCFixupBind:
+                return 0;
+            default:
+                break;
+        }
+    }
+    return P::getP(raw);
+}
 
-    if (memory != NULL) {
-        mach_header *header = reinterpret_cast<mach_header *>(memory);
-        uint32_t ncmds = header->ncmds;
+template <typename P>
+BOOL SCMethodTableBuilder<P>::readPointerAtOffset(uint64_t offset, uint64_t *value) const {
+    pint_t raw;
+    if (readData(offset, &raw, sizeof(pint_t))) {
+        *value = resolvePointer(offset, raw);
+        return YES;
+    }
+    return NO;
+}
 
-        // XXX: For normal binaries (not from shared cache), will there
-        //      ever be a time where the segments are not contiguous in virtual
-        //      memory space?
-        load_command *cmds = reinterpret_cast<load_command *>(memory + sizeof(mach_header));
+template <typename P>
+BOOL SCMethodTableBuilder<P>::readPointer(uint64_t address, uint64_t *value) const {
+    uint64_t offset;
+    return fileOffsetForAddress(address, &offset) && readPointerAtOffset(offset, value);
+}
 
-        segment_command *textSeg = segmentNamed(cmds, ncmds, "__TEXT");
-        if (textSeg == NULL) {
-            fprintf(stderr, "ERROR: Segment \"__TEXT\" not found.\n");
-            return nil;
+template <typename P>
+const char *SCMethodTableBuilder<P>::importedClassName(uint64_t offset) const {
+    static const char prefix[] = "_OBJC_CLASS_$_";
+
+    pint_t raw;
+    uint64_t ordinal;
+    if ((fixups_ != NULL) && readData(offset, &raw, sizeof(pint_t)) &&
+            (fixups_->fixupAtOffset(offset, P::getP(raw), &ordinal) == SCFixupBind)) {
+        const char *name = fixups_->importName(ordinal);
+        if ((name != NULL) && (strncmp(name, prefix, sizeof(prefix) - 1) == 0)) {
+            return name + sizeof(prefix) - 1;
         }
-        int32_t vmdiff_text = textSeg->vmaddr - textSeg->fileoff;
+    }
+    return NULL;
+}
 
-        segment_command *dataSeg = segmentNamed(cmds, ncmds, "__DATA");
-        if (dataSeg == NULL) {
-            fprintf(stderr, "ERROR: Segment \"__DATA\" not found.\n");
-            return nil;
+template <typename P>
+BOOL SCMethodTableBuilder<P>::appendName(uint64_t offset, std::vector<char> &strings) const {
+    const SCRegion *region = regionForOffset(nameRegions_, offset);
+    if (region == NULL) {
+        region = regionForOffset(regions_, offset);
+    }
+    if (region != NULL) {
+        const char *name = reinterpret_cast<const char *>(region->data + (offset - region->offset));
+        const char *end = reinterpret_cast<const char *>(memchr(name, '\0', region->length - (offset - region->offset)));
+        if (end == NULL) {
+            return NO;
         }
-        int32_t vmdiff_data = dataSeg->vmaddr - dataSeg->fileoff;
+        strings.insert(strings.end(), name, end);
+        return YES;
+    }
 
-        section *objcClassListSect = sectionNamed32(dataSeg, "__objc_classlist__DATA");
-        if (objcClassListSect == NULL) {
-            // NOTE: File may not contain any Objective-C classes.
-            fprintf(stderr, "INFO: Section \"__objc_classlist__DATA\" not found.\n");
-            return nil;
+    const size_t start = strings.size();
+    char buffer[kNameReadSize];
+    for (uint64_t position = offset; (position < size_) && ((position - offset) < kMaximumNameLength); position += kNameReadSize) {
+        const size_t length = std::min((uint64_t)kNameReadSize, size_ - position);
+        if (!input_->read(buffer, length, offset_ + position)) {
+            break;
         }
+        char *end = reinterpret_cast<char *>(memchr(buffer, '\0', length));
+        strings.insert(strings.end(), buffer, (end != NULL) ? end : (buffer + length));
+        if (end != NULL) {
+            return YES;
+        }
+    }
+    strings.resize(start);
+    return NO;
+}
 
-        section *objcDataSect = sectionNamed32(dataSeg, "__objc_data");
-        if (objcDataSect == NULL) {
-            // NOTE: File may not contain any Objective-C classes.
-            fprintf(stderr, "INFO: Section \"__objc_data\" not found.\n");
-            return nil;
+template <typename P>
+BOOL SCMethodTableBuilder<P>::getNameReference(uint64_t address, std::vector<char> &strings, uint32_t *reference) const {
+    uint64_t offset;
+    if (!fileOffsetForAddress(address, &offset)) {
+        return NO;
+    }
+
+    const SCRegion *region = regionForOffset(nameRegions_, offset);
+    if (region != NULL) {
+        const uint64_t start = offset - region->offset;
+        if (memchr(region->data + start, '\0', region->length - start) == NULL) {
+            return NO;
         }
+        *reference = offset;
+        return YES;
+    }
 
-        uint32_t *classList = reinterpret_cast<uint32_t *>(memory + objcClassListSect->offset);
-        const uint32_t numClasses = objcClassListSect->size / sizeof(uint32_t);
-        for (uint32_t i = 0; i < numClasses; ++i) {
-            objc_class *klass = reinterpret_cast<objc_class *>(memory + classList[i] - vmdiff_data);
+    const uint32_t position = strings.size();
+    if (!appendName(offset, strings)) {
+        return NO;
+    }
+    strings.push_back('\0');
+    *reference = (position | SCMethodTable::kStringBufferFlag);
+    return YES;
+}
 
-process_class:
-            class_ro_t *klass_ro = reinterpret_cast<class_ro_t *>(memory + klass->data() - vmdiff_data);
-
-            // Confirm struct is actually class_ro_t (and not class_rw_t).
-            // NOTE: A "realized" or "future" class will be class_rw_t.
-            // XXX: It is assumed that these flags will only be true for
-            //      dynamically created classes.
-            const uint32_t flags = klass_ro->flags;
-            if (!(flags & RW_REALIZED) && !(flags & RW_FUTURE)) {
-                const char methodType = (flags & 1) ? '+' : '-';
-                const char *className = reinterpret_cast<const char *>(memory + klass_ro->name - vmdiff_text);
-
-                if (klass_ro->baseMethods != 0) {
-                    uint32_t *baseMethods = reinterpret_cast<uint32_t *>(memory + klass_ro->baseMethods - vmdiff_data);
-                    BOOL isPreoptimized = (baseMethods[0] & 3);
-                    //const uint32_t entsize = baseMethods[0] & ~(uint32_t)3;
-                    const uint32_t count = baseMethods[1];
-
-                    method_t *methodEntries = reinterpret_cast<method_t *>(&baseMethods[2]);
-                    for (uint32_t j = 0; j < count; ++j) {
-                        const char *methodName = NULL;
-                        if (isPreoptimized) {
-                            methodName = reinterpret_cast<const char *>(methodEntries[j].name);
-                        } else {
-                            methodName = reinterpret_cast<const char *>(memory + methodEntries[j].name - vmdiff_text);
-                        }
-                        NSString *name = [[NSString alloc] initWithFormat:@"%c[%s %s]", methodType, className, methodName];
-
-                        SCMethodInfo *mi = [SCMethodInfo new];
-                        [mi setName:name];
-                        [mi setAddress:methodEntries[j].imp];
-                        [methods addObject:mi];
-                        [mi release];
-
-                        [name release];
-                    }
+template <typename P>
+SCMethodTable *SCMethodTableBuilder<P>::build() {
+    // NOTE: String references use the top bit as a flag (see methods.h).
+    if (size_ >= SCMethodTable::kStringBufferFlag) {
+        fprintf(stderr, "ERROR: Binary is too large to extract methods from.\n");
+        return NULL;
+    }
+
+    if (!parseLoadCommands()) {
+        fprintf(stderr, "ERROR: Failed to parse load commands.\n");
+        return NULL;
+    }
+
+    if ((numClasses_ == 0) && (numCategories_ == 0)) {
+        // NOTE: File may not contain any Objective-C classes.
+        fprintf(stderr, "INFO: Sections \"__objc_classlist\" and \"__objc_catlist\" not found.\n");
+        return NULL;
+    }
+
+    // Split the class and category lists into chunks.
+    // NOTE: Classes and categories are treated as a single list, with the
+    //       categories following the classes.
+    // NOTE: Use a few chunks per CPU so that uneven chunks balance out.
+    const uint64_t numItems = numClasses_ + numCategories_;
+    const uint64_t numCPUs = std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+    const uint64_t itemsPerChunk = std::max((numItems + (numCPUs * 4) - 1) / (numCPUs * 4), kMinimumClassesPerChunk);
+    const size_t numChunks = std::max((numItems + itemsPerChunk - 1) / itemsPerChunk, (uint64_t)1);
+
+    // Walk and sort each chunk.
+    std::vector<SCMethodChunk> chunks(numChunks);
+    SCMethodChunk *chunksRef = &chunks[0];
+    const SCMethodTableBuilder<P> *builder = this;
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_apply(numChunks, queue, ^(size_t i) {
+        const uint64_t begin = i * itemsPerChunk;
+        const uint64_t end = std::min(begin + itemsPerChunk, numItems);
+        for (uint64_t j = begin; j < end; ++j) {
+            uint64_t address;
+            if (j < builder->numClasses_) {
+                if (builder->readPointerAtOffset(builder->classListOffset_ + j * sizeof(pint_t), &address)) {
+                    builder->walkClass(address, chunksRef[i]);
+                }
+            } else {
+                if (builder->readPointerAtOffset(builder->categoryListOffset_ + (j - builder->numClasses_) * sizeof(pint_t), &address)) {
+                    builder->walkCategory(address, chunksRef[i]);
                 }
             }
-
-            if (!(flags & RO_META)) {
-                // Process meta class.
-                // NOTE: This is needed for retrieving class (non-instance) methods.
-                klass = reinterpret_cast<objc_class *>(memory + klass->isa - vmdiff_data);
-                goto process_class;
+        }
+        std::sort(chunksRef[i].entries.begin(), chunksRef[i].entries.end(), compareMethodEntries);
+    });
+
+    // Combine the string buffers of the chunks.
+    // NOTE: References into a chunk's buffer must be offset by the position of
+    //       that buffer in the combined buffer.
+    SCMethodTable *table = new SCMethodTable();
+    std::vector<std::vector<SCMethodEntry> > runs(numChunks);
+    for (size_t i = 0; i < numChunks; ++i) {
+        SCMethodChunk &chunk = chunks[i];
+        if (!chunk.strings.empty()) {
+            const uint32_t base = table->strings_.size();
+            for (std::vector<SCMethodEntry>::iterator j = chunk.entries.begin(); j != chunk.entries.end(); ++j) {
+                if (j->className & SCMethodTable::kStringBufferFlag) {
+                    j->className += base;
+                }
+                if (j->selector & SCMethodTable::kStringBufferFlag) {
+                    j->selector += base;
+                }
             }
+            table->strings_.insert(table->strings_.end(), chunk.strings.begin(), chunk.strings.end());
         }
+        runs[i].swap(chunk.entries);
     }
 
-    return methods;
+    // Merge the sorted chunks, pairwise and in parallel.
+    while (runs.size() > 1) {
+        const size_t numPairs = runs.size() / 2;
+        std::vector<std::vector<SCMethodEntry> > merged(numPairs + (runs.size() % 2));
+        std::vector<SCMethodEntry> *runsRef = &runs[0];
+        std::vector<SCMethodEntry> *mergedRef = &merged[0];
+        dispatch_apply(numPairs, queue, ^(size_t i) {
+            std::vector<SCMethodEntry> &a = runsRef[2 * i];
+            std::vector<SCMethodEntry> &b = runsRef[2 * i + 1];
+            mergedRef[i].resize(a.size() + b.size());
+            std::merge(a.begin(), a.end(), b.begin(), b.end(), mergedRef[i].begin(), compareMethodEntries);
+            std::vector<SCMethodEntry>().swap(a);
+            std::vector<SCMethodEntry>().swap(b);
+        });
+        if ((runs.size() % 2) != 0) {
+            merged.back().swap(runs.back());
+        }
+        runs.swap(merged);
+    }
+
+    // Split into parallel arrays.
+    const std::vector<SCMethodEntry> &entries = runs[0];
+    const size_t count = entries.size();
+    std::vector<uint64_t> addresses;
+    addresses.reserve(count);
+    table->classNames_.reserve(count);
+    table->selectors_.reserve(count);
+    table->types_.reserve(count);
+    for (std::vector<SCMethodEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+        addresses.push_back(i->address);
+        table->classNames_.push_back(i->className);
+        table->selectors_.push_back(i->selector);
+        table->types_.push_back(i->type);
+    }
+
+    // NOTE: The views of the name sections are kept for as long as the table.
+    input_->retain();
+    table->input_ = input_;
+    table->offset_ = offset_;
+    table->regions_.swap(nameRegions_);
+
+    table->addressTable_ = SCAddressTable::create((count != 0) ? &addresses[0] : NULL, count);
+    if (table->addressTable_ == NULL) {
+        table->release();
+        return NULL;
+    }
+
+    return table;
 }
 
-static NSArray *methodsForMappedMemory64(uint8_t *memory) {
-    NSMutableArray *methods = [NSMutableArray array];
+template <typename P>
+void SCMethodTableBuilder<P>::walkClass(uint64_t address, SCMethodChunk &chunk) const {
+    BOOL isMetaClass = NO;
 
-    if (memory != NULL) {
-        mach_header_64 *header = reinterpret_cast<mach_header_64 *>(memory);
-        uint32_t ncmds = header->ncmds;
+process_class:
+    objc_class_t<P> klass;
+    uint64_t classOffset;
+    if (!readStruct(address, &klass, &classOffset)) {
+        return;
+    }
 
-        // XXX: For normal binaries (not from shared cache), will there
-        //      ever be a time where the segments are not contiguous in virtual
-        //      memory space?
-        load_command *cmds = reinterpret_cast<load_command *>(memory + sizeof(mach_header_64));
+    const uint64_t dataAddress = resolvePointer(classOffset + offsetof(objc_class_t<P>, data_NEVER_USE), klass.data_NEVER_USE) & ~CLASS_FAST_FLAG_MASK;
+    class_ro_t<P> klass_ro;
+    uint64_t roOffset;
+    if (!readStruct(dataAddress, &klass_ro, &roOffset)) {
+        return;
+    }
 
-        segment_command_64 *textSeg = reinterpret_cast<segment_command_64 *>(segmentNamed(cmds, ncmds, "__TEXT"));
-        if (textSeg == NULL) {
-            fprintf(stderr, "ERROR: Segment \"__TEXT\" not found.\n");
-            return nil;
+    // Confirm struct is actually class_ro_t (and not class_rw_t).
+    // NOTE: A "realized" or "future" class will be class_rw_t.
+    // XXX: It is assumed that these flags will only be true for
+    //      dynamically created classes.
+    const uint32_t flags = E::get32(klass_ro.flags);
+    if (!(flags & RW_REALIZED) && !(flags & RW_FUTURE)) {
+        uint32_t className;
+        if (getNameReference(resolvePointer(roOffset + offsetof(class_ro_t<P>, name), klass_ro.name), chunk.strings, &className)) {
+            const char methodType = (flags & RO_META) ? '+' : '-';
+            walkMethodList(resolvePointer(roOffset + offsetof(class_ro_t<P>, baseMethods), klass_ro.baseMethods), className, methodType, chunk);
         }
-        int64_t vmdiff_text = textSeg->vmaddr - textSeg->fileoff;
+    }
 
-        segment_command_64 *dataSeg = reinterpret_cast<segment_command_64 *>(segmentNamed(cmds, ncmds, "__DATA"));
-        if (dataSeg == NULL) {
-            fprintf(stderr, "ERROR: Segment \"__DATA\" not found.\n");
-            return nil;
-        }
-        int64_t vmdiff_data = dataSeg->vmaddr - dataSeg->fileoff;
+    if (!(flags & RO_META) && !isMetaClass) {
+        // Process meta class.
+        // NOTE: This is needed for retrieving class (non-instance) methods.
+        isMetaClass = YES;
+        address = resolvePointer(classOffset + offsetof(objc_class_t<P>, isa), klass.isa);
+        goto process_class;
+    }
+}
+
+template <typename P>
+void SCMethodTableBuilder<P>::walkCategory(uint64_t address, SCMethodChunk &chunk) const {
+    category_t<P> category;
+    uint64_t categoryOffset;
+    if (!readStruct(address, &category, &categoryOffset)) {
+        return;
+    }
 
-        section_64 *objcClassListSect = sectionNamed64(dataSeg, "__objc_classlist__DATA");
-        if (objcClassListSect == NULL) {
-            // NOTE: File may not contain any Objective-C classes.
-            fprintf(stderr, "INFO: Section \"__objc_classlist__DATA\" not found.\n");
-            return nil;
+    uint64_t categoryNameOffset;
+    if (!fileOffsetForAddress(resolvePointer(categoryOffset + offsetof(category_t<P>, name), category.name), &categoryNameOffset)) {
+        return;
+    }
+
+    // Determine the name of the class that the category extends.
+    // NOTE: If the class is defined in another image, the pointer is bound at
+    //       load time. With chained fixups, the name of the class can be taken
+    //       from the import; otherwise it is not known.
+    const uint64_t classPointerOffset = categoryOffset + offsetof(category_t<P>, cls);
+    const char *className = importedClassName(classPointerOffset);
+    if (className == NULL) {
+        className = "?";
+    }
+    BOOL hasClassNameOffset = NO;
+    uint64_t classNameOffset = 0;
+    objc_class_t<P> klass;
+    uint64_t classOffset;
+    if (readStruct(resolvePointer(classPointerOffset, category.cls), &klass, &classOffset)) {
+        const uint64_t dataAddress = resolvePointer(classOffset + offsetof(objc_class_t<P>, data_NEVER_USE), klass.data_NEVER_USE) & ~CLASS_FAST_FLAG_MASK;
+        class_ro_t<P> klass_ro;
+        uint64_t roOffset;
+        if (readStruct(dataAddress, &klass_ro, &roOffset)) {
+            hasClassNameOffset = fileOffsetForAddress(resolvePointer(roOffset + offsetof(class_ro_t<P>, name), klass_ro.name), &classNameOffset);
         }
+    }
 
-        section_64 *objcDataSect = sectionNamed64(dataSeg, "__objc_data");
-        if (objcDataSect == NULL) {
-            // NOTE: File may not contain any Objective-C classes.
-            fprintf(stderr, "INFO: Section \"__objc_data\" not found.\n");
-            return nil;
+    // NOTE: The name, of the form "Class(Category)", is built once per
+    //       category and shared by all of its methods. If either name is not
+    //       terminated, the category is skipped.
+    std::vector<char> &strings = chunk.strings;
+    const uint32_t start = strings.size();
+    if (hasClassNameOffset) {
+        if (!appendName(classNameOffset, strings)) {
+            return;
         }
+    } else {
+        strings.insert(strings.end(), className, className + strlen(className));
+    }
+    strings.push_back('(');
+    if (!appendName(categoryNameOffset, strings)) {
+        strings.resize(start);
+        return;
+    }
+    strings.push_back(')');
+    strings.push_back('\0');
 
-        uint64_t *classList = reinterpret_cast<uint64_t *>(memory + objcClassListSect->offset);
-        const uint64_t numClasses = objcClassListSect->size / sizeof(uint64_t);
-        for (uint64_t i = 0; i < numClasses; ++i) {
-            objc_class_64 *klass = reinterpret_cast<objc_class_64 *>(memory + classList[i] - vmdiff_data);
+    const uint32_t name = (start | SCMethodTable::kStringBufferFlag);
+    walkMethodList(resolvePointer(categoryOffset + offsetof(category_t<P>, instanceMethods), category.instanceMethods), name, '-', chunk);
+    walkMethodList(resolvePointer(categoryOffset + offsetof(category_t<P>, classMethods), category.classMethods), name, '+', chunk);
+}
 
-process_class:
-            class_ro_64_t *klass_ro = reinterpret_cast<class_ro_64_t *>(memory + klass->data() - vmdiff_data);
-
-            // Confirm struct is actually class_ro_t (and not class_rw_t).
-            // NOTE: A "realized" or "future" class will be class_rw_t.
-            // XXX: It is assumed that these flags will only be true for
-            //      dynamically created classes.
-            const uint32_t flags = klass_ro->flags;
-            if (!(flags & RW_REALIZED) && !(flags & RW_FUTURE)) {
-                const char methodType = (flags & 1) ? '+' : '-';
-                const char *className = reinterpret_cast<const char *>(memory + klass_ro->name - vmdiff_text);
-
-                if (klass_ro->baseMethods != 0) {
-                    uint32_t *baseMethods = reinterpret_cast<uint32_t *>(memory + klass_ro->baseMethods - vmdiff_data);
-                    BOOL isPreoptimized = (baseMethods[0] & 3);
-                    //const uint32_t entsize = baseMethods[0] & ~(uint32_t)3;
-                    const uint32_t count = baseMethods[1];
-
-                    method_64_t *methodEntries = reinterpret_cast<method_64_t *>(&baseMethods[2]);
-                    for (uint32_t j = 0; j < count; ++j) {
-                        const char *methodName = NULL;
-                        if (isPreoptimized) {
-                            methodName = reinterpret_cast<const char *>(methodEntries[j].name);
-                        } else {
-                            methodName = reinterpret_cast<const char *>(memory + methodEntries[j].name - vmdiff_text);
-                        }
-                        NSString *name = [[NSString alloc] initWithFormat:@"%c[%s %s]", methodType, className, methodName];
-
-                        SCMethodInfo *mi = [SCMethodInfo new];
-                        [mi setName:name];
-                        [mi setAddress:methodEntries[j].imp];
-                        [methods addObject:mi];
-                        [mi release];
-
-                        [name release];
-                    }
-                }
-            }
+template <typename P>
+void SCMethodTableBuilder<P>::walkMethodList(uint64_t address, uint32_t className, char methodType, SCMethodChunk &chunk) const {
+    if (address == 0) {
+        return;
+    }
 
-            if (!(flags & RO_META)) {
-                // Process meta class.
-                // NOTE: This is needed for retrieving class (non-instance) methods.
-                klass = reinterpret_cast<objc_class_64 *>(memory + klass->isa - vmdiff_data);
-                goto process_class;
-            }
+    uint32_t baseMethods[2];
+    uint64_t offset;
+    if (!readStruct(address, &baseMethods, &offset)) {
+        return;
+    }
+    const uint32_t entsizeAndFlags = E::get32(baseMethods[0]);
+    const uint32_t count = E::get32(baseMethods[1]);
+    const BOOL isPreoptimized = ((entsizeAndFlags & METHOD_LIST_FIXED_UP) != 0);
+    const BOOL isRelative = ((entsizeAndFlags & METHOD_LIST_IS_RELATIVE) != 0);
+    uint32_t entsize = entsizeAndFlags & METHOD_LIST_ENTSIZE_MASK;
+    if (entsize == 0) {
+        entsize = isRelative ? sizeof(relative_method_t) : sizeof(method_t<P>);
+    }
+
+    // NOTE: Lists are normally located in __objc_const, and so are used in
+    //       place; others are read into a buffer.
+    const uint64_t entriesAddress = address + sizeof(baseMethods);
+    const uint64_t entriesOffset = offset + sizeof(baseMethods);
+    const uint64_t length = (uint64_t)count * entsize;
+    const uint8_t *entries = NULL;
+    std::vector<uint8_t> buffer;
+    const SCRegion *region = regionForOffset(regions_, entriesOffset);
+    if ((region != NULL) && (length <= (region->length - (entriesOffset - region->offset)))) {
+        entries = region->data + (entriesOffset - region->offset);
+    } else if ((length != 0) && (entriesOffset <= size_) && (length <= (size_ - entriesOffset))) {
+        buffer.resize(length);
+        if (!readData(entriesOffset, &buffer[0], length)) {
+            return;
         }
+        entries = &buffer[0];
+    } else {
+        return;
     }
 
-    return methods;
+    for (uint32_t j = 0; j < count; ++j) {
+        const uint64_t entryAddress = entriesAddress + (uint64_t)j * entsize;
+        const uint64_t entryOffset = entriesOffset + (uint64_t)j * entsize;
+        const uint8_t *entry = entries + (size_t)j * entsize;
+
+        uint64_t imp;
+        uint32_t selector;
+        if (isRelative) {
+            const relative_method_t *method = reinterpret_cast<const relative_method_t *>(entry);
+            const int32_t impOffset = E::get32(method->imp);
+            if (impOffset == 0) {
+                continue;
+            }
+            imp = entryAddress + offsetof(relative_method_t, imp) + (int64_t)impOffset;
+
+            // NOTE: Outside of the shared cache, the name is the offset of a
+            //       selector reference, not of the selector itself.
+            uint64_t selectorAddress;
+            if (!readPointer(entryAddress + offsetof(relative_method_t, name) + (int64_t)E::get32(method->name), &selectorAddress) ||
+                    !getNameReference(selectorAddress, chunk.strings, &selector)) {
+                continue;
+            }
+        } else {
+            const method_t<P> *method = reinterpret_cast<const method_t<P> *>(entry);
+            imp = resolvePointer(entryOffset + offsetof(method_t<P>, imp), method->imp);
+
+            const uint64_t name = resolvePointer(entryOffset + offsetof(method_t<P>, name), method->name);
+            if (isPreoptimized) {
+                selector = appendString(chunk.strings, reinterpret_cast<const char *>(static_cast<uintptr_t>(name)));
+            } else if (!getNameReference(name, chunk.strings, &selector)) {
+                continue;
+            }
+        }
+
+        SCMethodEntry methodEntry = {imp, className, selector, methodType};
+        chunk.entries.push_back(methodEntry);
+    }
 }
 
-NSArray *methodsForBinaryFile(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
-    NSArray *methods = nil;
+#pragma mark - SCMethodTable
+
+SCMethodTable *SCMethodTable::createWithInput(SCInput *input, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    SCMethodTable *table = NULL;
 
-    // Determine offset and size of the requested architecture in the file.
-    // NOTE: File may contain multiple architectures, or incorrect architecture.
+    // Determine offset and size of the requested architecture in the input.
+    // NOTE: Input may contain multiple architectures, or incorrect architecture.
     off_t offset;
     size_t size;
-    if (!offsetAndSizeOfBinaryInFile(filepath, cputype, cpusubtype, &offset, &size)) {
-        fprintf(stderr, "ERROR: Failed to determine offset and size of requested architecture in file: %s\n", filepath);
-        return nil;
+    if (!offsetAndSizeOfBinaryInInput(input, cputype, cpusubtype, &offset, &size)) {
+        fprintf(stderr, "ERROR: Failed to determine offset and size of requested architecture.\n");
+        return NULL;
     }
 
-    // Open the file.
-    int fd = open(filepath, O_RDONLY);
-    if (fd < 0) {
-        fprintf(stderr, "ERROR: Failed to open file: %s\n", filepath);
-        return nil;
+    // Extract the methods.
+    // NOTE: Only the Objective-C sections of the binary are mapped.
+    BOOL is32Bit = !(cputype & CPU_ARCH_ABI64);
+    if (is32Bit) {
+        table = SCMethodTableBuilder<Pointer32<LittleEndian> >(input, offset, size).build();
+    } else {
+        table = SCMethodTableBuilder<Pointer64<LittleEndian> >(input, offset, size).build();
     }
 
-    // Map the binary.
-    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, offset);
-    close(fd);
+    return table;
+}
 
-    // Extract the methods.
-    if (data != MAP_FAILED) {
-        // Determine if requested architecture is 32-bit or 64-bit.
-        uint8_t *memory = reinterpret_cast<uint8_t *>(data);
-        BOOL is32Bit = !(cputype & CPU_ARCH_ABI64);
-        if (is32Bit) {
-            methods = methodsForMappedMemory32(memory);
-        } else {
-            methods = methodsForMappedMemory64(memory);
+SCMethodTable::~SCMethodTable() {
+    if (addressTable_ != NULL) {
+        addressTable_->release();
+    }
+    if (input_ != NULL) {
+        for (std::vector<SCRegion>::const_iterator i = regions_.begin(); i != regions_.end(); ++i) {
+            input_->unmap(i->data, offset_ + i->offset, i->length);
         }
+        input_->release();
+    }
+}
 
-        if ([methods count] == 0) {
-            fprintf(stderr, "WARNING: Unable to extract methods or no methods exist in file: %s\n", filepath);
+// NOTE: The views of the name sections are included, as for some types of
+//       input (e.g. compressed archive entries) they are held in memory.
+size_t SCMethodTable::memoryUsage() const {
+    size_t regionsSize = 0;
+    for (std::vector<SCRegion>::const_iterator i = regions_.begin(); i != regions_.end(); ++i) {
+        regionsSize += i->length;
+    }
+    return sizeof(*this) + addressTable_->memoryUsage() +
+        (classNames_.capacity() * sizeof(uint32_t)) +
+        (selectors_.capacity() * sizeof(uint32_t)) +
+        types_.capacity() + strings_.capacity() + regionsSize;
+}
+
+bool SCMethodTable::compareRegions(const SCRegion &a, const SCRegion &b) {
+    return a.offset < b.offset;
+}
+
+const SCMethodTable::SCRegion *SCMethodTable::regionForOffset(const std::vector<SCRegion> &regions, uint64_t offset) {
+    SCRegion key = {offset, 0, NULL};
+    std::vector<SCRegion>::const_iterator i = std::upper_bound(regions.begin(), regions.end(), key, compareRegions);
+    if (i != regions.begin()) {
+        --i;
+        if ((offset - i->offset) < i->length) {
+            return &*i;
         }
+    }
+    return NULL;
+}
 
-        munmap(data, size);
-    } else {
-        fprintf(stderr, "ERROR: Failed to mmap file: %s\n", filepath);
+const char *SCMethodTable::stringForReference(uint32_t reference) const {
+    if (reference & kStringBufferFlag) {
+        return &strings_[reference & ~kStringBufferFlag];
     }
+    const SCRegion *region = regionForOffset(regions_, reference);
+    return (region != NULL) ? reinterpret_cast<const char *>(region->data + (reference - region->offset)) : "";
+}
 
-    return [methods sortedArrayUsingFunction:(NSInteger (*)(id, id, void *))reversedCompareMethodInfos context:NULL];
+NSString *SCMethodTable::nameAtIndex(size_t index) const {
+    return [NSString stringWithFormat:@"%c[%s %s]", types_[index], classNameAtIndex(index), selectorAtIndex(index)];
+}
+
+void SCMethodTable::getNameAtIndex(size_t index, std::string &name) const {
+    name.assign(1, types_[index]);
+    name += '[';
+    name += classNameAtIndex(index);
+    name += ' ';
+    name += selectorAtIndex(index);
+    name += ']';
+}
+
+NSArray *SCMethodTable::methodInfos() const {
+    const size_t count = this->count();
+    NSMutableArray *methods = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = count; i > 0; --i) {
+        SCMethodInfo *mi = [SCMethodInfo new];
+        [mi setName:nameAtIndex(i - 1)];
+        [mi setAddress:addressAtIndex(i - 1)];
+        [methods addObject:mi];
+        [mi release];
+    }
+    return methods;
+}
+
+#pragma mark - Functions
+
+NSArray *methodsForBinaryInMemory(const void *memory, size_t length, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    NSArray *methods = nil;
+
+    // NOTE: The buffer is parsed in place; nothing is copied.
+    SCInput *input = SCInputCreateWithMemory(memory, length);
+    SCMethodTable *table = SCMethodTable::createWithInput(input, cputype, cpusubtype);
+    if (table != NULL) {
+        methods = table->methodInfos();
+        table->release();
+    }
+    input->release();
+
+    return methods;
+}
+
+NSArray *methodsForBinaryFile(const char *filepath, cpu_type_t cputype, cpu_subtype_t cpusubtype) {
+    SCInput *input = SCInputCreateWithPath(filepath);
+    if (input == NULL) {
+        return nil;
+    }
+
+    NSArray *methods = nil;
+    SCMethodTable *table = SCMethodTable::createWithInput(input, cputype, cpusubtype);
+    if (table != NULL) {
+        methods = table->methodInfos();
+        table->release();
+    }
+    if ([methods count] == 0) {
+        fprintf(stderr, "WARNING: Unable to extract methods or no methods exist in file: %s\n", filepath);
+    }
+
+    input->release();
+
+    return methods;
 }
 
 /* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
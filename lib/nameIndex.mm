@@ -0,0 +1,284 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "nameIndex.h"
+
+#import <Foundation/Foundation.h>
+#import "SCSymbolInfo.h"
+
+#include <string.h>
+#include <algorithm>
+#include "demangle.h"
+#include "symbols.h"
+
+// NOTE: FNV-1a.
+static uint64_t hashForName(const char *name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *c = (const unsigned char *)name; *c != '\0'; ++c) {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// NOTE: Only names that demangle() would change are demangled, as creating a
+//       string for every name would dominate the time taken to build an index.
+static BOOL isMangledName(const char *name) {
+    return (strncmp(name, "__Z", 3) == 0) || (strstr(name, "_logos") != NULL);
+}
+
+static size_t slotCountForNameCount(size_t count) {
+    size_t slotCount = 16;
+    while (slotCount < (2 * count)) {
+        slotCount *= 2;
+    }
+    return slotCount;
+}
+
+typedef struct _SCNameIndexBuildRecord {
+    uint32_t name;
+    uint64_t address;
+    uint64_t size;
+} SCNameIndexBuildRecord;
+
+static bool compareBuildRecords(const SCNameIndexBuildRecord &a, const SCNameIndexBuildRecord &b) {
+    if (a.name != b.name) {
+        return a.name < b.name;
+    }
+    return a.address < b.address;
+}
+
+class SCNameIndexBuilder {
+    public:
+        SCNameIndexBuilder(SCNameIndex *index) : index_(index), slots_(slotCountForNameCount(0), 0) {}
+
+        void add(const char *name, uint64_t address, uint64_t size) {
+            SCNameIndexBuildRecord record = {intern(name), address, size};
+            records_.push_back(record);
+        }
+
+        // NOTE: Numbers the names in sorted order, and fills in the index.
+        void finish() {
+            const size_t count = nameOffsets_.size();
+
+            std::vector<uint32_t> order(count);
+            for (size_t i = 0; i < count; ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), NameComparator(*this));
+
+            std::vector<uint32_t> ranks(count);
+            index_->nameOffsets_.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                ranks[order[i]] = i;
+                index_->nameOffsets_[i] = nameOffsets_[order[i]];
+            }
+            index_->strings_.swap(strings_);
+
+            for (std::vector<SCNameIndexBuildRecord>::iterator i = records_.begin(); i != records_.end(); ++i) {
+                i->name = ranks[i->name];
+            }
+            std::sort(records_.begin(), records_.end(), compareBuildRecords);
+            records_.erase(std::unique(records_.begin(), records_.end(), isSameRecord), records_.end());
+
+            index_->records_.resize(records_.size());
+            index_->recordStarts_.assign(count + 1, 0);
+            for (size_t i = 0; i < records_.size(); ++i) {
+                SCNameIndex::SCNameIndexRecord &record = index_->records_[i];
+                record.address = records_[i].address;
+                record.size = records_[i].size;
+                ++index_->recordStarts_[records_[i].name + 1];
+            }
+            for (size_t i = 0; i < count; ++i) {
+                index_->recordStarts_[i + 1] += index_->recordStarts_[i];
+            }
+
+            for (std::vector<uint32_t>::iterator i = slots_.begin(); i != slots_.end(); ++i) {
+                if (*i != 0) {
+                    *i = ranks[*i - 1] + 1;
+                }
+            }
+            index_->slots_.swap(slots_);
+        }
+
+    private:
+        struct NameComparator {
+            NameComparator(const SCNameIndexBuilder &builder) : builder_(builder) {}
+            bool operator()(uint32_t a, uint32_t b) const {
+                return strcmp(builder_.nameAtIndex(a), builder_.nameAtIndex(b)) < 0;
+            }
+            const SCNameIndexBuilder &builder_;
+        };
+
+        static bool isSameRecord(const SCNameIndexBuildRecord &a, const SCNameIndexBuildRecord &b) {
+            return (a.name == b.name) && (a.address == b.address);
+        }
+
+        const char *nameAtIndex(uint32_t index) const { return &strings_[nameOffsets_[index]]; }
+
+        uint32_t intern(const char *name) {
+            const size_t mask = slots_.size() - 1;
+            size_t slot = hashForName(name) & mask;
+            while (slots_[slot] != 0) {
+                const uint32_t index = slots_[slot] - 1;
+                if (strcmp(nameAtIndex(index), name) == 0) {
+                    return index;
+                }
+                slot = (slot + 1) & mask;
+            }
+
+            const uint32_t index = nameOffsets_.size();
+            nameOffsets_.push_back(strings_.size());
+            strings_.insert(strings_.end(), name, name + strlen(name) + 1);
+            slots_[slot] = index + 1;
+
+            if (slots_.size() < (2 * nameOffsets_.size())) {
+                rehash(2 * slots_.size());
+            }
+            return index;
+        }
+
+        void rehash(size_t slotCount) {
+            std::vector<uint32_t> slots(slotCount, 0);
+            const size_t mask = slotCount - 1;
+            for (size_t i = 0; i < nameOffsets_.size(); ++i) {
+                size_t slot = hashForName(nameAtIndex(i)) & mask;
+                while (slots[slot] != 0) {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = i + 1;
+            }
+            slots_.swap(slots);
+        }
+
+        SCNameIndex *index_;
+        std::vector<char> strings_;
+        std::vector<uint32_t> nameOffsets_;
+        std::vector<uint32_t> slots_;
+        std::vector<SCNameIndexBuildRecord> records_;
+};
+
+#pragma mark - Creation & Destruction
+
+SCNameIndex *SCNameIndex::createWithCursor(SCSymbolCursor *cursor) {
+    SCNameIndex *index = new SCNameIndex();
+    SCNameIndexBuilder builder(index);
+
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    SCSymbolRecord record;
+    for (unsigned recordCount = 1; cursor->next(&record); ++recordCount) {
+        if ((record.name == NULL) || (record.name[0] == '\0')) {
+            continue;
+        }
+
+        builder.add(record.name, record.address, record.size);
+        if (isMangledName(record.name)) {
+            NSString *mangled = [[NSString alloc] initWithUTF8String:record.name];
+            if (mangled != nil) {
+                NSString *demangled = demangle(mangled);
+                if ((demangled != nil) && ![demangled isEqualToString:mangled]) {
+                    builder.add([demangled UTF8String], record.address, record.size);
+                }
+                [mangled release];
+            }
+        }
+
+        // NOTE: Drain periodically so that memory use does not grow with the
+        //       number of records.
+        if ((recordCount % 1024) == 0) {
+            [pool drain];
+            pool = [[NSAutoreleasePool alloc] init];
+        }
+    }
+    [pool drain];
+
+    builder.finish();
+    return index;
+}
+
+#pragma mark - Public Methods
+
+size_t SCNameIndex::findName(const char *name, std::vector<SCNameIndexEntry> &entries) const {
+    if (slots_.empty()) {
+        return 0;
+    }
+
+    const size_t mask = slots_.size() - 1;
+    size_t slot = hashForName(name) & mask;
+    while (slots_[slot] != 0) {
+        const uint32_t index = slots_[slot] - 1;
+        if (strcmp(nameAtIndex(index), name) == 0) {
+            const size_t count = entries.size();
+            appendEntries(index, entries, records_.size());
+            return entries.size() - count;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+size_t SCNameIndex::findPrefix(const char *prefix, std::vector<SCNameIndexEntry> &entries, size_t limit) const {
+    const size_t length = strlen(prefix);
+    const size_t count = entries.size();
+
+    // Find the first name that is not less than the prefix.
+    size_t low = 0;
+    size_t high = nameOffsets_.size();
+    while (low < high) {
+        const size_t middle = low + ((high - low) / 2);
+        if (strcmp(nameAtIndex(middle), prefix) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (size_t i = low; (i < nameOffsets_.size()) && ((entries.size() - count) < limit); ++i) {
+        if (strncmp(nameAtIndex(i), prefix, length) != 0) {
+            break;
+        }
+        appendEntries(i, entries, limit - (entries.size() - count));
+    }
+    return entries.size() - count;
+}
+
+size_t SCNameIndex::memoryUsage() const {
+    return sizeof(*this) +
+        strings_.capacity() +
+        (nameOffsets_.capacity() * sizeof(uint32_t)) +
+        (recordStarts_.capacity() * sizeof(uint32_t)) +
+        (records_.capacity() * sizeof(SCNameIndexRecord)) +
+        (slots_.capacity() * sizeof(uint32_t));
+}
+
+#pragma mark - Private Methods
+
+void SCNameIndex::appendEntries(size_t index, std::vector<SCNameIndexEntry> &entries, size_t limit) const {
+    const char *name = nameAtIndex(index);
+    const size_t end = std::min<size_t>(recordStarts_[index + 1], recordStarts_[index] + limit);
+    for (size_t i = recordStarts_[index]; i < end; ++i) {
+        SCNameIndexEntry entry = {name, records_[i].address, records_[i].size};
+        entries.push_back(entry);
+    }
+}
+
+#pragma mark - Functions
+
+NSArray *symbolInfosForNameIndexEntries(const std::vector<SCNameIndexEntry> &entries, int64_t slide) {
+    NSMutableArray *symbolInfos = [NSMutableArray arrayWithCapacity:entries.size()];
+    for (std::vector<SCNameIndexEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+        SCSymbolResult result = {{(i->address - slide), i->size}, 0, i->name, NULL, 0};
+        SCSymbolInfo *symbolInfo = [[SCSymbolInfo alloc] initWithResult:&result];
+        [symbolInfos addObject:symbolInfo];
+        [symbolInfo release];
+    }
+    return symbolInfos;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,72 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "prefetch.h"
+
+#import "SCBinaryInfo.h"
+#import "SCBinaryInfo-Private.h"
+
+#include <algorithm>
+
+#pragma mark - Creation & Destruction
+
+SCBinaryPrefetcher::SCBinaryPrefetcher() : isSorted_(YES) {
+    group_ = dispatch_group_create();
+}
+
+// NOTE: Does not wait for pending warm-up; GCD keeps the group alive until the
+//       blocks that were added to it have finished, and each block retains
+//       its own binary info object.
+SCBinaryPrefetcher::~SCBinaryPrefetcher() {
+    dispatch_release(group_);
+}
+
+#pragma mark - Public Methods
+
+void SCBinaryPrefetcher::addFrame(uint64_t address) {
+    if (!addresses_.empty() && (address < addresses_.back())) {
+        isSorted_ = NO;
+    }
+    addresses_.push_back(address);
+}
+
+// NOTE: Frames usually all come before the images (e.g. in text logs), and so
+//       are sorted at most once.
+size_t SCBinaryPrefetcher::frameCountInRange(uint64_t address, uint64_t endAddress) {
+    if (!isSorted_) {
+        std::sort(addresses_.begin(), addresses_.end());
+        isSorted_ = YES;
+    }
+    std::vector<uint64_t>::const_iterator start = std::lower_bound(addresses_.begin(), addresses_.end(), address);
+    std::vector<uint64_t>::const_iterator end = std::upper_bound(start, addresses_.end(), endAddress);
+    return end - start;
+}
+
+void SCBinaryPrefetcher::prefetch(SCBinaryInfo *binaryInfo, size_t frameCount) {
+    if (binaryInfo == nil) {
+        return;
+    }
+
+    [binaryInfo retain];
+    dispatch_group_async(group_, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        [binaryInfo owner];
+        if (frameCount > SYMBOL_ADDRESS_SCAN_LIMIT) {
+            [binaryInfo symbolAddressTable];
+        }
+        [binaryInfo release];
+        [pool drain];
+    });
+}
+
+void SCBinaryPrefetcher::wait() {
+    dispatch_group_wait(group_, DISPATCH_TIME_FOREVER);
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
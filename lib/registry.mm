@@ -0,0 +1,422 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "registry.h"
+
+#import <Foundation/Foundation.h>
+
+#include <ctype.h>
+#include "addressTable.h"
+#include "methods.h"
+#include "nameIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+// NOTE: The default capacity is suited to a few dozen large binaries.
+static const size_t kDefaultCapacity = 256 * 1024 * 1024;
+
+// NOTE: Estimated cost of each (boxed) entry in a symbol addresses array.
+static const size_t kSymbolAddressCost = 32;
+
+// NOTE: Estimated overhead of each interned string (the node of the set).
+static const size_t kStringCost = 64;
+
+// NOTE: The cost of interned strings is added to the registry (which takes its
+//       write lock) in batches of at least this size, or along with the next
+//       value that is set.
+static const size_t kPendingCostLimit = 64 * 1024;
+
+// XXX: The memory used by a CoreSymbolication symbolicator cannot be
+//      determined; this is a rough estimate for a typical binary.
+static const size_t kSymbolicatorCost = 4 * 1024 * 1024;
+
+#pragma mark - SCBinaryState
+
+SCBinaryState::SCBinaryState(SCBinaryRegistry *registry) :
+    refCount_(1), registry_(registry), identifier_(0), cost_(0), pendingCost_(0), symbolAddressLookupCount_(0),
+    methodTable_(NULL), nameIndex_(NULL), symbolAddresses_(nil), symbolAddressTable_(NULL), symbolicator_(),
+    hasMethodTable_(NO), hasNameIndex_(NO), hasSymbolAddresses_(NO), hasSymbolAddressTable_(NO), hasSymbolicator_(NO),
+    isRegistered_(NO), lastUse_(0) {
+    pthread_mutex_init(&mutex_, NULL);
+}
+
+SCBinaryState::~SCBinaryState() {
+    if (methodTable_ != NULL) {
+        methodTable_->release();
+    }
+    if (nameIndex_ != NULL) {
+        nameIndex_->release();
+    }
+    [symbolAddresses_ release];
+    if (symbolAddressTable_ != NULL) {
+        symbolAddressTable_->release();
+    }
+    if (!CSIsNull(symbolicator_)) {
+        CSRelease(symbolicator_);
+    }
+    pthread_mutex_destroy(&mutex_);
+}
+
+BOOL SCBinaryState::getMethodTable(SCMethodTable **methodTable) {
+    pthread_mutex_lock(&mutex_);
+    const BOOL hasValue = hasMethodTable_;
+    if (hasValue) {
+        *methodTable = methodTable_;
+        if (methodTable_ != NULL) {
+            methodTable_->retain();
+        }
+    }
+    pthread_mutex_unlock(&mutex_);
+    return hasValue;
+}
+
+BOOL SCBinaryState::getNameIndex(SCNameIndex **nameIndex) {
+    pthread_mutex_lock(&mutex_);
+    const BOOL hasValue = hasNameIndex_;
+    if (hasValue) {
+        *nameIndex = nameIndex_;
+        if (nameIndex_ != NULL) {
+            nameIndex_->retain();
+        }
+    }
+    pthread_mutex_unlock(&mutex_);
+    return hasValue;
+}
+
+BOOL SCBinaryState::getSymbolAddresses(NSArray **symbolAddresses) {
+    pthread_mutex_lock(&mutex_);
+    const BOOL hasValue = hasSymbolAddresses_;
+    if (hasValue) {
+        *symbolAddresses = [symbolAddresses_ retain];
+    }
+    pthread_mutex_unlock(&mutex_);
+    return hasValue;
+}
+
+BOOL SCBinaryState::getSymbolAddressTable(SCAddressTable **symbolAddressTable) {
+    pthread_mutex_lock(&mutex_);
+    const BOOL hasValue = hasSymbolAddressTable_;
+    if (hasValue) {
+        *symbolAddressTable = symbolAddressTable_;
+        if (symbolAddressTable_ != NULL) {
+            symbolAddressTable_->retain();
+        }
+    }
+    pthread_mutex_unlock(&mutex_);
+    return hasValue;
+}
+
+BOOL SCBinaryState::getSymbolicator(CSSymbolicatorRef *symbolicator) {
+    pthread_mutex_lock(&mutex_);
+    const BOOL hasValue = hasSymbolicator_;
+    if (hasValue) {
+        *symbolicator = CSIsNull(symbolicator_) ? symbolicator_ : CSRetain(symbolicator_);
+    }
+    pthread_mutex_unlock(&mutex_);
+    return hasValue;
+}
+
+SCMethodTable *SCBinaryState::setMethodTable(SCMethodTable *methodTable) {
+    size_t cost = 0;
+
+    pthread_mutex_lock(&mutex_);
+    if (!hasMethodTable_) {
+        hasMethodTable_ = YES;
+        methodTable_ = methodTable;
+        if (methodTable_ != NULL) {
+            cost = methodTable_->memoryUsage();
+        }
+    } else if (methodTable != NULL) {
+        methodTable->release();
+    }
+    SCMethodTable *result = methodTable_;
+    if (result != NULL) {
+        result->retain();
+    }
+    pthread_mutex_unlock(&mutex_);
+
+    addCost(cost);
+    return result;
+}
+
+SCNameIndex *SCBinaryState::setNameIndex(SCNameIndex *nameIndex) {
+    size_t cost = 0;
+
+    pthread_mutex_lock(&mutex_);
+    if (!hasNameIndex_) {
+        hasNameIndex_ = YES;
+        nameIndex_ = nameIndex;
+        if (nameIndex_ != NULL) {
+            cost = nameIndex_->memoryUsage();
+        }
+    } else if (nameIndex != NULL) {
+        nameIndex->release();
+    }
+    SCNameIndex *result = nameIndex_;
+    if (result != NULL) {
+        result->retain();
+    }
+    pthread_mutex_unlock(&mutex_);
+
+    addCost(cost);
+    return result;
+}
+
+NSArray *SCBinaryState::setSymbolAddresses(NSArray *symbolAddresses) {
+    size_t cost = 0;
+
+    pthread_mutex_lock(&mutex_);
+    if (!hasSymbolAddresses_) {
+        hasSymbolAddresses_ = YES;
+        symbolAddresses_ = symbolAddresses;
+        cost = [symbolAddresses_ count] * kSymbolAddressCost;
+    } else {
+        [symbolAddresses release];
+    }
+    NSArray *result = [symbolAddresses_ retain];
+    pthread_mutex_unlock(&mutex_);
+
+    addCost(cost);
+    return result;
+}
+
+SCAddressTable *SCBinaryState::setSymbolAddressTable(SCAddressTable *symbolAddressTable) {
+    size_t cost = 0;
+
+    pthread_mutex_lock(&mutex_);
+    if (!hasSymbolAddressTable_) {
+        hasSymbolAddressTable_ = YES;
+        symbolAddressTable_ = symbolAddressTable;
+        if (symbolAddressTable_ != NULL) {
+            cost = symbolAddressTable_->memoryUsage();
+        }
+    } else if (symbolAddressTable != NULL) {
+        symbolAddressTable->release();
+    }
+    SCAddressTable *result = symbolAddressTable_;
+    if (result != NULL) {
+        result->retain();
+    }
+    pthread_mutex_unlock(&mutex_);
+
+    addCost(cost);
+    return result;
+}
+
+CSSymbolicatorRef SCBinaryState::setSymbolicator(CSSymbolicatorRef symbolicator) {
+    size_t cost = 0;
+
+    pthread_mutex_lock(&mutex_);
+    if (!hasSymbolicator_) {
+        hasSymbolicator_ = YES;
+        symbolicator_ = symbolicator;
+        if (!CSIsNull(symbolicator_)) {
+            cost = kSymbolicatorCost;
+        }
+    } else if (!CSIsNull(symbolicator)) {
+        CSRelease(symbolicator);
+    }
+    CSSymbolicatorRef result = CSIsNull(symbolicator_) ? symbolicator_ : CSRetain(symbolicator_);
+    pthread_mutex_unlock(&mutex_);
+
+    addCost(cost);
+    return result;
+}
+
+const char *SCBinaryState::internString(const char *string) {
+    if (string == NULL) {
+        return NULL;
+    }
+
+    size_t cost = 0;
+
+    // NOTE: Elements of a set are never moved, and so the pointer remains
+    //       valid as the set grows.
+    pthread_mutex_lock(&mutex_);
+    std::pair<std::set<std::string>::iterator, bool> result = strings_.insert(string);
+    if (result.second) {
+        cost = result.first->size() + kStringCost;
+    }
+    const char *internedString = result.first->c_str();
+    pthread_mutex_unlock(&mutex_);
+
+    if ((cost != 0) && (__sync_add_and_fetch(&pendingCost_, cost) >= kPendingCostLimit)) {
+        addCost(0);
+    }
+    return internedString;
+}
+
+// NOTE: Any pending cost of interned strings is added as well.
+void SCBinaryState::addCost(size_t cost) {
+    cost += __sync_fetch_and_and(&pendingCost_, 0);
+    if (cost != 0) {
+        registry_->addCost(this, cost);
+    }
+}
+
+#pragma mark - SCBinaryRegistry
+
+// NOTE: The UUID is reduced to lowercase hex digits, so that differently
+//       formatted strings for the same UUID produce the same key.
+static BOOL keyForBinary(const char *uuid, const char *architecture, std::string &key) {
+    key.clear();
+    for (const char *c = uuid; *c != '\0'; ++c) {
+        if (isxdigit(*c)) {
+            key.push_back(tolower(*c));
+        } else if ((*c != '-') && (*c != '<') && (*c != '>') && (*c != ' ')) {
+            return NO;
+        }
+    }
+    if (key.size() != 32) {
+        return NO;
+    }
+    key.push_back('/');
+    key.append(architecture);
+    return YES;
+}
+
+SCBinaryRegistry *SCBinaryRegistry::sharedInstance() {
+    static dispatch_once_t once;
+    static SCBinaryRegistry *instance;
+    dispatch_once(&once, ^{
+        instance = new SCBinaryRegistry(kDefaultCapacity);
+    });
+    return instance;
+}
+
+SCBinaryRegistry::SCBinaryRegistry(size_t capacity) : capacity_(capacity), cost_(0), clock_(0), nextIdentifier_(1) {
+    pthread_rwlock_init(&lock_, NULL);
+}
+
+SCBinaryRegistry::~SCBinaryRegistry() {
+    removeAll();
+    pthread_rwlock_destroy(&lock_);
+}
+
+SCBinaryState *SCBinaryRegistry::stateFor(const char *uuid, const char *architecture) {
+    if ((uuid == NULL) || (architecture == NULL)) {
+        return NULL;
+    }
+
+    std::string key;
+    if (!keyForBinary(uuid, architecture, key)) {
+        return NULL;
+    }
+
+    // NOTE: The common case, in which the state already exists, only requires
+    //       the read lock. The time of use is updated atomically.
+    SCBinaryState *state = NULL;
+    pthread_rwlock_rdlock(&lock_);
+    SCBinaryStateMap::iterator i = states_.find(key);
+    if (i != states_.end()) {
+        state = i->second;
+        state->retain();
+        state->lastUse_ = __sync_add_and_fetch(&clock_, 1);
+    }
+    pthread_rwlock_unlock(&lock_);
+
+    if (state == NULL) {
+        pthread_rwlock_wrlock(&lock_);
+        // NOTE: Another thread may have added the state in the meantime.
+        i = states_.find(key);
+        if (i != states_.end()) {
+            state = i->second;
+        } else {
+            state = new SCBinaryState(this);
+            state->identifier_ = nextIdentifier_++;
+            state->isRegistered_ = YES;
+            states_.insert(std::make_pair(key, state));
+        }
+        state->retain();
+        state->lastUse_ = __sync_add_and_fetch(&clock_, 1);
+        pthread_rwlock_unlock(&lock_);
+    }
+
+    return state;
+}
+
+SCBinaryState *SCBinaryRegistry::createPrivateState() {
+    SCBinaryState *state = new SCBinaryState(this);
+    pthread_rwlock_wrlock(&lock_);
+    state->identifier_ = nextIdentifier_++;
+    pthread_rwlock_unlock(&lock_);
+    return state;
+}
+
+void SCBinaryRegistry::setCapacity(size_t capacity) {
+    pthread_rwlock_wrlock(&lock_);
+    capacity_ = capacity;
+    evictIfNeeded();
+    pthread_rwlock_unlock(&lock_);
+}
+
+size_t SCBinaryRegistry::count() {
+    pthread_rwlock_rdlock(&lock_);
+    const size_t count = states_.size();
+    pthread_rwlock_unlock(&lock_);
+    return count;
+}
+
+void SCBinaryRegistry::removeAll() {
+    pthread_rwlock_wrlock(&lock_);
+    for (SCBinaryStateMap::iterator i = states_.begin(); i != states_.end(); ++i) {
+        i->second->isRegistered_ = NO;
+        i->second->release();
+    }
+    states_.clear();
+    cost_ = 0;
+    pthread_rwlock_unlock(&lock_);
+}
+
+#pragma mark - Private Methods
+
+void SCBinaryRegistry::addCost(SCBinaryState *state, size_t cost) {
+    pthread_rwlock_wrlock(&lock_);
+    // NOTE: The state may have been evicted already, in which case its cost
+    //       no longer counts towards the total.
+    if (state->isRegistered_) {
+        state->cost_ += cost;
+        cost_ += cost;
+        evictIfNeeded();
+    }
+    pthread_rwlock_unlock(&lock_);
+}
+
+static bool compareLastUse(const std::pair<uint64_t, std::string> &a, const std::pair<uint64_t, std::string> &b) {
+    return a.first < b.first;
+}
+
+// NOTE: Must be called with the write lock held.
+void SCBinaryRegistry::evictIfNeeded() {
+    if (cost_ <= capacity_) {
+        return;
+    }
+
+    // Order states from least to most recently used.
+    std::vector<std::pair<uint64_t, std::string> > uses;
+    uses.reserve(states_.size());
+    for (SCBinaryStateMap::iterator i = states_.begin(); i != states_.end(); ++i) {
+        uses.push_back(std::make_pair(i->second->lastUse_, i->first));
+    }
+    std::sort(uses.begin(), uses.end(), compareLastUse);
+
+    // NOTE: The most recently used state is always kept, even if it alone
+    //       exceeds the capacity, as it is likely still being filled in.
+    for (size_t j = 0; (cost_ > capacity_) && ((j + 1) < uses.size()); ++j) {
+        SCBinaryStateMap::iterator i = states_.find(uses[j].second);
+        SCBinaryState *state = i->second;
+        cost_ -= state->cost_;
+        state->isRegistered_ = NO;
+        states_.erase(i);
+        state->release();
+    }
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,120 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "resultCache.h"
+
+// NOTE: The number of shards should exceed the number of threads that are
+//       expected to symbolicate at the same time.
+#define NUM_SHARDS 16
+#define SLOTS_PER_SET 4
+
+// NOTE: Mixes the bits of the key (from MurmurHash3's 64-bit finalizer).
+static inline uint64_t hashForKey(uint64_t binary, uint64_t address) {
+    uint64_t h = address ^ (binary * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+#pragma mark - Creation & Destruction
+
+SCResultCache *SCResultCache::create(size_t capacity) {
+    const size_t perShard = (capacity + NUM_SHARDS - 1) / NUM_SHARDS;
+    size_t setsPerShard = (perShard + SLOTS_PER_SET - 1) / SLOTS_PER_SET;
+    if (setsPerShard == 0) {
+        setsPerShard = 1;
+    }
+    return new SCResultCache(setsPerShard);
+}
+
+SCResultCache::SCResultCache(size_t setsPerShard) :
+    refCount_(1), setsPerShard_(setsPerShard), hits_(0), misses_(0) {
+    shards_ = new SCShard[NUM_SHARDS];
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+        SCShard &shard = shards_[i];
+        pthread_mutex_init(&shard.mutex, NULL);
+        shard.results = new SCResult[setsPerShard_ * SLOTS_PER_SET]();
+        shard.clock = 0;
+    }
+}
+
+SCResultCache::~SCResultCache() {
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+        pthread_mutex_destroy(&shards_[i].mutex);
+        delete[] shards_[i].results;
+    }
+    delete[] shards_;
+}
+
+#pragma mark - Public Methods
+
+BOOL SCResultCache::lookup(uint64_t binary, uint64_t address, SCSymbolResult *result) {
+    const uint64_t hash = hashForKey(binary, address);
+    SCShard &shard = shards_[hash % NUM_SHARDS];
+    SCResult *set = &shard.results[((hash / NUM_SHARDS) % setsPerShard_) * SLOTS_PER_SET];
+
+    BOOL isHit = NO;
+    pthread_mutex_lock(&shard.mutex);
+    for (unsigned i = 0; i < SLOTS_PER_SET; ++i) {
+        SCResult &slot = set[i];
+        if (slot.isValid && (slot.binary == binary) && (slot.address == address)) {
+            slot.lastUse = ++shard.clock;
+            *result = slot.result;
+            isHit = YES;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&shard.mutex);
+
+    __sync_add_and_fetch(isHit ? &hits_ : &misses_, 1);
+    return isHit;
+}
+
+void SCResultCache::insert(uint64_t binary, uint64_t address, const SCSymbolResult &result) {
+    const uint64_t hash = hashForKey(binary, address);
+    SCShard &shard = shards_[hash % NUM_SHARDS];
+    SCResult *set = &shard.results[((hash / NUM_SHARDS) % setsPerShard_) * SLOTS_PER_SET];
+
+    // Choose the slot to replace.
+    // NOTE: Another thread may have inserted the same key in the meantime.
+    pthread_mutex_lock(&shard.mutex);
+    SCResult *target = &set[0];
+    for (unsigned i = 0; i < SLOTS_PER_SET; ++i) {
+        SCResult &slot = set[i];
+        if (!slot.isValid || ((slot.binary == binary) && (slot.address == address))) {
+            target = &slot;
+            break;
+        }
+        if (slot.lastUse < target->lastUse) {
+            target = &slot;
+        }
+    }
+    target->binary = binary;
+    target->address = address;
+    target->lastUse = ++shard.clock;
+    target->isValid = YES;
+    target->result = result;
+    pthread_mutex_unlock(&shard.mutex);
+}
+
+void SCResultCache::removeAll() {
+    for (unsigned i = 0; i < NUM_SHARDS; ++i) {
+        SCShard &shard = shards_[i];
+        pthread_mutex_lock(&shard.mutex);
+        for (size_t j = 0; j < (setsPerShard_ * SLOTS_PER_SET); ++j) {
+            shard.results[j].isValid = NO;
+        }
+        pthread_mutex_unlock(&shard.mutex);
+    }
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
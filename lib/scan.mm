@@ -0,0 +1,216 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "scan.h"
+
+#include <mach-o/nlist.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCAN_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#endif
+
+// NOTE: All supported targets are little-endian; the vector code reads the
+//       value of an entry as 32-bit words, low word first.
+
+// NOTE: Offset of n_value; the same for nlist and nlist_64.
+#define NLIST_VALUE_OFFSET 8
+
+static uint32_t scanNlists(const uint8_t *nlists, uint32_t start, uint32_t count, BOOL is64Bit, uint64_t value) {
+    for (uint32_t i = start; i < count; ++i) {
+        if (is64Bit) {
+            const struct nlist_64 *n = reinterpret_cast<const struct nlist_64 *>(nlists) + i;
+            if (n->n_value == value) {
+                return i;
+            }
+        } else {
+            const struct nlist *n = reinterpret_cast<const struct nlist *>(nlists) + i;
+            if (n->n_value == value) {
+                return i;
+            }
+        }
+    }
+    return count;
+}
+
+#pragma mark - Symbol Tables
+
+#if SCAN_NEON
+
+// NOTE: Returns non-zero if any lane is set.
+static inline uint32_t anyLane(uint32x4_t mask) {
+    const uint32x2_t half = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+    return vget_lane_u32(half, 0) | vget_lane_u32(half, 1);
+}
+
+// NOTE: The structure loads de-interleave the words of four entries at a
+//       time, so that each vector holds one field of each entry.
+uint32_t indexOfNlistWithValue(const uint8_t *nlists, uint32_t count, BOOL is64Bit, uint64_t value) {
+    uint32_t i = 0;
+    if (is64Bit) {
+        const uint32x4_t low = vdupq_n_u32((uint32_t)value);
+        const uint32x4_t high = vdupq_n_u32((uint32_t)(value >> 32));
+        for (; (i + 4) <= count; i += 4) {
+            const uint32x4x4_t words = vld4q_u32(reinterpret_cast<const uint32_t *>(nlists + (i * sizeof(struct nlist_64))));
+            if (anyLane(vandq_u32(vceqq_u32(words.val[2], low), vceqq_u32(words.val[3], high)))) {
+                return scanNlists(nlists, i, i + 4, is64Bit, value);
+            }
+        }
+    } else {
+        if ((value >> 32) != 0) {
+            return count;
+        }
+        const uint32x4_t target = vdupq_n_u32((uint32_t)value);
+        for (; (i + 4) <= count; i += 4) {
+            const uint32x4x3_t words = vld3q_u32(reinterpret_cast<const uint32_t *>(nlists + (i * sizeof(struct nlist))));
+            if (anyLane(vceqq_u32(words.val[2], target))) {
+                return scanNlists(nlists, i, i + 4, is64Bit, value);
+            }
+        }
+    }
+    return scanNlists(nlists, i, count, is64Bit, value);
+}
+
+#elif SCAN_SSE2
+
+uint32_t indexOfNlistWithValue(const uint8_t *nlists, uint32_t count, BOOL is64Bit, uint64_t value) {
+    uint32_t i = 0;
+    if (is64Bit) {
+        // NOTE: The values of two entries are gathered into one vector; SSE2
+        //       has no 64-bit comparison, so both halves must match.
+        const __m128i target = _mm_set_epi32((int)(value >> 32), (int)value, (int)(value >> 32), (int)value);
+        for (; (i + 2) <= count; i += 2) {
+            const __m128i *p = reinterpret_cast<const __m128i *>(nlists + (i * sizeof(struct nlist_64)));
+            const __m128i values = _mm_unpackhi_epi64(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+            const int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(values, target));
+            if ((mask & 0x00ff) == 0x00ff) {
+                return i;
+            }
+            if ((mask & 0xff00) == 0xff00) {
+                return i + 1;
+            }
+        }
+    } else {
+        if ((value >> 32) != 0) {
+            return count;
+        }
+        // NOTE: Four entries span three vectors; their values are words 2, 5,
+        //       8 and 11.
+        const __m128i target = _mm_set1_epi32((int)value);
+        for (; (i + 4) <= count; i += 4) {
+            const __m128i *p = reinterpret_cast<const __m128i *>(nlists + (i * sizeof(struct nlist)));
+            const int mask0 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(p), target)));
+            const int mask1 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(p + 1), target)));
+            const int mask2 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(p + 2), target)));
+            if (((mask0 & 0x4) | (mask1 & 0x2) | (mask2 & 0x9)) != 0) {
+                return scanNlists(nlists, i, i + 4, is64Bit, value);
+            }
+        }
+    }
+    return scanNlists(nlists, i, count, is64Bit, value);
+}
+
+#else
+
+uint32_t indexOfNlistWithValue(const uint8_t *nlists, uint32_t count, BOOL is64Bit, uint64_t value) {
+    return scanNlists(nlists, 0, count, is64Bit, value);
+}
+
+#endif
+
+#pragma mark - Function Starts
+
+// NOTE: If the next sixteen bytes are each a complete, non-zero delta (i.e.
+//       less than 0x80), returns YES and their sum. Most deltas are small
+//       enough for this to hold.
+#if SCAN_NEON
+
+static inline BOOL sumOfSmallDeltas(const uint8_t *p, uint64_t *sum) {
+    const uint8x16_t bytes = vld1q_u8(p);
+    const uint8x16_t invalid = vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(0)), vtstq_u8(bytes, vdupq_n_u8(0x80)));
+    const uint64x2_t invalid64 = vreinterpretq_u64_u8(invalid);
+    if ((vgetq_lane_u64(invalid64, 0) | vgetq_lane_u64(invalid64, 1)) != 0) {
+        return NO;
+    }
+    const uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(bytes)));
+    *sum = vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1);
+    return YES;
+}
+
+#elif SCAN_SSE2
+
+static inline BOOL sumOfSmallDeltas(const uint8_t *p, uint64_t *sum) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i zero = _mm_setzero_si128();
+    if ((_mm_movemask_epi8(bytes) | _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero))) != 0) {
+        return NO;
+    }
+    const __m128i sums = _mm_sad_epu8(bytes, zero);
+    *sum = (uint64_t)_mm_cvtsi128_si32(sums) + (uint64_t)_mm_extract_epi16(sums, 4);
+    return YES;
+}
+
+#endif
+
+BOOL functionStartForAddress(const uint8_t *data, size_t length, uint64_t baseAddress, BOOL isThumb, uint64_t address, uint64_t *start) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + length;
+    const uint64_t mask = isThumb ? ~1ULL : ~0ULL;
+    uint64_t current = baseAddress;
+    BOOL isFound = NO;
+
+    while (p < end) {
+#if SCAN_NEON || SCAN_SSE2
+        // NOTE: A block is skipped whole if its last start does not pass the
+        //       address; starts only increase.
+        uint64_t sum;
+        if (((end - p) >= 16) && sumOfSmallDeltas(p, &sum) && (((current + sum) & mask) <= address)) {
+            current += sum;
+            *start = current & mask;
+            isFound = YES;
+            p += 16;
+            continue;
+        }
+#endif
+
+        uint64_t delta = 0;
+        unsigned shift = 0;
+        uint8_t byte;
+        do {
+            if (p >= end) {
+                return isFound;
+            }
+            byte = *p++;
+            if (shift < 64) {
+                delta |= (uint64_t)(byte & 0x7f) << shift;
+            }
+            shift += 7;
+        } while (byte & 0x80);
+
+        if (delta == 0) {
+            // NOTE: The list is terminated by a zero delta.
+            break;
+        }
+
+        current += delta;
+        if ((current & mask) > address) {
+            break;
+        }
+        *start = current & mask;
+        isFound = YES;
+    }
+
+    return isFound;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
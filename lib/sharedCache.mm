@@ -9,113 +9,104 @@
 
 #include "sharedCache.h"
 
-#include <fcntl.h>
 #include <mach-o/nlist.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
 #include <launch-cache/dyld_cache_format.h>
+#include "input.h"
+#include "scan.h"
 
+#include <algorithm>
+#include <vector>
+
+// NOTE: Size of the buffer that the local symbols are read into.
+#define kLocalSymbolsWindowSize (64 * 1024)
+
+// NOTE: The offset is relative to the start of the local symbols.
+static BOOL readLocalSymbols(SCInput *input, uint64_t localSymbolsOffset, uint64_t localSymbolsSize, uint64_t offset, void *buffer, size_t length) {
+    return (offset <= localSymbolsSize) && (length <= localSymbolsSize - offset) &&
+        input->read(buffer, length, localSymbolsOffset + offset);
+}
+
+// NOTE: The shared cache path may refer to an entry inside of an archive (see
+//       input.h). Only the header, image infos and image paths are read.
 uint64_t offsetOfDylibInSharedCache(const char *sharedCachePath, const char *filepath) {
     uint64_t offset = 0;
 
-    int fd = open(sharedCachePath, O_RDONLY);
-    if (fd < 0) {
+    SCInput *input = SCInputCreateWithPath(sharedCachePath);
+    if (input == NULL) {
         fprintf(stderr, "ERROR: Failed to open shared cache file: %s\n", sharedCachePath);
         return 0;
     }
 
-    size_t headerSize = sizeof(dyld_cache_header);
-    dyld_cache_header *header = reinterpret_cast<dyld_cache_header *>(malloc(headerSize));
-    if (read(fd, header, headerSize) < 0) {
+    dyld_cache_header header;
+    if (!input->read(&header, sizeof(header), 0)) {
         fprintf(stderr, "ERROR: Failed to read header for shared cache file: %s\n", sharedCachePath);
-        free(header);
-        close(fd);
+        input->release();
         return 0;
     }
-    const uint32_t imagesOffset = header->imagesOffset;
-    const uint32_t imagesCount = header->imagesCount;
-    const uint64_t dyldBaseAddress = header->dyldBaseAddress;
-    free(header);
-
-    // Adjust for page size.
-    // NOTE: mmap() may fail if offset is not page-aligned.
-    const int pagesize = getpagesize();
-    const uint32_t imagesPage = imagesOffset / pagesize;
-    const off_t imagesPageOffset = imagesPage * pagesize;
-    const size_t imagesLen = (imagesOffset - imagesPageOffset) + (imagesCount * sizeof(dyld_cache_image_info));
-
-    void *data = mmap(NULL, imagesLen, PROT_READ, MAP_PRIVATE, fd, imagesPageOffset);
-    if (data != MAP_FAILED) {
-        uint8_t *memory = reinterpret_cast<uint8_t *>(data);
-
-        dyld_cache_image_info *images = reinterpret_cast<dyld_cache_image_info *>(memory + (imagesOffset - imagesPageOffset));
+    const uint32_t imagesOffset = header.imagesOffset;
+    const uint32_t imagesCount = header.imagesCount;
+    const uint64_t dyldBaseAddress = header.dyldBaseAddress;
+
+    const size_t imagesLen = imagesCount * sizeof(dyld_cache_image_info);
+    const uint8_t *data = input->map(imagesOffset, imagesLen);
+    if (data != NULL) {
+        const dyld_cache_image_info *images = reinterpret_cast<const dyld_cache_image_info *>(data);
+        const uint64_t size = input->size();
         for (uint32_t i = 0; i < imagesCount; ++i) {
             // NOTE: The maximum allowed path length is 1024 bytes.
             //       (According to /usr/include/sys/syslimits.h)
+            char path[1025];
             const uint32_t pathFileOffset = images[i].pathFileOffset;
-            const uint32_t pathFilePage = pathFileOffset / pagesize;
-            const off_t pathFilePageOffset = pathFilePage * pagesize;
-            const size_t pathFileLen = (pathFileOffset - pathFilePageOffset) + 1024;
-            void *pathFile = mmap(NULL, pathFileLen, PROT_READ, MAP_PRIVATE, fd, pathFilePageOffset);
-            if (pathFile != MAP_FAILED) {
-                const char *path = reinterpret_cast<const char *>(reinterpret_cast<uint8_t *>(pathFile) + (pathFileOffset - pathFilePageOffset));
+            const size_t pathFileLen = (pathFileOffset < size) ? (size_t)std::min<uint64_t>(1024, size - pathFileOffset) : 0;
+            if ((pathFileLen != 0) && input->read(path, pathFileLen, pathFileOffset)) {
+                path[pathFileLen] = '\0';
                 if (strcmp(filepath, path) == 0) {
                     offset = (images[i].address - dyldBaseAddress);
-                    munmap(pathFile, pathFileLen);
                     break;
-                } else {
-                    munmap(pathFile, pathFileLen);
                 }
             } else {
-                fprintf(stderr, "ERROR: Failed to mmap image path portion of shared cache file: %s\n", sharedCachePath);
+                fprintf(stderr, "ERROR: Failed to read image path portion of shared cache file: %s\n", sharedCachePath);
             }
         }
 
-        munmap(data, imagesLen);
+        input->unmap(data, imagesOffset, imagesLen);
     } else {
-        fprintf(stderr, "ERROR: Failed to mmap image infos portion of shared cache file: %s\n", sharedCachePath);
+        fprintf(stderr, "ERROR: Failed to map image infos portion of shared cache file: %s\n", sharedCachePath);
     }
 
-    close(fd);
+    input->release();
 
     return offset;
 }
 
-// NOTE: This function uses static storage, meaning that it is not thread safe.
-//       The alternative would be to return a dynamically-allocated string, but
-//       that would require the caller to free it when done using it.
-const char *nameForLocalSymbol(const char *sharedCachePath, uint64_t dylibOffset, uint64_t symbolAddress) {
-    // TODO: Determine max allowed length for symbol names (if such a limit exists).
-    static char name[1025];
+// NOTE: The name is copied into the given buffer (truncated if necessary), so
+//       that this function may be called from several threads at once.
+const char *nameForLocalSymbol(const char *sharedCachePath, uint64_t dylibOffset, uint64_t symbolAddress, char *name, size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
 
-    int fd = open(sharedCachePath, O_RDONLY);
-    if (fd < 0) {
+    SCInput *input = SCInputCreateWithPath(sharedCachePath);
+    if (input == NULL) {
         fprintf(stderr, "ERROR: Failed to open shared cache file: %s\n", sharedCachePath);
         return NULL;
     }
 
-    size_t headerSize = sizeof(dyld_cache_header);
-    dyld_cache_header *header = reinterpret_cast<dyld_cache_header *>(malloc(headerSize));
-    if (read(fd, header, headerSize) < 0) {
+    dyld_cache_header header;
+    if (!input->read(&header, sizeof(header), 0)) {
         fprintf(stderr, "ERROR: Failed to read header for shared cache file: %s\n", sharedCachePath);
-        free(header);
-        close(fd);
+        input->release();
         return NULL;
     }
     // NOTE: Local symbol offset/size fields did not exist in earlier firmware.
     // TODO: At what point were they introduced?
-    if (header->mappingOffset < sizeof(dyld_cache_header)) return nil;
-    const BOOL is64Bit = (strstr(header->magic, "arm64") != NULL);
-    const uint64_t localSymbolsOffset = header->localSymbolsOffset;
-    const uint64_t localSymbolsSize = header->localSymbolsSize;
-    free(header);
-
-    // Adjust for page size.
-    // NOTE: mmap() may fail if offset is not page-aligned.
-    const int pagesize = getpagesize();
-    const uint32_t localSymbolsPage = localSymbolsOffset / pagesize;
-    const off_t localSymbolsPageOffset = localSymbolsPage * pagesize;
-    const size_t localSymbolsLen = (localSymbolsOffset - localSymbolsPageOffset) + localSymbolsSize;
+    if (header.mappingOffset < sizeof(dyld_cache_header)) {
+        input->release();
+        return NULL;
+    }
+    const BOOL is64Bit = (strstr(header.magic, "arm64") != NULL);
+    const uint64_t localSymbolsOffset = header.localSymbolsOffset;
+    const uint64_t localSymbolsSize = header.localSymbolsSize;
 
     // Adjust dylib offset.
     // FIXME: As mentioned in SCSymbolicator, the passed value of dylib offset
@@ -123,47 +114,79 @@ const char *nameForLocalSymbol(const char *sharedCachePath, uint64_t dylibOffset
     dylibOffset -= (is64Bit ? 0x60000000 : 0x200000);
 
     // Zero-out any previously retrieved name.
-    memset(name, 0, sizeof(name));
-
-    void *data = mmap(NULL, localSymbolsLen, PROT_READ, MAP_PRIVATE, fd, localSymbolsPageOffset);
-    close(fd);
-    if (data != MAP_FAILED) {
-        dyld_cache_local_symbols_info *localSymbols = reinterpret_cast<dyld_cache_local_symbols_info *>(reinterpret_cast<uint8_t *>(data) + (localSymbolsOffset - localSymbolsPageOffset));
-        dyld_cache_local_symbols_entry *entries = reinterpret_cast<dyld_cache_local_symbols_entry *>(reinterpret_cast<uint8_t *>(localSymbols) + localSymbols->entriesOffset);
-        for (uint32_t i = 0; i < localSymbols->entriesCount; ++i) {
-            dyld_cache_local_symbols_entry *entry = &entries[i];
-            if (entry->dylibOffset == dylibOffset) {
-                for (uint32_t j = 0; j < entry->nlistCount; ++j) {
-                    if (is64Bit) {
-                        const struct nlist_64 *nlists = reinterpret_cast<const struct nlist_64 *>((uint64_t)localSymbols + localSymbols->nlistOffset);
-                        const struct nlist_64 *n = &nlists[entry->nlistStartIndex + j];
-                        if (n->n_value == symbolAddress) {
-                            if (n->n_un.n_strx != 0 && (n->n_type & N_STAB) == 0) {
-                                const char *strings = reinterpret_cast<const char *>((uint64_t)localSymbols + localSymbols->stringsOffset);
-                                strncpy(name, (strings + n->n_un.n_strx), 1024);
-                            }
-                            break;
-                        }
-                    } else {
-                        const struct nlist *nlists = reinterpret_cast<const struct nlist *>((uint64_t)localSymbols + localSymbols->nlistOffset);
-                        const struct nlist *n = &nlists[entry->nlistStartIndex + j];
-                        if (n->n_value == symbolAddress) {
-                            if (n->n_un.n_strx != 0 && (n->n_type & N_STAB) == 0) {
-                                const char *strings = reinterpret_cast<const char *>((uint64_t)localSymbols + localSymbols->stringsOffset);
-                                strncpy(name, (strings + n->n_un.n_strx), 1024);
-                            }
-                            break;
-                        }
-                    }
+    memset(name, 0, size);
+
+    // NOTE: The local symbols portion of the shared cache is read in windows
+    //       (see kLocalSymbolsWindowSize), rather than being mapped in full.
+    dyld_cache_local_symbols_info localSymbols;
+    std::vector<uint8_t> window(kLocalSymbolsWindowSize);
+    BOOL succeeded = readLocalSymbols(input, localSymbolsOffset, localSymbolsSize, 0, &localSymbols, sizeof(localSymbols));
+
+    // Find the entry of the dylib.
+    dyld_cache_local_symbols_entry entry;
+    BOOL isEntryFound = NO;
+    const uint32_t entriesPerWindow = window.size() / sizeof(dyld_cache_local_symbols_entry);
+    for (uint32_t i = 0; succeeded && !isEntryFound && (i < localSymbols.entriesCount); i += entriesPerWindow) {
+        const uint32_t count = std::min(entriesPerWindow, localSymbols.entriesCount - i);
+        const uint64_t offset = localSymbols.entriesOffset + (uint64_t)i * sizeof(dyld_cache_local_symbols_entry);
+        succeeded = readLocalSymbols(input, localSymbolsOffset, localSymbolsSize, offset, &window[0], count * sizeof(dyld_cache_local_symbols_entry));
+        if (succeeded) {
+            const dyld_cache_local_symbols_entry *entries = reinterpret_cast<const dyld_cache_local_symbols_entry *>(&window[0]);
+            for (uint32_t j = 0; j < count; ++j) {
+                if (entries[j].dylibOffset == dylibOffset) {
+                    entry = entries[j];
+                    isEntryFound = YES;
+                    break;
+                }
+            }
+        }
+    }
+
+    // NOTE: The entries of the dylib are scanned for the address, several at
+    //       a time (see scan.h).
+    if (isEntryFound) {
+        const size_t nlistSize = is64Bit ? sizeof(struct nlist_64) : sizeof(struct nlist);
+        const uint32_t nlistsPerWindow = window.size() / nlistSize;
+        for (uint32_t i = 0; succeeded && (i < entry.nlistCount); i += nlistsPerWindow) {
+            const uint32_t count = std::min(nlistsPerWindow, entry.nlistCount - i);
+            const uint64_t offset = localSymbols.nlistOffset + ((uint64_t)entry.nlistStartIndex + i) * nlistSize;
+            succeeded = readLocalSymbols(input, localSymbolsOffset, localSymbolsSize, offset, &window[0], count * nlistSize);
+            if (!succeeded) {
+                break;
+            }
+
+            const uint32_t j = indexOfNlistWithValue(&window[0], count, is64Bit, symbolAddress);
+            if (j < count) {
+                uint32_t strx;
+                uint8_t type;
+                if (is64Bit) {
+                    const struct nlist_64 *n = reinterpret_cast<const struct nlist_64 *>(&window[0]) + j;
+                    strx = n->n_un.n_strx;
+                    type = n->n_type;
+                } else {
+                    const struct nlist *n = reinterpret_cast<const struct nlist *>(&window[0]) + j;
+                    strx = n->n_un.n_strx;
+                    type = n->n_type;
+                }
+                if (strx != 0 && (type & N_STAB) == 0 && (strx < localSymbols.stringsSize)) {
+                    // NOTE: Only as much of the string pool as fits in the
+                    //       buffer is read; the name is terminated by the
+                    //       zeroed last byte if it is truncated.
+                    const size_t length = std::min<size_t>(size - 1, localSymbols.stringsSize - strx);
+                    succeeded = readLocalSymbols(input, localSymbolsOffset, localSymbolsSize, (uint64_t)localSymbols.stringsOffset + strx, name, length);
                 }
                 break;
             }
         }
-        munmap(data, localSymbolsLen);
-    } else {
-        fprintf(stderr, "ERROR: Failed to mmap local symbols portion of shared cache file: %s\n", sharedCachePath);
     }
 
+    if (!succeeded) {
+        fprintf(stderr, "ERROR: Failed to read local symbols portion of shared cache file: %s\n", sharedCachePath);
+        memset(name, 0, size);
+    }
+
+    input->release();
+
     return name;
 }
 
@@ -0,0 +1,300 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "symbols.h"
+
+#import "SCBinaryInfo.h"
+#import "SCBinaryInfo-Private.h"
+
+#include <mach-o/nlist.h>
+#include "image.h"
+#include "input.h"
+#include "methods.h"
+
+#include <algorithm>
+#include <string>
+#include <string.h>
+
+// NOTE: A source of named symbols, in ascending address order.
+class SCSymbolStream {
+    public:
+        SCSymbolStream(SCSymbolSource source) : source_(source), isAtEnd_(YES), address_(0), name_(NULL) {}
+        virtual ~SCSymbolStream() {}
+
+        SCSymbolSource source() const { return source_; }
+        BOOL isAtEnd() const { return isAtEnd_; }
+        uint64_t address() const { return address_; }
+        virtual const char *name() { return name_; }
+        virtual void advance() = 0;
+        virtual void seek(uint64_t address) = 0;
+
+    protected:
+        SCSymbolSource source_;
+        BOOL isAtEnd_;
+        uint64_t address_;
+        const char *name_;
+};
+
+// NOTE: Symbol table entries are not sorted by address; sorting an array of
+//       indices avoids copying the entries (or their names).
+template <typename NList>
+class SCNlistStream : public SCSymbolStream {
+    public:
+        SCNlistStream(SCSymbolSource source, const uint8_t *nlists, uint32_t count, const char *strings, uint32_t stringsSize) :
+            SCSymbolStream(source), nlists_(reinterpret_cast<const NList *>(nlists)), strings_(strings), position_(0) {
+            for (uint32_t i = 0; i < count; ++i) {
+                const NList *n = &nlists_[i];
+                if (((n->n_type & N_STAB) == 0) && ((n->n_type & N_TYPE) == N_SECT) &&
+                        (n->n_un.n_strx != 0) && (n->n_un.n_strx < stringsSize)) {
+                    indices_.push_back(i);
+                }
+            }
+            std::sort(indices_.begin(), indices_.end(), CompareAddress(nlists_));
+            advance();
+        }
+
+        void advance() {
+            if (position_ < indices_.size()) {
+                const NList *n = &nlists_[indices_[position_++]];
+                address_ = n->n_value;
+                name_ = strings_ + n->n_un.n_strx;
+                isAtEnd_ = NO;
+            } else {
+                isAtEnd_ = YES;
+            }
+        }
+
+        void seek(uint64_t address) {
+            position_ = std::lower_bound(indices_.begin(), indices_.end(), address, CompareAddress(nlists_)) - indices_.begin();
+            advance();
+        }
+
+    private:
+        class CompareAddress {
+            public:
+                CompareAddress(const NList *nlists) : nlists_(nlists) {}
+                bool operator()(uint32_t a, uint32_t b) const {
+                    return nlists_[a].n_value < nlists_[b].n_value;
+                }
+                bool operator()(uint32_t a, uint64_t address) const {
+                    return nlists_[a].n_value < address;
+                }
+            private:
+                const NList *nlists_;
+        };
+
+        const NList *nlists_;
+        const char *strings_;
+        std::vector<uint32_t> indices_;
+        size_t position_;
+};
+
+// NOTE: Method names are only built when requested, into a buffer owned by
+//       the stream.
+class SCMethodStream : public SCSymbolStream {
+    public:
+        SCMethodStream(SCMethodTable *table) : SCSymbolStream(SCSymbolSourceMethods), table_(table), position_(0), index_(0) {
+            table_->retain();
+            advance();
+        }
+
+        ~SCMethodStream() {
+            table_->release();
+        }
+
+        void advance() {
+            if (position_ < table_->count()) {
+                index_ = position_++;
+                address_ = table_->addressAtIndex(index_);
+                isAtEnd_ = NO;
+            } else {
+                isAtEnd_ = YES;
+            }
+        }
+
+        const char *name() {
+            table_->getNameAtIndex(index_, nameBuffer_);
+            return nameBuffer_.c_str();
+        }
+
+        void seek(uint64_t address) {
+            position_ = table_->addressTable()->lowerBound(address);
+            advance();
+        }
+
+    private:
+        SCMethodTable *table_;
+        size_t position_;
+        size_t index_;
+        std::string nameBuffer_;
+};
+
+static void addNlistStream(std::vector<SCSymbolStream *> &streams, SCSymbolSource source, BOOL is64Bit, const uint8_t *nlists, uint32_t count, const char *strings, uint32_t stringsSize) {
+    if ((nlists != NULL) && (strings != NULL)) {
+        if (is64Bit) {
+            streams.push_back(new SCNlistStream<struct nlist_64>(source, nlists, count, strings, stringsSize));
+        } else {
+            streams.push_back(new SCNlistStream<struct nlist>(source, nlists, count, strings, stringsSize));
+        }
+    }
+}
+
+#pragma mark - Creation & Destruction
+
+SCSymbolCursor *SCSymbolCursor::createWithBinaryInfo(SCBinaryInfo *binaryInfo) {
+    SCInput *input = [binaryInfo createInput];
+    if (input == NULL) {
+        return NULL;
+    }
+
+    SCMachOImage *image = SCMachOImage::createWithBinary(input, [binaryInfo cpuType], [binaryInfo cpuSubtype]);
+    input->release();
+    if (image == NULL) {
+        fprintf(stderr, "ERROR: Failed to load image for file: %s\n", [[binaryInfo path] UTF8String]);
+        return NULL;
+    }
+
+    SCMethodTable *methods = [binaryInfo isEncrypted] ? NULL : [binaryInfo methodTable];
+    return new SCSymbolCursor(image, methods);
+}
+
+// NOTE: Methods are not available for dylibs in the shared cache.
+SCSymbolCursor *SCSymbolCursor::createWithSharedCache(const char *sharedCachePath, const char *dylibPath) {
+    SCInput *input = SCInputCreateWithPath(sharedCachePath);
+    if (input == NULL) {
+        return NULL;
+    }
+
+    SCMachOImage *image = SCMachOImage::createWithSharedCache(input, dylibPath);
+    input->release();
+    if (image == NULL) {
+        fprintf(stderr, "ERROR: Failed to load image for dylib \"%s\" from shared cache: %s\n", dylibPath, sharedCachePath);
+        return NULL;
+    }
+
+    return new SCSymbolCursor(image, NULL);
+}
+
+SCSymbolCursor::SCSymbolCursor(SCMachOImage *image, SCMethodTable *methods) : image_(image),
+    firstFunctionStart_(NULL, 0, 0, NO), functionStarts_(NULL, 0, 0, NO),
+    functionStart_(0), nextFunctionStart_(0), hasFunctionStart_(NO), hasNextFunctionStart_(NO), textEnd_(0) {
+    const SCSegmentInfo *text = image->segmentNamed("__TEXT");
+    if (text != NULL) {
+        textEnd_ = text->vmaddr + text->vmsize;
+    }
+
+    // Create sources of named symbols.
+    // NOTE: Streams are listed in order of preference for naming an address.
+    uint32_t count;
+    uint32_t stringsSize;
+    const uint8_t *nlists = image->symbols(&count);
+    const char *strings = image->strings(&stringsSize);
+    addNlistStream(streams_, SCSymbolSourceSymbolTable, image->is64Bit(), nlists, count, strings, stringsSize);
+    nlists = image->localSymbols(&count);
+    strings = image->localStrings(&stringsSize);
+    addNlistStream(streams_, SCSymbolSourceLocalSymbols, image->is64Bit(), nlists, count, strings, stringsSize);
+    if ((methods != NULL) && (methods->count() != 0)) {
+        streams_.push_back(new SCMethodStream(methods));
+    }
+
+    // Prepare to decode function starts.
+    size_t length;
+    const uint8_t *data = image->functionStarts(&length);
+    if (data != NULL) {
+        firstFunctionStart_ = SCFunctionStartsIterator(data, length, image->baseAddress(), (image->cputype() == CPU_TYPE_ARM));
+    }
+    rewindFunctionStarts();
+}
+
+SCSymbolCursor::~SCSymbolCursor() {
+    for (std::vector<SCSymbolStream *>::iterator i = streams_.begin(); i != streams_.end(); ++i) {
+        delete *i;
+    }
+    delete image_;
+}
+
+#pragma mark - Public Methods
+
+BOOL SCSymbolCursor::next(SCSymbolRecord *record) {
+    // Determine the lowest address among the sources.
+    BOOL hasAddress = hasFunctionStart_;
+    uint64_t address = hasFunctionStart_ ? functionStart_ : 0;
+    for (std::vector<SCSymbolStream *>::iterator i = streams_.begin(); i != streams_.end(); ++i) {
+        SCSymbolStream *stream = *i;
+        if (!stream->isAtEnd() && (!hasAddress || (stream->address() < address))) {
+            address = stream->address();
+            hasAddress = YES;
+        }
+    }
+    if (!hasAddress) {
+        return NO;
+    }
+
+    // Take the name from the preferred source, consuming all entries for the
+    // address.
+    const char *name = NULL;
+    SCSymbolSource source = SCSymbolSourceNone;
+    for (std::vector<SCSymbolStream *>::iterator i = streams_.begin(); i != streams_.end(); ++i) {
+        SCSymbolStream *stream = *i;
+        while (!stream->isAtEnd() && (stream->address() == address)) {
+            if (name == NULL) {
+                name = stream->name();
+                source = stream->source();
+            }
+            stream->advance();
+        }
+    }
+
+    uint64_t size = 0;
+    const BOOL isFunctionStart = hasFunctionStart_ && (functionStart_ == address);
+    if (isFunctionStart) {
+        uint64_t end = hasNextFunctionStart_ ? nextFunctionStart_ : textEnd_;
+        size = (end > address) ? (end - address) : 0;
+        advanceFunctionStart();
+    }
+
+    record->address = address;
+    record->size = size;
+    record->name = name;
+    record->source = source;
+    record->isFunctionStart = isFunctionStart;
+    return YES;
+}
+
+// NOTE: Function starts are decoded onward from the current one when seeking
+//       forward, and from the beginning otherwise.
+void SCSymbolCursor::seek(uint64_t address) {
+    if (!hasFunctionStart_ || (functionStart_ >= address)) {
+        rewindFunctionStarts();
+    }
+    while (hasFunctionStart_ && (functionStart_ < address)) {
+        advanceFunctionStart();
+    }
+    for (std::vector<SCSymbolStream *>::iterator i = streams_.begin(); i != streams_.end(); ++i) {
+        (*i)->seek(address);
+    }
+}
+
+#pragma mark - Private Methods
+
+void SCSymbolCursor::rewindFunctionStarts() {
+    functionStarts_ = firstFunctionStart_;
+    hasNextFunctionStart_ = functionStarts_.next(&nextFunctionStart_);
+    advanceFunctionStart();
+}
+
+void SCSymbolCursor::advanceFunctionStart() {
+    hasFunctionStart_ = hasNextFunctionStart_;
+    functionStart_ = nextFunctionStart_;
+    if (hasNextFunctionStart_) {
+        hasNextFunctionStart_ = functionStarts_.next(&nextFunctionStart_);
+    }
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,159 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "addressTable.h"
+
+#include <algorithm>
+#include <vector>
+
+// NOTE: A fixed sequence, so that failures can be reproduced.
+static uint64_t nextRandom(uint64_t *state) {
+    *state = (*state * 6364136223846793005ULL) + 1442695040888963407ULL;
+    return *state ^ (*state >> 29);
+}
+
+static void checkQuery(const SCAddressTable *table, const std::vector<uint64_t> &addresses, uint64_t address) {
+    const size_t count = addresses.size();
+    const size_t lower = std::lower_bound(addresses.begin(), addresses.end(), address) - addresses.begin();
+    const size_t upper = std::upper_bound(addresses.begin(), addresses.end(), address) - addresses.begin();
+    CHECK(table->lowerBound(address) == lower);
+    CHECK(table->upperBound(address) == upper);
+    CHECK(table->indexForAddress(address) == ((upper != 0) ? (upper - 1) : count));
+    CHECK(table->indexBeforeAddress(address) == ((lower != 0) ? (lower - 1) : count));
+}
+
+static void checkTable(const std::vector<uint64_t> &addresses, uint64_t *state) {
+    const size_t count = addresses.size();
+    SCAddressTable *table = SCAddressTable::create(addresses.empty() ? NULL : &addresses[0], count);
+    CHECK(table != NULL);
+    if (table == NULL) {
+        return;
+    }
+
+    CHECK(table->count() == count);
+    for (size_t i = 0; i < count; ++i) {
+        CHECK(table->addressAtIndex(i) == addresses[i]);
+    }
+
+    checkQuery(table, addresses, 0);
+    checkQuery(table, addresses, UINT64_MAX);
+    for (size_t i = 0; i < count; ++i) {
+        checkQuery(table, addresses, addresses[i] - 1);
+        checkQuery(table, addresses, addresses[i]);
+        checkQuery(table, addresses, addresses[i] + 1);
+    }
+    for (size_t i = 0; i < 64; ++i) {
+        checkQuery(table, addresses, nextRandom(state));
+    }
+    table->release();
+}
+
+// NOTE: Every size up to a few levels covers both perfect trees and trees
+//       with a partly filled last level.
+static void testSizes() {
+    uint64_t state = 1;
+    for (size_t count = 0; count <= 130; ++count) {
+        std::vector<uint64_t> addresses;
+        for (size_t i = 0; i < count; ++i) {
+            addresses.push_back(0x1000 + (i * 4));
+        }
+        checkTable(addresses, &state);
+    }
+}
+
+static void testRandom() {
+    uint64_t state = 2;
+    const size_t counts[] = {1000, 4095, 4096, 65537};
+    for (size_t i = 0; i < (sizeof(counts) / sizeof(counts[0])); ++i) {
+        std::vector<uint64_t> addresses;
+        for (size_t j = 0; j < counts[i]; ++j) {
+            addresses.push_back(nextRandom(&state) % (counts[i] * 16));
+        }
+        std::sort(addresses.begin(), addresses.end());
+        checkTable(addresses, &state);
+    }
+}
+
+// NOTE: Duplicates and the ends of the address space.
+static void testEdges() {
+    uint64_t state = 3;
+    std::vector<uint64_t> addresses;
+    addresses.push_back(0);
+    addresses.push_back(0);
+    addresses.push_back(5);
+    addresses.push_back(5);
+    addresses.push_back(5);
+    addresses.push_back(UINT64_MAX - 1);
+    addresses.push_back(UINT64_MAX);
+    addresses.push_back(UINT64_MAX);
+    checkTable(addresses, &state);
+
+    std::vector<uint64_t> same(100, 0x4000);
+    checkTable(same, &state);
+}
+
+// NOTE: The results of a cursor (as used for a batch of sorted addresses)
+//       must match those of single lookups.
+static void checkCursor(const SCAddressTable *table, const std::vector<uint64_t> &queries) {
+    SCAddressCursor cursor(table);
+    CHECK(cursor.count() == table->count());
+    for (std::vector<uint64_t>::const_iterator i = queries.begin(); i != queries.end(); ++i) {
+        CHECK(cursor.indexForAddress(*i) == table->indexForAddress(*i));
+    }
+}
+
+static void testCursor() {
+    uint64_t state = 4;
+    const size_t counts[] = {1, 2, 7, 100, 5000};
+    for (size_t i = 0; i < (sizeof(counts) / sizeof(counts[0])); ++i) {
+        std::vector<uint64_t> addresses;
+        for (size_t j = 0; j < counts[i]; ++j) {
+            addresses.push_back(nextRandom(&state) % (counts[i] * 8));
+        }
+        std::sort(addresses.begin(), addresses.end());
+        SCAddressTable *table = SCAddressTable::create(&addresses[0], addresses.size());
+
+        // Dense, sparse and repeated ascending queries.
+        std::vector<uint64_t> queries;
+        for (uint64_t address = 0; address <= (counts[i] * 8) + 1; ++address) {
+            queries.push_back(address);
+        }
+        checkCursor(table, queries);
+
+        queries.clear();
+        for (size_t j = 0; j < 50; ++j) {
+            queries.push_back(nextRandom(&state) % (counts[i] * 10));
+        }
+        std::sort(queries.begin(), queries.end());
+        queries.insert(queries.begin() + 25, queries[25]);
+        queries.push_back(UINT64_MAX);
+        checkCursor(table, queries);
+
+        // NOTE: Out of order queries fall back to full searches.
+        std::vector<uint64_t> unsorted(queries.rbegin(), queries.rend());
+        checkCursor(table, unsorted);
+
+        table->release();
+    }
+
+    SCAddressCursor empty;
+    CHECK(empty.count() == 0);
+    CHECK(empty.indexForAddress(0x1000) == 0);
+}
+
+int main() {
+    testSizes();
+    testRandom();
+    testEdges();
+    testCursor();
+    return finish("addressTable");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,39 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_TESTS_COMPAT_OSBYTEORDER_H_
+#define SYMBOLICATE_TESTS_COMPAT_OSBYTEORDER_H_
+
+// NOTE: Stand-in for the Darwin header, for building the tests on other hosts
+//       (see Makefile). The host is assumed to be little-endian.
+
+#include <stdint.h>
+#include <string.h>
+
+static inline uint16_t OSReadLittleInt16(const volatile void *base, uintptr_t offset) {
+    uint16_t value;
+    memcpy(&value, (const uint8_t *)base + offset, sizeof(value));
+    return value;
+}
+
+static inline uint32_t OSReadLittleInt32(const volatile void *base, uintptr_t offset) {
+    uint32_t value;
+    memcpy(&value, (const uint8_t *)base + offset, sizeof(value));
+    return value;
+}
+
+static inline uint64_t OSReadLittleInt64(const volatile void *base, uintptr_t offset) {
+    uint64_t value;
+    memcpy(&value, (const uint8_t *)base + offset, sizeof(value));
+    return value;
+}
+
+#endif // SYMBOLICATE_TESTS_COMPAT_OSBYTEORDER_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
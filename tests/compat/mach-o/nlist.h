@@ -0,0 +1,44 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_TESTS_COMPAT_NLIST_H_
+#define SYMBOLICATE_TESTS_COMPAT_NLIST_H_
+
+// NOTE: Stand-in for the Darwin header, for building the tests on other hosts
+//       (see Makefile). Only the declarations used by the library are given.
+
+#include <stdint.h>
+
+struct nlist {
+    union {
+        uint32_t n_strx;
+    } n_un;
+    uint8_t n_type;
+    uint8_t n_sect;
+    int16_t n_desc;
+    uint32_t n_value;
+};
+
+struct nlist_64 {
+    union {
+        uint32_t n_strx;
+    } n_un;
+    uint8_t n_type;
+    uint8_t n_sect;
+    uint16_t n_desc;
+    uint64_t n_value;
+};
+
+#define N_STAB 0xe0
+#define N_TYPE 0x0e
+#define N_SECT 0xe
+
+#endif // SYMBOLICATE_TESTS_COMPAT_NLIST_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,24 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_TESTS_COMPAT_MACHINE_H_
+#define SYMBOLICATE_TESTS_COMPAT_MACHINE_H_
+
+// NOTE: Stand-in for the Darwin header, for building the tests on other hosts
+//       (see Makefile). Only the declarations used by the library are given.
+
+typedef int cpu_type_t;
+typedef int cpu_subtype_t;
+
+#define CPU_ARCH_ABI64 0x01000000
+#define CPU_TYPE_ARM   ((cpu_type_t)12)
+
+#endif // SYMBOLICATE_TESTS_COMPAT_MACHINE_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,191 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "crashReport.h"
+
+#include <vector>
+
+static std::vector<SCCrashEvent> parse(const char *log) {
+    std::vector<SCCrashEvent> events;
+    SCCrashReportParser parser(log, strlen(log));
+    SCCrashEvent event;
+    while (parser.next(&event)) {
+        events.push_back(event);
+    }
+    return events;
+}
+
+static std::vector<SCCrashEvent> eventsOfType(const std::vector<SCCrashEvent> &events, SCCrashEventType type) {
+    std::vector<SCCrashEvent> result;
+    for (std::vector<SCCrashEvent>::const_iterator i = events.begin(); i != events.end(); ++i) {
+        if (i->type == type) {
+            result.push_back(*i);
+        }
+    }
+    return result;
+}
+
+static void testHeaderFields() {
+    std::vector<SCCrashEvent> events = eventsOfType(parse(
+        "Incident Identifier: ABC\r\n"
+        "Hardware Model:      iPhone6,1\n"
+        "Exception Type:  EXC_CRASH (SIGABRT)\n"), SCCrashEventHeaderField);
+    CHECK(events.size() == 3);
+    if (events.size() == 3) {
+        CHECK(isEqual(events[0].headerField.key, "Incident Identifier"));
+        CHECK(isEqual(events[0].headerField.value, "ABC"));
+        CHECK(isEqual(events[1].headerField.value, "iPhone6,1"));
+        CHECK(isEqual(events[2].headerField.value, "EXC_CRASH (SIGABRT)"));
+    }
+}
+
+static void testExceptionAddressList() {
+    std::vector<SCCrashEvent> events = parse(
+        "Last Exception Backtrace:\n"
+        "(0x2d7bae83 0x3834e6c7 0x2d6f1d7b)\n"
+        "\n");
+    CHECK(events.size() == 4);
+    if (events.size() == 4) {
+        CHECK(events[0].type == SCCrashEventThread);
+        CHECK(events[0].thread.index == -1);
+        const uint64_t addresses[] = {0x2d7bae83, 0x3834e6c7, 0x2d6f1d7b};
+        for (unsigned i = 0; i < 3; ++i) {
+            const SCCrashEvent &event = events[i + 1];
+            CHECK(event.type == SCCrashEventFrame);
+            CHECK(event.frame.threadIndex == -1);
+            CHECK(event.frame.index == -1);
+            CHECK(event.frame.address == addresses[i]);
+            CHECK(event.frame.symbol.length == 0);
+        }
+    }
+}
+
+static void testThreads() {
+    std::vector<SCCrashEvent> events = eventsOfType(parse(
+        "Thread 0 name:  Dispatch queue: com.apple.main-thread\n"
+        "Thread 0 Crashed:\n"
+        "0   libsystem_kernel.dylib        0x38a1e1fc __pthread_kill + 8\n"
+        "\n"
+        "Thread 1:\n"
+        "0   libsystem_kernel.dylib        0x38a0ba84 mach_msg_trap + 20\n"
+        "\n"
+        "Thread 12345678901 Crashed:\n"
+        "\n"), SCCrashEventThread);
+
+    // NOTE: The index of the last thread does not fit in an int.
+    CHECK(events.size() == 2);
+    if (events.size() == 2) {
+        CHECK(events[0].thread.index == 0);
+        CHECK(events[0].thread.isCrashed);
+        CHECK(isEqual(events[0].thread.name, "Dispatch queue: com.apple.main-thread"));
+        CHECK(events[1].thread.index == 1);
+        CHECK(!events[1].thread.isCrashed);
+        CHECK(events[1].thread.name.length == 0);
+    }
+}
+
+static void testFrames() {
+    std::vector<SCCrashEvent> events = eventsOfType(parse(
+        "Thread 0 Crashed:\n"
+        "0   libsystem_kernel.dylib        0x38a1e1fc __pthread_kill + 8\n"
+        "1   My App                        0x0009c123 0x9c000 + 291\n"
+        "\n"), SCCrashEventFrame);
+    CHECK(events.size() == 2);
+    if (events.size() == 2) {
+        CHECK(events[0].frame.threadIndex == 0);
+        CHECK(events[0].frame.index == 0);
+        CHECK(events[0].frame.address == 0x38a1e1fc);
+        CHECK(isEqual(events[0].frame.imageName, "libsystem_kernel.dylib"));
+        CHECK(isEqual(events[0].frame.symbol, "__pthread_kill + 8"));
+        CHECK(events[1].frame.index == 1);
+        CHECK(events[1].frame.address == 0x9c123);
+        CHECK(isEqual(events[1].frame.imageName, "My App"));
+        CHECK(isEqual(events[1].frame.symbol, "0x9c000 + 291"));
+    }
+}
+
+static void testRegisters() {
+    std::vector<SCCrashEvent> events = parse(
+        "Thread 0 crashed with ARM Thread State (32-bit):\n"
+        "    r0: 0x00000000    r1: 0x00000001\n"
+        "    pc: 0x38a1e1fc  cpsr: 0x00000010\n"
+        "\n");
+    CHECK(events.size() == 5);
+    if (events.size() == 5) {
+        CHECK(events[0].type == SCCrashEventThreadState);
+        CHECK(events[0].threadState.threadIndex == 0);
+        CHECK(isEqual(events[0].threadState.flavor, "ARM Thread State (32-bit)"));
+        const char *names[] = {"r0", "r1", "pc", "cpsr"};
+        const uint64_t values[] = {0, 1, 0x38a1e1fc, 0x10};
+        for (unsigned i = 0; i < 4; ++i) {
+            const SCCrashEvent &event = events[i + 1];
+            CHECK(event.type == SCCrashEventRegister);
+            CHECK(event.reg.threadIndex == 0);
+            CHECK(isEqual(event.reg.name, names[i]));
+            CHECK(event.reg.value == values[i]);
+        }
+    }
+}
+
+static void testBinaryImages() {
+    std::vector<SCCrashEvent> events = eventsOfType(parse(
+        "Binary Images:\n"
+        "0x9c000 - 0x1a3fff +My App armv7  <a2b4c6d8a2b4c6d8a2b4c6d8a2b4c6d8> /var/mobile/Applications/My App.app/My App\n"
+        "0x38a0a000 - 0x38a1efff libsystem_kernel.dylib armv7s  <1234> /usr/lib/system/libsystem_kernel.dylib\n"),
+        SCCrashEventBinaryImage);
+    CHECK(events.size() == 2);
+    if (events.size() == 2) {
+        const SCCrashBinaryImage &image = events[0].binaryImage;
+        CHECK(image.address == 0x9c000);
+        CHECK(image.endAddress == 0x1a3fff);
+        CHECK(image.isUserImage);
+        CHECK(isEqual(image.name, "My App"));
+        CHECK(isEqual(image.architecture, "armv7"));
+        CHECK(isEqual(image.uuid, "a2b4c6d8a2b4c6d8a2b4c6d8a2b4c6d8"));
+        CHECK(isEqual(image.path, "/var/mobile/Applications/My App.app/My App"));
+
+        const SCCrashBinaryImage &systemImage = events[1].binaryImage;
+        CHECK(!systemImage.isUserImage);
+        CHECK(isEqual(systemImage.name, "libsystem_kernel.dylib"));
+        CHECK(isEqual(systemImage.architecture, "armv7s"));
+    }
+}
+
+static void testImageRanges() {
+    SCCrashImageRanges ranges;
+    CHECK(ranges.isEmpty());
+    CHECK(ranges.imageIndexForAddress(0x1000) == SCCrashImageRanges::kNoImage);
+
+    // NOTE: Images need not be added in address order.
+    ranges.addImage(0x38a0a000, 0x38a1efff, 0);
+    ranges.addImage(0x9c000, 0x1a3fff, 1);
+    ranges.addImage(0x200000, 0x200fff, 2);
+    CHECK(!ranges.isEmpty());
+    CHECK(ranges.imageIndexForAddress(0x9bfff) == SCCrashImageRanges::kNoImage);
+    CHECK(ranges.imageIndexForAddress(0x9c000) == 1);
+    CHECK(ranges.imageIndexForAddress(0x1a3fff) == 1);
+    CHECK(ranges.imageIndexForAddress(0x1a4000) == SCCrashImageRanges::kNoImage);
+    CHECK(ranges.imageIndexForAddress(0x200800) == 2);
+    CHECK(ranges.imageIndexForAddress(0x38a10000) == 0);
+    CHECK(ranges.imageIndexForAddress(0x38a1f000) == SCCrashImageRanges::kNoImage);
+}
+
+int main() {
+    testHeaderFields();
+    testExceptionAddressList();
+    testThreads();
+    testFrames();
+    testRegisters();
+    testBinaryImages();
+    testImageRanges();
+    return finish("crashReport");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
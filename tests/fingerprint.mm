@@ -0,0 +1,144 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "fingerprint.h"
+
+#include <vector>
+
+// NOTE: Must match the values in fingerprint.mm.
+#define NUM_SHARDS 16
+static const size_t kEntryCost = 128;
+
+static SCStringView makeView(const char *string) {
+    SCStringView view = {string, strlen(string)};
+    return view;
+}
+
+static SCBacktraceFingerprint fingerprintForAddress(uint64_t address) {
+    SCBacktraceFingerprint fingerprint;
+    fingerprint.addBacktrace(0);
+    fingerprint.addFrame(address);
+    return fingerprint;
+}
+
+// NOTE: Returns fingerprints that all fall in the same shard of a cache.
+static std::vector<SCBacktraceFingerprint> fingerprintsInOneShard(unsigned count) {
+    std::vector<SCBacktraceFingerprint> fingerprints;
+    const SCBacktraceFingerprint first = fingerprintForAddress(0);
+    fingerprints.push_back(first);
+    for (uint64_t address = 1; fingerprints.size() < count; ++address) {
+        const SCBacktraceFingerprint fingerprint = fingerprintForAddress(address);
+        if ((fingerprint.hash() % NUM_SHARDS) == (first.hash() % NUM_SHARDS)) {
+            fingerprints.push_back(fingerprint);
+        }
+    }
+    return fingerprints;
+}
+
+static void testFingerprint() {
+    const SCStringView uuid = makeView("<0123456789abcdef0123456789ABCDEF>");
+    const SCStringView hyphenatedUUID = makeView("01234567-89AB-CDEF-0123-456789abcdef");
+
+    // NOTE: The same frames, in processes with different slides.
+    SCBacktraceFingerprint a;
+    a.addBacktrace(0);
+    CHECK(a.addFrame(uuid, 0x1000, 0x1234));
+    SCBacktraceFingerprint b;
+    b.addBacktrace(0);
+    CHECK(b.addFrame(hyphenatedUUID, 0x7000, 0x7234));
+    CHECK(a.key() == b.key());
+    CHECK(a.hash() == b.hash());
+
+    // NOTE: Moving a frame to the next backtrace changes the fingerprint.
+    SCBacktraceFingerprint c;
+    c.addBacktrace(0);
+    c.addFrame(1);
+    c.addBacktrace(1);
+    c.addFrame(2);
+    SCBacktraceFingerprint d;
+    d.addBacktrace(0);
+    d.addBacktrace(1);
+    d.addFrame(1);
+    d.addFrame(2);
+    CHECK(c.key() != d.key());
+
+    // NOTE: A frame with an invalid UUID is added by address.
+    SCBacktraceFingerprint e;
+    CHECK(!e.addFrame(makeView("<1234>"), 0x1000, 0x1234));
+    SCBacktraceFingerprint f;
+    f.addFrame(0x1234);
+    CHECK(e.key() == f.key());
+}
+
+static void testLookup() {
+    SCFingerprintCache *cache = SCFingerprintCache::create(1 << 20);
+    const SCBacktraceFingerprint fingerprint = fingerprintForAddress(1);
+
+    std::string value;
+    CHECK(!cache->lookup(fingerprint, value));
+    cache->insert(fingerprint, "symbols");
+    CHECK(cache->lookup(fingerprint, value));
+    CHECK(value == "symbols");
+
+    // NOTE: An existing entry is kept.
+    cache->insert(fingerprint, "other");
+    CHECK(cache->lookup(fingerprint, value));
+    CHECK(value == "symbols");
+
+    CHECK(cache->hits() == 2);
+    CHECK(cache->misses() == 1);
+    cache->release();
+}
+
+static void testEviction() {
+    // NOTE: Each shard holds two entries of this size, but not three.
+    const std::vector<SCBacktraceFingerprint> fingerprints = fingerprintsInOneShard(4);
+    const std::string value(300, 'x');
+    const size_t cost = fingerprints[0].key().size() + value.size() + kEntryCost;
+    SCFingerprintCache *cache = SCFingerprintCache::create(NUM_SHARDS * ((2 * cost) + (cost / 2)));
+
+    std::string result;
+    cache->insert(fingerprints[0], value);
+    cache->insert(fingerprints[1], value);
+    CHECK(cache->lookup(fingerprints[0], result));
+    CHECK(cache->lookup(fingerprints[1], result));
+
+    // NOTE: The least recently used entry is removed.
+    cache->insert(fingerprints[2], value);
+    CHECK(!cache->lookup(fingerprints[0], result));
+    CHECK(cache->lookup(fingerprints[1], result));
+    CHECK(cache->lookup(fingerprints[2], result));
+
+    // NOTE: A lookup counts as a use.
+    CHECK(cache->lookup(fingerprints[1], result));
+    cache->insert(fingerprints[3], value);
+    CHECK(cache->lookup(fingerprints[1], result));
+    CHECK(!cache->lookup(fingerprints[2], result));
+    CHECK(cache->lookup(fingerprints[3], result));
+
+    // NOTE: A value larger than a shard is not inserted, and so does not
+    //       remove anything.
+    const SCBacktraceFingerprint large = fingerprintForAddress(UINT64_MAX);
+    cache->insert(large, std::string(3 * cost, 'x'));
+    CHECK(!cache->lookup(large, result));
+    CHECK(cache->lookup(fingerprints[1], result));
+    CHECK(cache->lookup(fingerprints[3], result));
+
+    cache->release();
+}
+
+int main() {
+    testFingerprint();
+    testLookup();
+    testEviction();
+    return finish("fingerprint");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,263 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "fixups.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+// NOTE: Formats are from mach-o/fixup-chains.h.
+#define DYLD_CHAINED_PTR_ARM64E            1
+#define DYLD_CHAINED_PTR_64                2
+#define DYLD_CHAINED_PTR_64_OFFSET         6
+#define DYLD_CHAINED_PTR_ARM64E_USERLAND   9
+#define DYLD_CHAINED_PTR_ARM64E_USERLAND24 12
+
+#define DYLD_CHAINED_PTR_START_NONE 0xffff
+
+#define DYLD_CHAINED_IMPORT          1
+#define DYLD_CHAINED_IMPORT_ADDEND64 3
+
+static const uint64_t kBaseAddress = 0x100000000ULL;
+static const uint64_t kDataOffset = 0x4000;
+static const uint16_t kPageSize = 0x4000;
+
+static void append16(std::vector<uint8_t> &data, uint16_t value) {
+    data.push_back(value & 0xff);
+    data.push_back(value >> 8);
+}
+
+static void append32(std::vector<uint8_t> &data, uint32_t value) {
+    append16(data, value & 0xffff);
+    append16(data, value >> 16);
+}
+
+static void append64(std::vector<uint8_t> &data, uint64_t value) {
+    append32(data, value & 0xffffffff);
+    append32(data, value >> 32);
+}
+
+static void put32(std::vector<uint8_t> &data, size_t offset, uint32_t value) {
+    for (unsigned i = 0; i < 4; ++i) {
+        data[offset + i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+// NOTE: An image with __TEXT, then __DATA of two pages, then __LINKEDIT.
+static std::vector<SCSegmentInfo> createSegments() {
+    std::vector<SCSegmentInfo> segments;
+    const char *names[] = {"__TEXT", "__DATA", "__LINKEDIT"};
+    const uint64_t offsets[] = {0, kDataOffset, kDataOffset + 2 * kPageSize};
+    for (unsigned i = 0; i < 3; ++i) {
+        SCSegmentInfo segment;
+        memset(&segment, 0, sizeof(segment));
+        strncpy(segment.name, names[i], sizeof(segment.name) - 1);
+        segment.vmaddr = kBaseAddress + offsets[i];
+        segment.fileoff = offsets[i];
+        segment.vmsize = segment.filesize = (i == 1) ? (2 * kPageSize) : kPageSize;
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+// NOTE: Builds the payload of LC_DYLD_CHAINED_FIXUPS, with fixups only in
+//       __DATA, and with one import per name.
+static std::vector<uint8_t> createFixupsData(uint16_t pointerFormat, const std::vector<uint16_t> &pageStarts,
+        uint32_t importsFormat, const std::vector<const char *> &importNames) {
+    std::vector<uint8_t> data(28, 0);
+
+    // Starts in image, followed by starts in segment.
+    const uint32_t startsOffset = data.size();
+    append32(data, 3);
+    append32(data, 0);
+    append32(data, 16);
+    append32(data, 0);
+    append32(data, 22 + 2 * pageStarts.size());
+    append16(data, kPageSize);
+    append16(data, pointerFormat);
+    append64(data, kDataOffset);
+    append32(data, 0);
+    append16(data, pageStarts.size());
+    for (size_t i = 0; i < pageStarts.size(); ++i) {
+        append16(data, pageStarts[i]);
+    }
+    while ((data.size() % 8) != 0) {
+        data.push_back(0);
+    }
+
+    // Imports, then their names.
+    std::vector<uint8_t> symbols(1, 0);
+    const uint32_t importsOffset = data.size();
+    for (size_t i = 0; i < importNames.size(); ++i) {
+        const uint32_t nameOffset = symbols.size();
+        symbols.insert(symbols.end(), importNames[i], importNames[i] + strlen(importNames[i]) + 1);
+        if (importsFormat == DYLD_CHAINED_IMPORT_ADDEND64) {
+            append64(data, (uint64_t)nameOffset << 32);
+            append64(data, 0);
+        } else {
+            append32(data, nameOffset << 9);
+        }
+    }
+    const uint32_t symbolsOffset = data.size();
+    data.insert(data.end(), symbols.begin(), symbols.end());
+
+    put32(data, 4, startsOffset);
+    put32(data, 8, importsOffset);
+    put32(data, 12, symbolsOffset);
+    put32(data, 16, importNames.size());
+    put32(data, 20, importsFormat);
+    return data;
+}
+
+static void checkFixup(const SCChainedFixups *fixups, uint64_t offset, uint64_t raw, SCFixupKind kind, uint64_t value) {
+    uint64_t result = 0;
+    CHECK(fixups->fixupAtOffset(offset, raw, &result) == kind);
+    if (kind != SCFixupNone) {
+        CHECK(result == value);
+    }
+}
+
+// NOTE: A chain on the first page of __DATA, starting at 0x10, of a rebase, a
+//       bind and another rebase; the second page has no fixups. Each pointer
+//       also holds the distance to the next one, and high bits that must not
+//       be taken as part of the target.
+static void testPointer64(uint16_t pointerFormat) {
+    std::vector<uint16_t> pageStarts;
+    pageStarts.push_back(0x10);
+    pageStarts.push_back(DYLD_CHAINED_PTR_START_NONE);
+    std::vector<const char *> importNames;
+    importNames.push_back("_OBJC_CLASS_$_NSObject");
+    importNames.push_back("_objc_msgSend");
+    std::vector<uint8_t> data = createFixupsData(pointerFormat, pageStarts, DYLD_CHAINED_IMPORT, importNames);
+    SCChainedFixups *fixups = SCChainedFixups::create(&data[0], data.size(), createSegments());
+    CHECK(fixups != NULL);
+    if (fixups == NULL) {
+        return;
+    }
+
+    // NOTE: The 64-bit formats count the distance in units of four bytes.
+    const uint64_t stride = 4;
+    const uint64_t target = (pointerFormat == DYLD_CHAINED_PTR_64_OFFSET) ? 0x1234 : (kBaseAddress + 0x1234);
+    const uint64_t rebase = target | (0xabULL << 36) | ((0x18 / stride) << 51);
+    const uint64_t bind = (1ULL << 63) | 1 | (0x7ULL << 24) | ((0x20 / stride) << 51);
+    const uint64_t last = (target + 0x10);
+
+    checkFixup(fixups, kDataOffset + 0x10, rebase, SCFixupRebase, kBaseAddress + 0x1234);
+    checkFixup(fixups, kDataOffset + 0x28, bind, SCFixupBind, 1);
+    checkFixup(fixups, kDataOffset + 0x48, last, SCFixupRebase, kBaseAddress + 0x1244);
+
+    // NOTE: Before the start of the chain, on a page without a chain, and
+    //       outside of any segment with fixups, values are plain data.
+    checkFixup(fixups, kDataOffset + 0x8, rebase, SCFixupNone, 0);
+    checkFixup(fixups, kDataOffset + kPageSize + 0x10, rebase, SCFixupNone, 0);
+    checkFixup(fixups, 0x10, rebase, SCFixupNone, 0);
+    checkFixup(fixups, kDataOffset + 2 * kPageSize, rebase, SCFixupNone, 0);
+    checkFixup(fixups, kDataOffset + 0x50, 0, SCFixupNone, 0);
+
+    CHECK(strcmp(fixups->importName(0), "_OBJC_CLASS_$_NSObject") == 0);
+    CHECK(strcmp(fixups->importName(1), "_objc_msgSend") == 0);
+    CHECK(fixups->importName(2) == NULL);
+    delete fixups;
+}
+
+static void testPointerARM64E(uint16_t pointerFormat) {
+    std::vector<uint16_t> pageStarts;
+    pageStarts.push_back(0);
+    pageStarts.push_back(0x100);
+    std::vector<const char *> importNames;
+    importNames.push_back("_OBJC_CLASS_$_NSObject");
+    std::vector<uint8_t> data = createFixupsData(pointerFormat, pageStarts, DYLD_CHAINED_IMPORT_ADDEND64, importNames);
+    SCChainedFixups *fixups = SCChainedFixups::create(&data[0], data.size(), createSegments());
+    CHECK(fixups != NULL);
+    if (fixups == NULL) {
+        return;
+    }
+
+    // NOTE: The arm64e formats count the distance in units of eight bytes.
+    const uint64_t next = 1ULL << 51;
+
+    // NOTE: Plain rebases hold a virtual address in the original format, and
+    //       an offset from the base address otherwise.
+    const uint64_t target = (pointerFormat == DYLD_CHAINED_PTR_ARM64E) ? (kBaseAddress + 0x2000) : 0x2000;
+    checkFixup(fixups, kDataOffset, target | (0x5aULL << 43) | next, SCFixupRebase, kBaseAddress + 0x2000);
+
+    // NOTE: Authenticated rebases always hold an offset, followed by the
+    //       diversity, address diversity and key.
+    const uint64_t authRebase = (1ULL << 63) | 0x3000 | (0x1234ULL << 32) | (1ULL << 48) | (2ULL << 49) | next;
+    checkFixup(fixups, kDataOffset + 0x8, authRebase, SCFixupRebase, kBaseAddress + 0x3000);
+
+    // NOTE: Binds hold a 16-bit ordinal, or a 24-bit one in the userland24
+    //       format; authenticated binds also have the top bit set.
+    const uint64_t ordinal = (pointerFormat == DYLD_CHAINED_PTR_ARM64E_USERLAND24) ? 0x12345 : 0x2345;
+    checkFixup(fixups, kDataOffset + 0x10, (1ULL << 62) | ordinal | (0x7ULL << 32) | next, SCFixupBind, ordinal);
+    checkFixup(fixups, kDataOffset + 0x18, (3ULL << 62) | ordinal | (0x1234ULL << 32), SCFixupBind, ordinal);
+
+    checkFixup(fixups, kDataOffset + kPageSize + 0xf8, authRebase, SCFixupNone, 0);
+    checkFixup(fixups, kDataOffset + kPageSize + 0x100, authRebase, SCFixupRebase, kBaseAddress + 0x3000);
+
+    CHECK(strcmp(fixups->importName(0), "_OBJC_CLASS_$_NSObject") == 0);
+    delete fixups;
+}
+
+static void testMalformed() {
+    const std::vector<SCSegmentInfo> segments = createSegments();
+    std::vector<uint16_t> pageStarts(1, 0);
+    std::vector<const char *> importNames(1, "_objc_msgSend");
+
+    std::vector<uint8_t> data = createFixupsData(DYLD_CHAINED_PTR_64, pageStarts, DYLD_CHAINED_IMPORT, importNames);
+    CHECK(SCChainedFixups::create(&data[0], 20, segments) == NULL);
+
+    // Unsupported version.
+    put32(data, 0, 1);
+    CHECK(SCChainedFixups::create(&data[0], data.size(), segments) == NULL);
+
+    // Starts beyond the end of the data.
+    data = createFixupsData(DYLD_CHAINED_PTR_64, pageStarts, DYLD_CHAINED_IMPORT, importNames);
+    put32(data, 4, data.size());
+    CHECK(SCChainedFixups::create(&data[0], data.size(), segments) == NULL);
+
+    // Unsupported (32-bit) pointer format.
+    data = createFixupsData(3, pageStarts, DYLD_CHAINED_IMPORT, importNames);
+    CHECK(SCChainedFixups::create(&data[0], data.size(), segments) == NULL);
+
+    // NOTE: Import names are optional; names must lie within, and be
+    //       terminated within, the data.
+    data = createFixupsData(DYLD_CHAINED_PTR_64, pageStarts, DYLD_CHAINED_IMPORT, importNames);
+    put32(data, 16, 1000);
+    SCChainedFixups *fixups = SCChainedFixups::create(&data[0], data.size(), segments);
+    CHECK(fixups != NULL);
+    if (fixups != NULL) {
+        CHECK(fixups->importName(0) == NULL);
+        checkFixup(fixups, kDataOffset, kBaseAddress + 0x10, SCFixupRebase, kBaseAddress + 0x10);
+        delete fixups;
+    }
+
+    data = createFixupsData(DYLD_CHAINED_PTR_64, pageStarts, DYLD_CHAINED_IMPORT, importNames);
+    data.back() = 'x';
+    fixups = SCChainedFixups::create(&data[0], data.size(), segments);
+    CHECK(fixups != NULL);
+    if (fixups != NULL) {
+        CHECK(fixups->importName(0) == NULL);
+        delete fixups;
+    }
+}
+
+int main() {
+    testPointer64(DYLD_CHAINED_PTR_64);
+    testPointer64(DYLD_CHAINED_PTR_64_OFFSET);
+    testPointerARM64E(DYLD_CHAINED_PTR_ARM64E);
+    testPointerARM64E(DYLD_CHAINED_PTR_ARM64E_USERLAND);
+    testPointerARM64E(DYLD_CHAINED_PTR_ARM64E_USERLAND24);
+    testMalformed();
+    return finish("fixups");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,272 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "input.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// NOTE: Size of uncompressed data between access points (see kInflateSpan in
+//       input.mm). Entries larger than this are inflated in several blocks.
+static const uint64_t kSpan = 4 * 1024 * 1024;
+
+// NOTE: A fixed sequence, so that failures can be reproduced.
+static uint64_t nextRandom(uint64_t *state) {
+    *state = (*state * 6364136223846793005ULL) + 1442695040888963407ULL;
+    return *state ^ (*state >> 29);
+}
+
+// NOTE: The contents are partly random, so that deflate produces several
+//       deflate blocks, but are still compressible.
+static std::vector<uint8_t> createContents(size_t length, uint64_t seed) {
+    std::vector<uint8_t> contents(length);
+    uint64_t state = seed;
+    for (size_t i = 0; i < length; ++i) {
+        contents[i] = 'a' + (nextRandom(&state) % 16);
+    }
+    return contents;
+}
+
+#pragma mark - Archive
+
+static void append16(std::vector<uint8_t> &data, uint16_t value) {
+    data.push_back(value & 0xff);
+    data.push_back(value >> 8);
+}
+
+static void append32(std::vector<uint8_t> &data, uint32_t value) {
+    append16(data, value & 0xffff);
+    append16(data, value >> 16);
+}
+
+typedef struct _SCTestEntry {
+    const char *name;
+    BOOL isDeflated;
+    std::vector<uint8_t> contents;
+} SCTestEntry;
+
+static std::vector<uint8_t> deflateContents(const std::vector<uint8_t> &contents) {
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    std::vector<uint8_t> compressed;
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return compressed;
+    }
+    compressed.resize(deflateBound(&strm, contents.size()));
+    strm.next_in = const_cast<Bytef *>(&contents[0]);
+    strm.avail_in = contents.size();
+    strm.next_out = &compressed[0];
+    strm.avail_out = compressed.size();
+    const int ret = deflate(&strm, Z_FINISH);
+    compressed.resize((ret == Z_STREAM_END) ? strm.total_out : 0);
+    deflateEnd(&strm);
+    return compressed;
+}
+
+// NOTE: Writes a zip archive of the given entries to a temporary file, and
+//       returns its path (or an empty string on failure).
+static std::string createArchive(const std::vector<SCTestEntry> &entries) {
+    std::vector<uint8_t> archive;
+    std::vector<uint8_t> directory;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const SCTestEntry &entry = entries[i];
+        const std::vector<uint8_t> data = entry.isDeflated ? deflateContents(entry.contents) : entry.contents;
+        const uint32_t crc = crc32(0, &entry.contents[0], entry.contents.size());
+        const uint16_t nameLength = strlen(entry.name);
+        const uint32_t localOffset = archive.size();
+
+        append32(archive, 0x04034b50);
+        append16(archive, 20);
+        append16(archive, 0);
+        append16(archive, entry.isDeflated ? 8 : 0);
+        append32(archive, 0);
+        append32(archive, crc);
+        append32(archive, data.size());
+        append32(archive, entry.contents.size());
+        append16(archive, nameLength);
+        append16(archive, 0);
+        archive.insert(archive.end(), entry.name, entry.name + nameLength);
+        archive.insert(archive.end(), data.begin(), data.end());
+
+        append32(directory, 0x02014b50);
+        append16(directory, 20);
+        append16(directory, 20);
+        append16(directory, 0);
+        append16(directory, entry.isDeflated ? 8 : 0);
+        append32(directory, 0);
+        append32(directory, crc);
+        append32(directory, data.size());
+        append32(directory, entry.contents.size());
+        append16(directory, nameLength);
+        append16(directory, 0);
+        append16(directory, 0);
+        append16(directory, 0);
+        append16(directory, 0);
+        append32(directory, 0);
+        append32(directory, localOffset);
+        directory.insert(directory.end(), entry.name, entry.name + nameLength);
+    }
+
+    const uint32_t directoryOffset = archive.size();
+    archive.insert(archive.end(), directory.begin(), directory.end());
+    append32(archive, 0x06054b50);
+    append16(archive, 0);
+    append16(archive, 0);
+    append16(archive, entries.size());
+    append16(archive, entries.size());
+    append32(archive, directory.size());
+    append32(archive, directoryOffset);
+    append16(archive, 0);
+
+    const char *tmpdir = getenv("TMPDIR");
+    std::string path = std::string((tmpdir != NULL) ? tmpdir : "/tmp") + "/symbolicate-input-XXXXXX";
+    std::vector<char> buffer(path.begin(), path.end());
+    buffer.push_back('\0');
+    const int fd = mkstemp(&buffer[0]);
+    if (fd < 0) {
+        return std::string();
+    }
+    const BOOL isWritten = (write(fd, &archive[0], archive.size()) == (ssize_t)archive.size());
+    close(fd);
+    if (!isWritten) {
+        unlink(&buffer[0]);
+        return std::string();
+    }
+    return std::string(&buffer[0]);
+}
+
+#pragma mark - Checks
+
+static void checkRead(SCInput *input, const std::vector<uint8_t> &contents, uint64_t offset, size_t length) {
+    std::vector<uint8_t> buffer(length + 1);
+    CHECK(input->read(&buffer[0], length, offset));
+    CHECK(memcmp(&buffer[0], &contents[offset], length) == 0);
+}
+
+static void checkMap(SCInput *input, const std::vector<uint8_t> &contents, uint64_t offset, size_t length) {
+    const uint8_t *data = input->map(offset, length);
+    CHECK(data != NULL);
+    if (data != NULL) {
+        CHECK(memcmp(data, &contents[offset], length) == 0);
+        input->unmap(data, offset, length);
+    }
+}
+
+// NOTE: Ranges are chosen around the boundaries between spans, in both
+//       directions, so that blocks are inflated both in and out of order.
+static void checkInput(SCInput *input, const std::vector<uint8_t> &contents) {
+    const uint64_t size = contents.size();
+    CHECK(input->size() == size);
+
+    std::vector<uint64_t> offsets;
+    for (uint64_t boundary = kSpan; boundary < size; boundary += kSpan) {
+        offsets.push_back(boundary);
+    }
+    offsets.push_back(size);
+    for (size_t i = offsets.size(); i > 0; --i) {
+        const uint64_t boundary = offsets[i - 1];
+        checkRead(input, contents, boundary - 1, 1);
+        checkRead(input, contents, boundary - 100, 100);
+        if (boundary < size) {
+            checkRead(input, contents, boundary - 100, 200);
+            checkRead(input, contents, boundary, 1);
+            checkMap(input, contents, boundary - 0x100, 0x200);
+        }
+        checkMap(input, contents, boundary - 0x1000, 0x1000);
+    }
+    checkRead(input, contents, 0, size);
+    checkMap(input, contents, 0, size);
+
+    uint64_t state = size;
+    for (unsigned i = 0; i < 32; ++i) {
+        const uint64_t offset = nextRandom(&state) % (size - 1);
+        const size_t length = std::min<uint64_t>(1 + (nextRandom(&state) % 0x20000), size - offset);
+        checkRead(input, contents, offset, length);
+        checkMap(input, contents, offset, length);
+    }
+
+    // NOTE: Views of the same block may be held at the same time.
+    const uint8_t *first = input->map(16, 32);
+    const uint8_t *second = input->map(64, 32);
+    CHECK((first != NULL) && (second != NULL));
+    if ((first != NULL) && (second != NULL)) {
+        checkRead(input, contents, size - 32, 32);
+        CHECK(memcmp(first, &contents[16], 32) == 0);
+        CHECK(memcmp(second, &contents[64], 32) == 0);
+        input->unmap(second, 64, 32);
+        input->unmap(first, 16, 32);
+    }
+
+    // Ranges beyond the end.
+    uint8_t buffer[16];
+    CHECK(!input->read(buffer, sizeof(buffer), size - 8));
+    CHECK(input->map(size - 8, 16) == NULL);
+    CHECK(input->map(size + 1, 0) == NULL);
+}
+
+static void testArchive() {
+    std::vector<SCTestEntry> entries(3);
+    entries[0].name = "Payload/Test.app/Test";
+    entries[0].isDeflated = YES;
+    entries[0].contents = createContents((2 * kSpan) + 12345, 1);
+    entries[1].name = "stored";
+    entries[1].isDeflated = NO;
+    entries[1].contents = createContents(kSpan + 777, 2);
+    entries[2].name = "small";
+    entries[2].isDeflated = YES;
+    entries[2].contents = createContents(0x3000, 3);
+
+    const std::string path = createArchive(entries);
+    CHECK(!path.empty());
+    if (path.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        SCInput *input = SCInputCreateWithPath((path + "!/" + entries[i].name).c_str());
+        CHECK(input != NULL);
+        if (input != NULL) {
+            checkInput(input, entries[i].contents);
+            input->release();
+        }
+    }
+
+    // NOTE: Leading slashes of the entry name are ignored.
+    SCInput *input = SCInputCreateWithPath((path + "!//stored").c_str());
+    CHECK(input != NULL);
+    if (input != NULL) {
+        CHECK(input->size() == entries[1].contents.size());
+        input->release();
+    }
+
+    CHECK(SCInputCreateWithPath((path + "!/missing").c_str()) == NULL);
+    unlink(path.c_str());
+}
+
+static void testMemory() {
+    const std::vector<uint8_t> contents = createContents(0x10000, 4);
+    SCInput *input = SCInputCreateWithMemory(&contents[0], contents.size());
+    checkInput(input, contents);
+    input->release();
+}
+
+int main() {
+    testArchive();
+    testMemory();
+    return finish("input");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
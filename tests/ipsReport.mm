@@ -0,0 +1,136 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "ipsReport.h"
+
+static const char *kReport =
+    "{\"app_name\":\"MobileSafari\",\"bug_type\":\"309\"}\n"
+    "{\n"
+    "  \"vmSummary\" : \"text with \\\"quotes\\\" and {braces] to skip\",\n"
+    "  \"usedImages\" : [\n"
+    "    {\"arch\":\"arm64e\",\"base\":4372529152,\"size\":49152,\"uuid\":\"1234-5678\",\"path\":\"\\/private\\/var\\/Mobile Safari\",\"name\":\"MobileSafari\"},\n"
+    "    [1,2],\n"
+    "    {\"arch\":\"arm64e\",\"base\":6442450944,\"uuid\":\"abcd\",\"path\":\"/usr/lib/libsystem.dylib\",\"name\":\"lib\\\\\\\"\\n\\u00e9\\ud83d\\ude00\"}\n"
+    "  ],\n"
+    "  \"threads\" : [\n"
+    "    {\"id\":1,\"triggered\":true,\"queue\":\"com.apple.main-thread\",\"frames\":[{\"imageOffset\":4660,\"symbol\":\"main\",\"imageIndex\":0},{\"imageOffset\":16,\"imageIndex\":2}]},\n"
+    "    {\"id\":2,\"name\":\"worker\",\"frames\":[{\"imageOffset\":1}]}\n"
+    "  ],\n"
+    "  \"lastExceptionBacktrace\" : [{\"imageOffset\":8,\"imageIndex\":2}]\n"
+    "}\n";
+
+static void testImages(const SCIPSReport &report) {
+    const std::vector<SCIPSImage> &images = report.images();
+    CHECK(images.size() == 3);
+    if (images.size() != 3) {
+        return;
+    }
+
+    CHECK(images[0].address == 0x1049f8000ULL);
+    CHECK(images[0].size == 49152);
+    CHECK(isEqual(images[0].uuid, "1234-5678"));
+    CHECK(isEqual(images[0].architecture, "arm64e"));
+    CHECK(isEqual(images[0].path, "/private/var/Mobile Safari"));
+    CHECK(isEqual(images[0].name, "MobileSafari"));
+
+    // NOTE: An entry that is not an object still takes up its index.
+    CHECK(images[1].address == 0);
+    CHECK(images[1].path.length == 0);
+
+    CHECK(images[2].address == 0x180000000ULL);
+    CHECK(isEqual(images[2].path, "/usr/lib/libsystem.dylib"));
+    // NOTE: "é" is U+00E9, and "😀" is the surrogate pair of
+    //       U+1F600; both are decoded to UTF-8.
+    CHECK(isEqual(images[2].name, "lib\\\"\n\xc3\xa9\xf0\x9f\x98\x80"));
+}
+
+static void testThreads(const SCIPSReport &report) {
+    const std::vector<SCIPSThread> &threads = report.threads();
+    const std::vector<SCIPSFrame> &frames = report.frames();
+    CHECK(threads.size() == 3);
+    CHECK(frames.size() == 4);
+    if ((threads.size() != 3) || (frames.size() != 4)) {
+        return;
+    }
+
+    CHECK(threads[0].index == 0);
+    CHECK(threads[0].isCrashed);
+    CHECK(isEqual(threads[0].queue, "com.apple.main-thread"));
+    CHECK((threads[0].firstFrame == 0) && (threads[0].frameCount == 2));
+    CHECK(report.addressForFrame(frames[0]) == 0x1049f9234ULL);
+    CHECK(frames[1].imageIndex == 2);
+    CHECK(report.addressForFrame(frames[1]) == 0x180000010ULL);
+
+    CHECK(threads[1].index == 1);
+    CHECK(!threads[1].isCrashed);
+    CHECK(isEqual(threads[1].name, "worker"));
+    CHECK((threads[1].firstFrame == 2) && (threads[1].frameCount == 1));
+    CHECK(frames[2].imageIndex == SCIPSNoImage);
+    CHECK(report.addressForFrame(frames[2]) == 0);
+
+    CHECK(threads[2].index == -1);
+    CHECK((threads[2].firstFrame == 3) && (threads[2].frameCount == 1));
+    CHECK(report.addressForFrame(frames[3]) == 0x180000008ULL);
+}
+
+static void testParse() {
+    SCIPSReport report;
+    CHECK(report.parse(kReport, strlen(kReport)));
+    CHECK(isEqual(report.bugType(), "309"));
+    testImages(report);
+    testThreads(report);
+
+    // NOTE: The results of the previous parse are replaced.
+    const char *other = "{\"app_name\":\"x\"}\n{\"usedImages\":[]}\n";
+    CHECK(report.parse(other, strlen(other)));
+    CHECK(report.bugType().length == 0);
+    CHECK(report.images().empty());
+    CHECK(report.threads().empty());
+    CHECK(report.frames().empty());
+}
+
+static void testTextBody() {
+    const char *report = "{\"bug_type\":\"109\"}\nIncident Identifier: ABC\n";
+    SCIPSReport ipsReport;
+    CHECK(!ipsReport.parse(report, strlen(report)));
+
+    const char *body = NULL;
+    BOOL isJSON = YES;
+    CHECK(findIPSReportBody(report, strlen(report), &body, &isJSON));
+    CHECK(!isJSON);
+    CHECK((body != NULL) && (strcmp(body, "Incident Identifier: ABC\n") == 0));
+
+    CHECK(findIPSReportBody(kReport, strlen(kReport), &body, &isJSON));
+    CHECK(isJSON);
+
+    const char *textLog = "Incident Identifier: ABC\n";
+    CHECK(!findIPSReportBody(textLog, strlen(textLog), &body, &isJSON));
+}
+
+static void testTruncatedString() {
+    SCIPSReport report;
+    const char *unterminated = "{\"bug_type\":\"30";
+    CHECK(!report.parse(unterminated, strlen(unterminated)));
+    CHECK(report.bugType().length == 0);
+
+    // NOTE: The input ends within an escape sequence.
+    const char *escape = "{\"bug_type\":\"30\\";
+    CHECK(!report.parse(escape, strlen(escape)));
+    CHECK(report.bugType().length == 0);
+}
+
+int main() {
+    testParse();
+    testTextBody();
+    testTruncatedString();
+    return finish("ipsReport");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
@@ -0,0 +1,138 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "logWriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static std::string stringForSegments(const struct iovec *segments, size_t count) {
+    std::string string;
+    for (size_t i = 0; i < count; ++i) {
+        string.append(static_cast<const char *>(segments[i].iov_base), segments[i].iov_len);
+    }
+    return string;
+}
+
+static void *readAll(void *argument) {
+    std::pair<int, std::string *> *reader = static_cast<std::pair<int, std::string *> *>(argument);
+    char buf[4096];
+    ssize_t length;
+    while (((length = read(reader->first, buf, sizeof(buf))) > 0) || ((length < 0) && (errno == EINTR))) {
+        if (length > 0) {
+            reader->second->append(buf, length);
+            // NOTE: Reading slowly keeps the pipe full, so that most writes
+            //       are partial.
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+// NOTE: Writes to a non-blocking pipe, which only accepts as much as it has
+//       room for, and so returns short counts.
+static std::string writeThroughPipe(const struct iovec *segments, size_t count, BOOL *succeeded) {
+    std::string output;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        *succeeded = NO;
+        return output;
+    }
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+    std::pair<int, std::string *> reader(fds[0], &output);
+    pthread_t thread;
+    pthread_create(&thread, NULL, readAll, &reader);
+    *succeeded = writeSegments(fds[1], segments, count);
+    close(fds[1]);
+    pthread_join(thread, NULL);
+    close(fds[0]);
+    return output;
+}
+
+static void testReplace() {
+    const std::string log = "0   A  0x1 0x0 + 1\n1   B  0x2 ???\n";
+    const char *data = log.data();
+    SCLogWriter writer(data, log.size());
+
+    const char *first = data + log.find("0x0 + 1");
+    CHECK(writer.replace(first, first + 7, "main + 4", 8));
+    const char *second = data + log.find("???");
+    CHECK(writer.replace(second, second + 3, "foo", 3));
+    // NOTE: Ranges must be given in order.
+    CHECK(!writer.replace(first, first, "x", 1));
+    // NOTE: An empty range inserts the text.
+    CHECK(writer.replace(second + 3, second + 3, " (bar)", 6));
+
+    const std::string expected = "0   A  0x1 main + 4\n1   B  0x2 foo (bar)\n";
+    CHECK(stringForSegments(writer.segments(), writer.segmentCount()) == expected);
+    CHECK(writer.length() == expected.size());
+
+    // NOTE: No more ranges can be replaced once the segments are used.
+    CHECK(!writer.replace(data + log.size(), data + log.size(), "x", 1));
+}
+
+static void testWriteLargeSegment() {
+    // NOTE: Larger than the buffer of a pipe, and so written in parts.
+    std::string data(1 << 20, '\0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (char)(i * 7);
+    }
+    struct iovec segment;
+    segment.iov_base = &data[0];
+    segment.iov_len = data.size();
+
+    BOOL succeeded;
+    const std::string output = writeThroughPipe(&segment, 1, &succeeded);
+    CHECK(succeeded);
+    CHECK(output == data);
+}
+
+static void testWriteManySegments() {
+    // NOTE: More segments than writev() accepts at once, of varying lengths,
+    //       so that partial writes end both within and between segments.
+    std::string data;
+    for (unsigned i = 0; data.size() < (1 << 20); ++i) {
+        data.append(1 + ((i * 37) % 997), (char)('a' + (i % 26)));
+    }
+    std::vector<struct iovec> segments;
+    for (size_t offset = 0, i = 0; offset < data.size(); ++i) {
+        struct iovec segment;
+        segment.iov_base = &data[offset];
+        segment.iov_len = std::min((size_t)(1 + ((i * 13) % 701)), data.size() - offset);
+        segments.push_back(segment);
+        offset += segment.iov_len;
+    }
+    CHECK(segments.size() > (2 * IOV_MAX));
+
+    BOOL succeeded;
+    const std::string output = writeThroughPipe(&segments[0], segments.size(), &succeeded);
+    CHECK(succeeded);
+    CHECK(output == data);
+}
+
+int main() {
+    testReplace();
+    testWriteLargeSegment();
+    testWriteManySegments();
+    return finish("logWriter");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
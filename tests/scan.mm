@@ -0,0 +1,202 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#include "test.h"
+#include "scan.h"
+
+#include <mach-o/nlist.h>
+#include <stdint.h>
+
+#include <vector>
+
+// NOTE: A fixed sequence, so that failures can be reproduced.
+static uint64_t nextRandom(uint64_t *state) {
+    *state = (*state * 6364136223846793005ULL) + 1442695040888963407ULL;
+    return *state ^ (*state >> 29);
+}
+
+#pragma mark - Symbol Tables
+
+// NOTE: The scans are compared against a plain loop over the entries. Counts
+//       cover every remainder of the vector width (two or four entries), so
+//       that the scalar tail is exercised.
+
+template <typename NList>
+static uint32_t expectedIndex(const std::vector<NList> &nlists, uint64_t value) {
+    for (uint32_t i = 0; i < nlists.size(); ++i) {
+        if (nlists[i].n_value == value) {
+            return i;
+        }
+    }
+    return nlists.size();
+}
+
+template <typename NList>
+static void checkScan(const std::vector<NList> &nlists, BOOL is64Bit, uint64_t value) {
+    const uint8_t *data = nlists.empty() ? NULL : reinterpret_cast<const uint8_t *>(&nlists[0]);
+    CHECK(indexOfNlistWithValue(data, nlists.size(), is64Bit, value) == expectedIndex(nlists, value));
+}
+
+// NOTE: Other fields are filled with the value being searched for, so that a
+//       scan that compares the wrong words is caught.
+template <typename NList>
+static void fillNlists(std::vector<NList> &nlists, uint32_t count, uint64_t decoy) {
+    nlists.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        memset(&nlists[i], 0, sizeof(NList));
+        nlists[i].n_un.n_strx = (uint32_t)decoy;
+        nlists[i].n_desc = (uint16_t)decoy;
+        nlists[i].n_value = 0x1000 + (i * 0x10);
+    }
+}
+
+template <typename NList>
+static void testNlists(BOOL is64Bit) {
+    const uint64_t decoy = 0x5000;
+    std::vector<NList> nlists;
+    for (uint32_t count = 0; count <= 19; ++count) {
+        fillNlists(nlists, count, decoy);
+
+        // Every entry, plus values that are not present.
+        for (uint32_t i = 0; i < count; ++i) {
+            checkScan(nlists, is64Bit, nlists[i].n_value);
+        }
+        checkScan(nlists, is64Bit, 0);
+        checkScan(nlists, is64Bit, decoy);
+        checkScan(nlists, is64Bit, 0x1008);
+
+        // Repeated values must give the first entry, including when the
+        // repeats share a vector.
+        if (count >= 3) {
+            nlists[count - 1].n_value = nlists[count - 3].n_value;
+            nlists[count - 2].n_value = nlists[count - 3].n_value;
+            checkScan(nlists, is64Bit, nlists[count - 1].n_value);
+        }
+    }
+}
+
+// NOTE: For 64-bit entries, both halves of the value must match.
+static void testNlistHalves() {
+    std::vector<struct nlist_64> nlists;
+    for (uint32_t count = 1; count <= 9; ++count) {
+        fillNlists(nlists, count, 0);
+        const uint32_t last = count - 1;
+        nlists[last].n_value = 0x100000000ULL | 0x2000;
+
+        checkScan(nlists, YES, 0x100000000ULL | 0x2000);
+        checkScan(nlists, YES, 0x2000);
+        checkScan(nlists, YES, 0x200000000ULL | 0x2000);
+        checkScan(nlists, YES, 0x100000000ULL);
+    }
+
+    // NOTE: A 32-bit entry cannot hold a value wider than 32 bits.
+    std::vector<struct nlist> nlists32;
+    fillNlists(nlists32, 8, 0);
+    checkScan(nlists32, NO, 0x100000000ULL | 0x1000);
+}
+
+static void testNlistsRandom() {
+    uint64_t state = 1;
+    std::vector<struct nlist_64> nlists;
+    std::vector<struct nlist> nlists32;
+    for (uint32_t round = 0; round < 64; ++round) {
+        const uint32_t count = nextRandom(&state) % 200;
+        fillNlists(nlists, count, 0);
+        fillNlists(nlists32, count, 0);
+        for (uint32_t i = 0; i < count; ++i) {
+            // NOTE: A small range, so that there are repeats.
+            nlists[i].n_value = nextRandom(&state) % 64;
+            nlists32[i].n_value = nlists[i].n_value;
+        }
+        for (uint64_t value = 0; value < 68; ++value) {
+            checkScan(nlists, YES, value);
+            checkScan(nlists32, NO, value);
+        }
+    }
+}
+
+#pragma mark - Function Starts
+
+static void appendULEB128(std::vector<uint8_t> &data, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        data.push_back(byte);
+    } while (value != 0);
+}
+
+// NOTE: The data is decoded in full, one delta at a time.
+static BOOL expectedFunctionStart(const std::vector<uint64_t> &starts, uint64_t address, uint64_t *start) {
+    BOOL isFound = NO;
+    for (size_t i = 0; (i < starts.size()) && (starts[i] <= address); ++i) {
+        *start = starts[i];
+        isFound = YES;
+    }
+    return isFound;
+}
+
+static void checkFunctionStart(const std::vector<uint8_t> &data, const std::vector<uint64_t> &starts,
+        uint64_t baseAddress, BOOL isThumb, uint64_t address) {
+    uint64_t expected = 0;
+    uint64_t start = 0;
+    const BOOL isFound = functionStartForAddress(data.empty() ? NULL : &data[0], data.size(), baseAddress, isThumb, address, &start);
+    CHECK(isFound == expectedFunctionStart(starts, address, &expected));
+    if (isFound) {
+        CHECK(start == expected);
+    }
+}
+
+// NOTE: Runs of small deltas are taken sixteen bytes at a time; larger deltas,
+//       and the runs around them, are mixed in so that blocks are both taken
+//       and rejected.
+static void testFunctionStarts() {
+    uint64_t state = 2;
+    for (uint32_t round = 0; round < 64; ++round) {
+        const BOOL isThumb = (round % 2) != 0;
+        const uint64_t baseAddress = 0x4000;
+        std::vector<uint8_t> data;
+        std::vector<uint64_t> starts;
+        uint64_t address = baseAddress;
+        const uint32_t count = nextRandom(&state) % 100;
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint64_t r = nextRandom(&state);
+            const uint64_t delta = ((r % 8) == 0) ? (0x80 + (r % 0x10000)) : (1 + (r % 0x7f));
+            appendULEB128(data, delta);
+            address += delta;
+            starts.push_back(isThumb ? (address & ~1ULL) : address);
+        }
+        if ((round % 4) < 2) {
+            // NOTE: The list is normally terminated by a zero delta and padded.
+            data.push_back(0);
+            data.resize(data.size() + (round % 16), 0);
+        }
+
+        checkFunctionStart(data, starts, baseAddress, isThumb, 0);
+        checkFunctionStart(data, starts, baseAddress, isThumb, UINT64_MAX);
+        for (size_t i = 0; i < starts.size(); ++i) {
+            checkFunctionStart(data, starts, baseAddress, isThumb, starts[i] - 1);
+            checkFunctionStart(data, starts, baseAddress, isThumb, starts[i]);
+            checkFunctionStart(data, starts, baseAddress, isThumb, starts[i] + 1);
+        }
+    }
+}
+
+int main() {
+    testNlists<struct nlist_64>(YES);
+    testNlists<struct nlist>(NO);
+    testNlistHalves();
+    testNlistsRandom();
+    testFunctionStarts();
+    return finish("scan");
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
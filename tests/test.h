@@ -0,0 +1,64 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+#ifndef SYMBOLICATE_TEST_H_
+#define SYMBOLICATE_TEST_H_
+
+#include <stdio.h>
+#include <string.h>
+
+// NOTE: The tests are built as plain C++ (see Makefile); the library is
+//       otherwise built as Objective-C++, which defines these.
+#ifndef __OBJC__
+typedef signed char BOOL;
+#define YES ((BOOL)1)
+#define NO ((BOOL)0)
+#endif
+
+#ifdef __cplusplus
+
+#include <string>
+
+static inline int *failureCount() {
+    static int count = 0;
+    return &count;
+}
+
+// NOTE: A failed check is reported, and the test continues.
+static inline void check(bool condition, const char *expression, const char *file, int line) {
+    if (!condition) {
+        fprintf(stderr, "%s:%d: FAILED: %s\n", file, line, expression);
+        ++*failureCount();
+    }
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+// NOTE: For comparing views (e.g. SCStringView) with C strings.
+template <typename T>
+static inline bool isEqual(const T &view, const char *string) {
+    return (view.length == strlen(string)) && (memcmp(view.data, string, view.length) == 0);
+}
+
+// NOTE: Returns the exit status of the test.
+static inline int finish(const char *name) {
+    const int failures = *failureCount();
+    if (failures != 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif // __cplusplus
+
+#endif // SYMBOLICATE_TEST_H_
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */
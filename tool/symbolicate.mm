@@ -0,0 +1,687 @@
+/**
+ * Name: libsymbolicate
+ * Type: iOS/OS X shared library
+ * Desc: Library for symbolicating memory addresses.
+ *
+ * Author: Lance Fetters (aka. ashikase)
+ * License: LGPL v3 (See LICENSE file for details)
+ */
+
+// NOTE: Symbolicates crash logs in bulk, in both the text (.crash) and JSON
+//       (.ips) formats. Each text log is written to stdout with the symbols of
+//       its frames rewritten; for JSON logs, the symbolicated backtraces are
+//       written. Older .ips logs, which have a text body following the JSON
+//       header line, are handled as text logs. Throughput statistics are
+//       written to stderr.
+// NOTE: Logs are symbolicated in parallel. All logs of an architecture share
+//       one symbolication context, and so one cache of results; parsed binary
+//       state is shared by all logs (see registry.h).
+// NOTE: Duplicate logs (see fingerprint.h) are not symbolicated again.
+
+#import <Foundation/Foundation.h>
+
+#import "SCBinaryInfo.h"
+#import "SCCrashReport.h"
+#import "SCSymbolInfo.h"
+#import "SCSymbolicationContext.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <mach/mach_time.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "crashReport.h"
+#include "fingerprint.h"
+#include "input.h"
+#include "ipsReport.h"
+#include "logWriter.h"
+#include "prefetch.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// NOTE: The output of a log: a header, followed by either the rewritten log
+//       (text logs) or rendered text (JSON logs). The former refers to the
+//       mapping of the log, which is kept until the output has been written.
+class SCLogOutput {
+    public:
+        SCLogOutput() : writer(NULL), input(NULL), data(NULL), length(0) {}
+        ~SCLogOutput() {
+            delete writer;
+            if (input != NULL) {
+                if (data != NULL) {
+                    input->unmap(data, 0, length);
+                }
+                input->release();
+            }
+        }
+
+        BOOL write(int fd) {
+            std::vector<struct iovec> segments;
+            struct iovec segment;
+            segment.iov_base = const_cast<char *>(text.data());
+            segment.iov_len = text.size();
+            segments.push_back(segment);
+            if (writer != NULL) {
+                segments.insert(segments.end(), writer->segments(), writer->segments() + writer->segmentCount());
+                segment.iov_base = const_cast<char *>("\n");
+                segment.iov_len = 1;
+                segments.push_back(segment);
+            }
+            return writeSegments(fd, &segments[0], segments.size());
+        }
+
+        std::string text;
+        std::string symbols;
+        SCLogWriter *writer;
+        SCInput *input;
+        const uint8_t *data;
+        size_t length;
+
+    private:
+        SCLogOutput(const SCLogOutput &);
+        SCLogOutput &operator=(const SCLogOutput &);
+};
+
+static NSString *systemRoot = nil;
+static NSMutableDictionary *contexts = nil;
+
+static BOOL isQuiet = NO;
+static BOOL isOrdered = YES;
+static BOOL isCrashedThreadOnly = NO;
+
+// NOTE: NULL if duplicate logs are not to be detected.
+static SCFingerprintCache *fingerprintCache = NULL;
+
+static pthread_mutex_t outputMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<size_t, SCLogOutput *> pendingOutputs;
+static size_t nextOutput = 0;
+static dispatch_semaphore_t outputWindow = NULL;
+
+static volatile int64_t numLogs = 0;
+static volatile int64_t numFailedLogs = 0;
+static volatile int64_t numDuplicateLogs = 0;
+static volatile int64_t numFrames = 0;
+static volatile int64_t numSymbolicatedFrames = 0;
+
+#pragma mark - Helpers
+
+static void appendFormat(std::string &string, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void appendFormat(std::string &string, const char *format, ...) {
+    char buf[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (length >= (int)sizeof(buf)) {
+        std::vector<char> large(length + 1);
+        va_start(args, format);
+        vsnprintf(&large[0], large.size(), format, args);
+        va_end(args);
+        string.append(&large[0], length);
+    } else if (length > 0) {
+        string.append(buf, length);
+    }
+}
+
+static SCSymbolicationContext *contextForArchitecture(NSString *architecture) {
+    @synchronized(contexts) {
+        NSString *key = architecture ?: @"";
+        SCSymbolicationContext *context = [contexts objectForKey:key];
+        if (context == nil) {
+            context = [[SCSymbolicationContext alloc] initWithArchitecture:architecture systemRoot:systemRoot symbolMaps:nil];
+            [contexts setObject:context forKey:key];
+            [context release];
+        }
+        return context;
+    }
+}
+
+// NOTE: Returns NO if there is no result, in which case nothing is appended.
+static BOOL appendResult(std::string &output, const SCSymbolResult &result) {
+    if (result.name == NULL) {
+        return NO;
+    }
+    appendFormat(output, "%s + %llu", result.name, (unsigned long long)result.offset);
+    if (result.sourcePath != NULL) {
+        const char *fileName = strrchr(result.sourcePath, '/');
+        appendFormat(output, " (%s:%u)", (fileName != NULL) ? (fileName + 1) : result.sourcePath, result.sourceLineNumber);
+    }
+    return YES;
+}
+
+#pragma mark - Backtraces
+
+static const uint32_t kNoImage = SCCrashImageRanges::kNoImage;
+
+typedef struct _SCLogImage {
+    uint64_t address;
+    SCStringView path;
+    SCStringView architecture;
+    SCStringView uuid;
+} SCLogImage;
+
+typedef struct _SCLogFrame {
+    int threadIndex;
+    uint64_t address;
+    // NOTE: kNoImage if the frame has no known image.
+    uint32_t imageIndex;
+} SCLogFrame;
+
+// NOTE: Appends the symbolicated text of each frame (e.g. "main + 12
+//       (main.m:34)") to the symbols, each terminated by a NUL. The text of a
+//       frame that could not be symbolicated is empty.
+static void symbolicateFrames(const std::vector<SCLogImage> &images, const std::vector<SCLogFrame> &frames, std::string &symbols) {
+    const size_t count = frames.size();
+    if (count == 0) {
+        return;
+    }
+
+    std::vector<SCBinaryInfo *> imageBinaryInfos(images.size(), nil);
+    NSString *architecture = nil;
+    for (size_t i = 0; i < images.size(); ++i) {
+        const SCLogImage &image = images[i];
+        imageBinaryInfos[i] = SCBinaryInfoCreateForReportImage(image.path, image.address, image.architecture, image.uuid);
+        if ((architecture == nil) && (imageBinaryInfos[i] != nil)) {
+            // NOTE: The first image is that of the process.
+            architecture = [imageBinaryInfos[i] architecture];
+        }
+    }
+
+    std::vector<uint64_t> addresses(count);
+    std::vector<SCBinaryInfo *> binaryInfos(count);
+    for (size_t i = 0; i < count; ++i) {
+        const SCLogFrame &frame = frames[i];
+        addresses[i] = frame.address;
+        binaryInfos[i] = (frame.imageIndex < images.size()) ? imageBinaryInfos[frame.imageIndex] : nil;
+    }
+
+    std::vector<SCSymbolResult> results(count);
+    SCSymbolicationContext *context = contextForArchitecture(architecture);
+    [context getResults:&results[0] forAddresses:&addresses[0] inBinaries:&binaryInfos[0] count:count];
+    for (size_t i = 0; i < count; ++i) {
+        appendResult(symbols, results[i]);
+        symbols += '\0';
+    }
+
+    // NOTE: The binaries own the strings of the results, and so must only be
+    //       released once the results have been copied.
+    for (std::vector<SCBinaryInfo *>::iterator i = imageBinaryInfos.begin(); i != imageBinaryInfos.end(); ++i) {
+        [*i release];
+    }
+}
+
+// NOTE: Most logs are duplicates of earlier ones. The symbols of a duplicate
+//       are copied from those of the first log with the same fingerprint,
+//       without creating any binary info objects.
+// NOTE: Returns NO if the log is not a duplicate, in which case the
+//       fingerprint is that of the log (see getSymbols()).
+static BOOL getDuplicateSymbols(const std::vector<SCLogImage> &images, const std::vector<SCLogFrame> &frames, SCBacktraceFingerprint &fingerprint, std::string &symbols) {
+    if (fingerprintCache == NULL) {
+        return NO;
+    }
+
+    for (std::vector<SCLogFrame>::const_iterator frame = frames.begin(); frame != frames.end(); ++frame) {
+        if ((frame == frames.begin()) || (frame->threadIndex != (frame - 1)->threadIndex)) {
+            fingerprint.addBacktrace(frame->threadIndex);
+        }
+        if (frame->imageIndex < images.size()) {
+            const SCLogImage &image = images[frame->imageIndex];
+            fingerprint.addFrame(image.uuid, image.address, frame->address);
+        } else {
+            fingerprint.addFrame(frame->address);
+        }
+    }
+
+    if (fingerprintCache->lookup(fingerprint, symbols)) {
+        __sync_add_and_fetch(&numDuplicateLogs, 1);
+        return YES;
+    }
+    return NO;
+}
+
+// NOTE: Binaries are first allowed to finish warming up, so that the work is
+//       not repeated. The fingerprint is as set by getDuplicateSymbols().
+static void getSymbols(const std::vector<SCLogImage> &images, const std::vector<SCLogFrame> &frames, const SCBacktraceFingerprint &fingerprint, SCBinaryPrefetcher &prefetcher, std::string &symbols) {
+    prefetcher.wait();
+    symbolicateFrames(images, frames, symbols);
+    if (fingerprintCache != NULL) {
+        fingerprintCache->insert(fingerprint, symbols);
+    }
+}
+
+static void prefetchImage(SCBinaryPrefetcher &prefetcher, const SCLogImage &image, size_t frameCount) {
+    SCBinaryInfo *binaryInfo = SCBinaryInfoCreateForReportImage(image.path, image.address, image.architecture, image.uuid);
+    prefetcher.prefetch(binaryInfo, frameCount);
+    [binaryInfo release];
+}
+
+// NOTE: Returns the symbol text of the next frame and advances past it.
+static const char *nextSymbol(const char **symbols) {
+    const char *symbol = *symbols;
+    *symbols += strlen(symbol) + 1;
+    return symbol;
+}
+
+static BOOL isIncludedThread(int index, BOOL isCrashed) {
+    return !isCrashedThreadOnly || isCrashed || (index < 0);
+}
+
+static void appendThreadHeader(std::string &output, int index, BOOL isCrashed, const SCStringView &name) {
+    if (index < 0) {
+        output += "\nLast Exception Backtrace:\n";
+    } else {
+        if (name.length != 0) {
+            appendFormat(output, "\nThread %d name:  %.*s", index, (int)name.length, name.data);
+        }
+        appendFormat(output, "\nThread %d%s:\n", index, isCrashed ? " Crashed" : "");
+    }
+}
+
+#pragma mark - Text Logs
+
+// NOTE: Binary images are listed at the end of a log, and so the frames are
+//       kept until the whole log has been parsed. Each image that the frames
+//       refer to is warmed up as soon as it has been parsed.
+// NOTE: The output is the log itself, with the symbol of each frame replaced
+//       (see SCLogWriter). Frames of exception backtraces that are given as a
+//       list of addresses are symbolicated, but cannot be rewritten.
+// NOTE: Only the body is parsed; anything before it (e.g. the header line of
+//       an .ips report) is written unchanged.
+static BOOL symbolicateTextLog(const char *data, size_t length, const char *body, SCLogOutput &output) {
+    std::vector<SCCrashFrame> crashFrames;
+    std::vector<SCLogImage> images;
+    SCCrashImageRanges ranges;
+    BOOL isIncluded = YES;
+    SCBinaryPrefetcher prefetcher;
+
+    SCCrashReportParser parser(body, (data + length) - body);
+    SCCrashEvent event;
+    while (parser.next(&event)) {
+        if (event.type == SCCrashEventBinaryImage) {
+            const SCCrashBinaryImage &binaryImage = event.binaryImage;
+            SCLogImage image = {binaryImage.address, binaryImage.path, binaryImage.architecture, binaryImage.uuid};
+            ranges.addImage(binaryImage.address, binaryImage.endAddress, images.size());
+            images.push_back(image);
+
+            const size_t frameCount = prefetcher.frameCountInRange(binaryImage.address, binaryImage.endAddress);
+            if (frameCount != 0) {
+                prefetchImage(prefetcher, image, frameCount);
+            }
+        } else if (event.type == SCCrashEventThread) {
+            isIncluded = isIncludedThread(event.thread.index, event.thread.isCrashed);
+        } else if ((event.type == SCCrashEventFrame) && isIncluded) {
+            crashFrames.push_back(event.frame);
+            prefetcher.addFrame(event.frame.address);
+        }
+    }
+    if (images.empty()) {
+        return NO;
+    }
+
+    std::vector<SCLogFrame> frames;
+    frames.reserve(crashFrames.size());
+    for (std::vector<SCCrashFrame>::const_iterator i = crashFrames.begin(); i != crashFrames.end(); ++i) {
+        SCLogFrame frame = {i->threadIndex, i->address, ranges.imageIndexForAddress(i->address)};
+        frames.push_back(frame);
+    }
+
+    // NOTE: The images of a duplicate have already been handed to the
+    //       prefetcher, but are not waited for.
+    // NOTE: The replacement text refers to the symbols, which must not be
+    //       modified from here on.
+    SCBacktraceFingerprint fingerprint;
+    if (!getDuplicateSymbols(images, frames, fingerprint, output.symbols)) {
+        getSymbols(images, frames, fingerprint, prefetcher, output.symbols);
+    }
+
+    output.writer = new SCLogWriter(data, length);
+    const char *symbol = output.symbols.data();
+    int64_t numSymbolicated = 0;
+    for (std::vector<SCCrashFrame>::const_iterator i = crashFrames.begin(); i != crashFrames.end(); ++i) {
+        const char *text = nextSymbol(&symbol);
+        if (*text != '\0') {
+            const SCStringView &range = i->symbol;
+            if (range.data != NULL) {
+                // NOTE: A frame without a symbol ends with its address; the
+                //       name must be separated from it.
+                if ((range.length == 0) && !isspace((unsigned char)range.data[-1])) {
+                    output.writer->replace(range.data, range.data, " ", 1);
+                }
+                output.writer->replace(range.data, range.data + range.length, text, strlen(text));
+            }
+            ++numSymbolicated;
+        }
+    }
+
+    __sync_add_and_fetch(&numFrames, (int64_t)frames.size());
+    __sync_add_and_fetch(&numSymbolicatedFrames, numSymbolicated);
+    return YES;
+}
+
+#pragma mark - JSON Logs
+
+static BOOL symbolicateJSONLog(const char *data, size_t length, std::string &output) {
+    SCIPSReport report;
+    if (!report.parse(data, length)) {
+        return NO;
+    }
+
+    const std::vector<SCIPSImage> &reportImages = report.images();
+    std::vector<SCLogImage> images(reportImages.size());
+    for (size_t i = 0; i < reportImages.size(); ++i) {
+        const SCIPSImage &reportImage = reportImages[i];
+        SCLogImage image = {reportImage.address, reportImage.path, reportImage.architecture, reportImage.uuid};
+        images[i] = image;
+    }
+
+    const std::vector<SCIPSThread> &threads = report.threads();
+    const std::vector<SCIPSFrame> &reportFrames = report.frames();
+    std::vector<SCLogFrame> frames;
+    for (std::vector<SCIPSThread>::const_iterator thread = threads.begin(); thread != threads.end(); ++thread) {
+        if (isIncludedThread(thread->index, thread->isCrashed)) {
+            for (uint32_t i = 0; i < thread->frameCount; ++i) {
+                const SCIPSFrame &reportFrame = reportFrames[thread->firstFrame + i];
+                SCLogFrame frame = {thread->index, report.addressForFrame(reportFrame),
+                    (reportFrame.imageIndex < images.size()) ? reportFrame.imageIndex : kNoImage};
+                frames.push_back(frame);
+            }
+        }
+    }
+
+    // NOTE: The report is parsed as a whole, and so the log is checked for
+    //       being a duplicate before any images are warmed up; the images of
+    //       a log that is not are then warmed up together.
+    std::string symbols;
+    SCBacktraceFingerprint fingerprint;
+    if (!getDuplicateSymbols(images, frames, fingerprint, symbols)) {
+        SCBinaryPrefetcher prefetcher;
+        std::vector<size_t> frameCounts(images.size(), 0);
+        for (std::vector<SCLogFrame>::const_iterator frame = frames.begin(); frame != frames.end(); ++frame) {
+            if (frame->imageIndex != kNoImage) {
+                ++frameCounts[frame->imageIndex];
+            }
+        }
+        for (size_t i = 0; i < images.size(); ++i) {
+            if (frameCounts[i] != 0) {
+                prefetchImage(prefetcher, images[i], frameCounts[i]);
+            }
+        }
+        getSymbols(images, frames, fingerprint, prefetcher, symbols);
+    }
+
+    const char *symbol = symbols.data();
+    std::vector<SCLogFrame>::const_iterator frame = frames.begin();
+    int64_t numSymbolicated = 0;
+    for (std::vector<SCIPSThread>::const_iterator thread = threads.begin(); thread != threads.end(); ++thread) {
+        if (!isIncludedThread(thread->index, thread->isCrashed)) {
+            continue;
+        }
+
+        appendThreadHeader(output, thread->index, thread->isCrashed, (thread->name.length != 0) ? thread->name : thread->queue);
+        for (uint32_t i = 0; i < thread->frameCount; ++i, ++frame) {
+            const SCIPSFrame &reportFrame = reportFrames[thread->firstFrame + i];
+            SCStringView imageName = {"???", 3};
+            if (frame->imageIndex != kNoImage) {
+                imageName = reportImages[frame->imageIndex].name;
+            }
+            appendFormat(output, "%-4u%-31.*s 0x%016llx ", i, (int)imageName.length, imageName.data, (unsigned long long)frame->address);
+            const char *text = nextSymbol(&symbol);
+            if (*text != '\0') {
+                output += text;
+                ++numSymbolicated;
+            } else if (frame->imageIndex != kNoImage) {
+                appendFormat(output, "0x%llx + %llu", (unsigned long long)images[frame->imageIndex].address, (unsigned long long)reportFrame.imageOffset);
+            }
+            output += '\n';
+        }
+    }
+
+    __sync_add_and_fetch(&numFrames, (int64_t)frames.size());
+    __sync_add_and_fetch(&numSymbolicatedFrames, numSymbolicated);
+    return YES;
+}
+
+#pragma mark - Logs
+
+static void symbolicateLog(const char *path, SCLogOutput &output) {
+    BOOL succeeded = NO;
+
+    output.input = SCInputCreateWithPath(path);
+    if (output.input != NULL) {
+        output.length = output.input->size();
+        output.data = (output.length != 0) ? output.input->map(0, output.length) : NULL;
+        if (output.data != NULL) {
+            appendFormat(output.text, "==> %s <==\n", path);
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            const char *text = reinterpret_cast<const char *>(output.data);
+            const char *body;
+            BOOL isJSON;
+            if (!findIPSReportBody(text, output.length, &body, &isJSON)) {
+                succeeded = symbolicateTextLog(text, output.length, text, output);
+            } else if (isJSON) {
+                succeeded = symbolicateJSONLog(text, output.length, output.text);
+                output.text += '\n';
+            } else {
+                succeeded = symbolicateTextLog(text, output.length, body, output);
+            }
+            [pool drain];
+        }
+    }
+
+    if (!succeeded) {
+        fprintf(stderr, "ERROR: Failed to symbolicate log: %s\n", path);
+        __sync_add_and_fetch(&numFailedLogs, 1);
+        output.text.clear();
+        delete output.writer;
+        output.writer = NULL;
+    }
+    __sync_add_and_fetch(&numLogs, 1);
+}
+
+// NOTE: In ordered mode, outputs are held until those of all preceding logs
+//       have been written. Each held output takes up a slot of the output
+//       window, which bounds the memory (and mappings) used if one log is
+//       slow.
+static void writeOutput(size_t index, SCLogOutput *output) {
+    pthread_mutex_lock(&outputMutex);
+    if (isOrdered) {
+        pendingOutputs[index] = output;
+        std::map<size_t, SCLogOutput *>::iterator i;
+        while ((i = pendingOutputs.find(nextOutput)) != pendingOutputs.end()) {
+            if (!isQuiet) {
+                i->second->write(STDOUT_FILENO);
+            }
+            delete i->second;
+            pendingOutputs.erase(i);
+            ++nextOutput;
+            dispatch_semaphore_signal(outputWindow);
+        }
+    } else {
+        if (!isQuiet) {
+            output->write(STDOUT_FILENO);
+        }
+        delete output;
+    }
+    pthread_mutex_unlock(&outputMutex);
+}
+
+static void submitLog(NSString *path, size_t index, dispatch_group_t group, dispatch_semaphore_t workers) {
+    dispatch_semaphore_wait(workers, DISPATCH_TIME_FOREVER);
+    if (isOrdered) {
+        dispatch_semaphore_wait(outputWindow, DISPATCH_TIME_FOREVER);
+    }
+
+    path = [path copy];
+    dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        SCLogOutput *output = new SCLogOutput();
+        symbolicateLog([path fileSystemRepresentation], *output);
+        [path release];
+        dispatch_semaphore_signal(workers);
+        writeOutput(index, output);
+    });
+}
+
+static BOOL isLogPath(NSString *path) {
+    NSString *extension = [path pathExtension];
+    return [extension isEqualToString:@"crash"] || [extension isEqualToString:@"ips"];
+}
+
+static double secondsSince(uint64_t start) {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return (double)(mach_absolute_time() - start) * timebase.numer / timebase.denom / 1000000000.0;
+}
+
+static void printUsage(const char *name) {
+    fprintf(stderr,
+        "Usage: %s [-j jobs] [-r system-root] [-c] [-d megabytes] [-u] [-q] <path>...\n"
+        "\n"
+        "Symbolicates crash logs (.crash and .ips). Each path may be a log, a\n"
+        "directory to search for logs, or \"-\" to read paths of logs from stdin,\n"
+        "one per line.\n"
+        "\n"
+        "    -j jobs         Number of logs to symbolicate at once (default: number\n"
+        "                    of processors).\n"
+        "    -r system-root  Root of the file system of the device (default: \"/\").\n"
+        "    -c              Only symbolicate the crashed thread and the exception\n"
+        "                    backtrace.\n"
+        "    -d megabytes    Size of the cache of symbols of recent logs, used for\n"
+        "                    duplicate logs (default: 64; 0 to disable).\n"
+        "    -u              Write logs in the order that they finish, rather than\n"
+        "                    the order that they were given in.\n"
+        "    -q              Do not write logs; only report statistics.\n",
+        name);
+}
+
+#pragma mark - Main
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+    long numJobs = [[NSProcessInfo processInfo] activeProcessorCount];
+    long fingerprintCacheSize = 64;
+    int c;
+    while ((c = getopt(argc, argv, "j:r:cd:uqh")) != -1) {
+        switch (c) {
+            case 'j':
+                numJobs = strtol(optarg, NULL, 0);
+                break;
+            case 'r':
+                systemRoot = [[NSString alloc] initWithUTF8String:optarg];
+                break;
+            case 'c':
+                isCrashedThreadOnly = YES;
+                break;
+            case 'd':
+                fingerprintCacheSize = strtol(optarg, NULL, 0);
+                break;
+            case 'u':
+                isOrdered = NO;
+                break;
+            case 'q':
+                isQuiet = YES;
+                break;
+            default:
+                printUsage(argv[0]);
+                [pool drain];
+                return (c == 'h') ? 0 : 1;
+        }
+    }
+    if ((optind >= argc) || (numJobs <= 0) || (fingerprintCacheSize < 0)) {
+        printUsage(argv[0]);
+        [pool drain];
+        return 1;
+    }
+
+    contexts = [[NSMutableDictionary alloc] init];
+    if (fingerprintCacheSize != 0) {
+        fingerprintCache = SCFingerprintCache::create(fingerprintCacheSize * 1024 * 1024);
+    }
+    outputWindow = dispatch_semaphore_create(4 * numJobs);
+    dispatch_semaphore_t workers = dispatch_semaphore_create(numJobs);
+    dispatch_group_t group = dispatch_group_create();
+
+    const uint64_t start = mach_absolute_time();
+    size_t index = 0;
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    for (int i = optind; i < argc; ++i) {
+        if (strcmp(argv[i], "-") == 0) {
+            char line[PATH_MAX + 1];
+            while (fgets(line, sizeof(line), stdin) != NULL) {
+                size_t length = strlen(line);
+                while ((length != 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r'))) {
+                    line[--length] = '\0';
+                }
+                if (length != 0) {
+                    NSAutoreleasePool *innerPool = [[NSAutoreleasePool alloc] init];
+                    submitLog([fileManager stringWithFileSystemRepresentation:line length:length], index++, group, workers);
+                    [innerPool drain];
+                }
+            }
+            continue;
+        }
+
+        NSString *path = [fileManager stringWithFileSystemRepresentation:argv[i] length:strlen(argv[i])];
+        BOOL isDirectory;
+        if (![fileManager fileExistsAtPath:path isDirectory:&isDirectory]) {
+            fprintf(stderr, "ERROR: No such file or directory: %s\n", argv[i]);
+            continue;
+        }
+        if (!isDirectory) {
+            submitLog(path, index++, group, workers);
+            continue;
+        }
+
+        NSDirectoryEnumerator *enumerator = [fileManager enumeratorAtPath:path];
+        NSString *subpath;
+        for (;;) {
+            NSAutoreleasePool *innerPool = [[NSAutoreleasePool alloc] init];
+            subpath = [enumerator nextObject];
+            if ((subpath != nil) && isLogPath(subpath)) {
+                submitLog([path stringByAppendingPathComponent:subpath], index++, group, workers);
+            }
+            [innerPool drain];
+            if (subpath == nil) {
+                break;
+            }
+        }
+    }
+
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    fflush(stdout);
+    const double seconds = secondsSince(start);
+
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    for (SCSymbolicationContext *context in [contexts allValues]) {
+        cacheHits += [context cacheHits];
+        cacheMisses += [context cacheMisses];
+    }
+
+    fprintf(stderr, "Symbolicated %lld logs (%lld failed, %lld duplicates) and %lld frames (%lld found) in %.2f s using %ld jobs.\n",
+        numLogs, numFailedLogs, numDuplicateLogs, numFrames, numSymbolicatedFrames, seconds, numJobs);
+    if (seconds > 0.0) {
+        fprintf(stderr, "Throughput: %.1f logs/s, %.1f frames/s.\n", numLogs / seconds, numFrames / seconds);
+    }
+    fprintf(stderr, "Result cache: %llu hits, %llu misses.\n", cacheHits, cacheMisses);
+
+    dispatch_release(group);
+    dispatch_release(workers);
+    dispatch_release(outputWindow);
+    if (fingerprintCache != NULL) {
+        fingerprintCache->release();
+    }
+    [contexts release];
+    [systemRoot release];
+    [pool drain];
+
+    return (numFailedLogs == 0) ? 0 : 1;
+}
+
+/* vim: set ft=objcpp ff=unix sw=4 ts=4 tw=80 expandtab: */